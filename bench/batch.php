@@ -0,0 +1,104 @@
+<?php
+
+/**
+ * Counts the io_uring_enter system calls made by a loop whose timer callback
+ * writes to many descriptors per tick, with the writes submitted together at
+ * the end of the callback (the default) and with each write flushed
+ * immediately via Mrloop::flush(). Requires strace.
+ *
+ * usage: php bench/batch.php [--ticks=100] [--connections=1,16,100] [--size=64]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Mrloop;
+
+// child process: writes to the specified number of socket pairs on every tick
+if (($argv[1] ?? null) === 'worker') {
+  [, , $mode, $ticks, $connections, $size] = $argv;
+
+  $loop = Mrloop::init();
+  $message = \str_repeat('x', (int) $size);
+  $pairs = [];
+
+  for ($idx = 0; $idx < (int) $connections; $idx++) {
+    $pairs[] = \stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+  }
+
+  $remaining = (int) $ticks;
+
+  $loop->addPeriodicTimer(
+    0.001,
+    function () use ($loop, $message, $mode, $pairs, &$remaining) {
+      foreach ($pairs as [$writer, $reader]) {
+        $loop->writev($writer, $message);
+
+        if ($mode === 'immediate') {
+          $loop->flush();
+        }
+
+        \fread($reader, \strlen($message));
+      }
+
+      if (--$remaining === 0) {
+        $loop->stop();
+        return 0;
+      }
+    },
+  );
+
+  $loop->run();
+
+  exit(0);
+}
+
+/**
+ * runs a worker under strace and returns the number of io_uring_enter calls it made
+ */
+function count_enters(array $command): int
+{
+  $log = \tempnam(\sys_get_temp_dir(), 'mrloop-strace');
+  $strace = \array_merge(['strace', '-f', '-c', '-e', 'trace=io_uring_enter', '-o', $log], $command);
+
+  $proc = \proc_open($strace, [STDIN, STDOUT, STDERR], $pipes);
+  if (!\is_resource($proc) || \proc_close($proc) !== 0) {
+    throw new \RuntimeException('Could not run worker under strace');
+  }
+
+  $summary = \file_get_contents($log);
+  \unlink($log);
+
+  // strace -c summary rows: % time, seconds, usecs/call, calls, [errors,] syscall
+  return \preg_match('/^\s*[\d.]+\s+[\d.]+\s+\d+\s+(\d+)\s+(?:\d+\s+)?io_uring_enter$/m', $summary, $matches) ? (int) $matches[1] : 0;
+}
+
+$options = bench_options(
+  $argv,
+  [
+    'ticks'       => 100,
+    'connections' => '1,16,100',
+    'size'        => 64,
+  ],
+);
+
+$results = [];
+
+foreach (['immediate', 'batched'] as $mode) {
+  foreach (\explode(',', (string) $options['connections']) as $connections) {
+    $enters = count_enters(
+      bench_command(__FILE__, ['worker', $mode, $options['ticks'], $connections, $options['size']]),
+    );
+    $writes = (int) $options['ticks'] * (int) $connections;
+
+    $results[$mode][] = [
+      'connections'      => (int) $connections,
+      'writes'           => $writes,
+      'io_uring_enter'   => $enters,
+      'enters_per_write' => $enters / $writes,
+    ];
+  }
+}
+
+bench_report('batch', $results);
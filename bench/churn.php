@@ -0,0 +1,145 @@
+<?php
+
+/**
+ * Measures the rate at which the loop turns over short-lived operations, all
+ * of whose records are carved from and returned to the loop's slabs: future
+ * ticks (in a number of concurrent chains), one-shot timers, timers armed
+ * and cancelled before they expire, and 1-byte write/read round trips over
+ * a socket pair. Runs in a single process.
+ *
+ * usage: php bench/churn.php [--operations=1000000] [--chains=1,1000] [--round-trips=100000]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Mrloop;
+
+/**
+ * summarizes a run of the specified number of operations
+ */
+function churn_result(int $operations, array $run, array $extra = []): array
+{
+  [$seconds, $memory] = $run;
+
+  return \array_merge(
+    $extra,
+    [
+      'operations'     => $operations,
+      'seconds'        => $seconds,
+      'ops_per_second' => $operations / $seconds,
+      'peak_memory'    => $memory,
+    ],
+  );
+}
+
+$options = bench_options(
+  $argv,
+  [
+    'operations'  => 1000000,
+    'chains'      => '1,1000',
+    'round-trips' => 100000,
+  ],
+);
+
+$operations = (int) $options['operations'];
+$results = [];
+
+// each tick schedules its successor; concurrent chains keep that many ticks pending at once
+foreach (\explode(',', (string) $options['chains']) as $chains) {
+  $run = bench_loop(
+    function (Mrloop $loop) use ($chains, $operations) {
+      $remaining = $operations;
+
+      $tick = function () use ($loop, &$remaining, &$tick) {
+        if (--$remaining > 0) {
+          $loop->futureTick($tick);
+        } elseif ($remaining === 0) {
+          $loop->stop();
+        }
+      };
+
+      for ($idx = 0; $idx < (int) $chains; $idx++) {
+        $loop->futureTick($tick);
+      }
+    },
+  );
+
+  $results['future_ticks'][] = churn_result($operations, $run, ['chains' => (int) $chains]);
+}
+
+// timers are armed in rounds so as to bound the number pending at once
+$run = bench_loop(
+  function (Mrloop $loop) use ($operations) {
+    $fired = 0;
+    $armed = 0;
+
+    $expire = function () use ($loop, &$fired, $operations) {
+      if (++$fired === $operations) {
+        $loop->stop();
+      }
+    };
+
+    $arm = function () use ($loop, $expire, &$armed, &$arm, $operations) {
+      for ($idx = 0; $idx < 10000 && $armed < $operations; $idx++, $armed++) {
+        $loop->addTimer(0, $expire);
+      }
+
+      if ($armed < $operations) {
+        $loop->futureTick($arm);
+      }
+    };
+
+    $loop->futureTick($arm);
+  },
+);
+
+$results['timers'][] = churn_result($operations, $run);
+
+$run = bench_loop(
+  function (Mrloop $loop) use ($operations) {
+    $noop = function () {};
+
+    for ($idx = 0; $idx < $operations; $idx++) {
+      $loop->addTimer(60, $noop)->cancel();
+    }
+
+    $loop->futureTick(fn () => $loop->stop());
+  },
+);
+
+$results['timer_cancellations'][] = churn_result($operations, $run);
+
+$roundTrips = (int) $options['round-trips'];
+$run = bench_loop(
+  function (Mrloop $loop) use ($roundTrips) {
+    [$writer, $reader] = \stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+    $remaining = $roundTrips;
+
+    $write = function () use ($loop, $reader, $writer, &$remaining, &$write) {
+      $loop->addWriteStream(
+        $writer,
+        'x',
+        null,
+        function () use ($loop, $reader, &$remaining, $write) {
+          $loop->addReadStream(
+            $reader,
+            1,
+            null,
+            null,
+            function () use ($loop, &$remaining, $write) {
+              --$remaining > 0 ? $write() : $loop->stop();
+            },
+          );
+        },
+      );
+    };
+
+    $write();
+  },
+);
+
+$results['write_read_round_trips'][] = churn_result($roundTrips, $run);
+
+bench_report('churn', $results);
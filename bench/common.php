@@ -0,0 +1,358 @@
+<?php
+
+/**
+ * Helpers shared by the benchmark scripts in this directory.
+ *
+ * Benchmarks spawn the server under test in a child process (running the
+ * same PHP binary with the same ini file) and drive it from the parent so
+ * that client and server do not contend for a single event loop. Extra
+ * arguments for the child (e.g. -d extension=modules/mrloop.so) may be
+ * supplied via the BENCH_PHP_ARGS environment variable.
+ */
+
+declare(strict_types=1);
+
+/**
+ * parses --key=value command line options into an array
+ *
+ * @param array $argv
+ * @param array $defaults
+ * @return array
+ */
+function bench_options(array $argv, array $defaults): array
+{
+  $options = $defaults;
+
+  foreach (\array_slice($argv, 1) as $arg) {
+    if (\preg_match('/^--([a-z0-9-]+)=(.*)$/', $arg, $matches)) {
+      $options[$matches[1]] = \is_numeric($matches[2]) ? $matches[2] + 0 : $matches[2];
+    }
+  }
+
+  return $options;
+}
+
+/**
+ * builds the command line that runs a PHP script with the same binary, ini file and BENCH_PHP_ARGS as the current one
+ *
+ * @param string $script
+ * @param array $args
+ * @return array
+ */
+function bench_command(string $script, array $args): array
+{
+  $ini = \php_ini_loaded_file();
+  $extra = \getenv('BENCH_PHP_ARGS');
+
+  return \array_merge(
+    [PHP_BINARY],
+    $ini ? ['-c', $ini] : [],
+    $extra ? \preg_split('/\s+/', \trim($extra)) : [],
+    [$script],
+    \array_map('strval', $args),
+  );
+}
+
+/**
+ * runs a PHP script in a child process and waits until it accepts connections on the specified address
+ *
+ * @param string $script
+ * @param array $args
+ * @param string $address
+ * @param float $timeout
+ * @return resource
+ */
+function bench_spawn(string $script, array $args, string $address, float $timeout = 5.0)
+{
+  $proc = \proc_open(bench_command($script, $args), [STDIN, STDOUT, STDERR], $pipes);
+
+  if (!\is_resource($proc)) {
+    throw new \RuntimeException(\sprintf("Could not start %s", $script));
+  }
+
+  $deadline = \microtime(true) + $timeout;
+
+  while (\microtime(true) < $deadline) {
+    $conn = @\stream_socket_client($address, $errno, $errstr, 0.1);
+
+    if ($conn) {
+      \fclose($conn);
+
+      return $proc;
+    }
+
+    \usleep(10000);
+  }
+
+  bench_stop($proc);
+
+  throw new \RuntimeException(\sprintf("Server at %s did not come up", $address));
+}
+
+/**
+ * terminates a process started with bench_spawn()
+ *
+ * @param resource $proc
+ * @return void
+ */
+function bench_stop($proc): void
+{
+  $status = \proc_get_status($proc);
+
+  if ($status['running']) {
+    \posix_kill($status['pid'], SIGKILL);
+  }
+
+  \proc_close($proc);
+}
+
+/**
+ * computes summary statistics of latency samples (in microseconds)
+ *
+ * @param array $samples
+ * @return array
+ */
+function bench_percentiles(array $samples): array
+{
+  if (empty($samples)) {
+    return ['count' => 0];
+  }
+
+  \sort($samples);
+  $count = \count($samples);
+  $pick = fn (float $pct) => $samples[(int) \min($count - 1, \floor($pct * $count))];
+
+  return [
+    'count' => $count,
+    'min'   => $samples[0],
+    'p50'   => $pick(0.50),
+    'p90'   => $pick(0.90),
+    'p99'   => $pick(0.99),
+    'p999'  => $pick(0.999),
+    'max'   => $samples[$count - 1],
+    'mean'  => \array_sum($samples) / $count,
+  ];
+}
+
+/**
+ * drives a request-response exchange over several connections for a fixed duration
+ *
+ * @param string $address
+ * @param int $connections
+ * @param string $payload
+ * @param float $duration
+ * @param int $expect number of bytes in each response
+ * @param bool $samples whether to include the raw latency samples (for merging with those of other processes)
+ * @return array
+ */
+function bench_pingpong(string $address, int $connections, string $payload, float $duration, int $expect, bool $samples = false): array
+{
+  $clients = [];
+  $sent = [];
+  $received = [];
+  $latencies = [];
+  $requests = 0;
+
+  for ($idx = 0; $idx < $connections; $idx++) {
+    $client = \stream_socket_client($address, $errno, $errstr, 5.0);
+    if (!$client) {
+      throw new \RuntimeException($errstr);
+    }
+
+    \stream_set_blocking($client, false);
+    $clients[$idx] = $client;
+  }
+
+  $start = \hrtime(true);
+  $deadline = $start + (int) ($duration * 1e9);
+
+  foreach ($clients as $idx => $client) {
+    \fwrite($client, $payload);
+    $sent[$idx] = \hrtime(true);
+    $received[$idx] = 0;
+  }
+
+  while (($now = \hrtime(true)) < $deadline) {
+    $read = $clients;
+    $write = $except = null;
+
+    if (\stream_select($read, $write, $except, 0, 100000) < 1) {
+      continue;
+    }
+
+    foreach ($read as $idx => $client) {
+      $chunk = \fread($client, 65536);
+
+      if ($chunk === '' || $chunk === false) {
+        if (\feof($client)) {
+          unset($clients[$idx]);
+        }
+
+        continue;
+      }
+
+      $received[$idx] += \strlen($chunk);
+
+      if ($received[$idx] >= $expect) {
+        $end = \hrtime(true);
+        $latencies[] = ($end - $sent[$idx]) / 1e3;
+        $requests++;
+
+        $received[$idx] = 0;
+        \fwrite($client, $payload);
+        $sent[$idx] = $end;
+      }
+    }
+  }
+
+  $elapsed = (\hrtime(true) - $start) / 1e9;
+
+  foreach ($clients as $client) {
+    \fclose($client);
+  }
+
+  return \array_merge(
+    [
+      'connections' => $connections,
+      'requests'    => $requests,
+      'seconds'     => $elapsed,
+      'rps'         => $requests / $elapsed,
+      'mbps'        => ($requests * ($expect + \strlen($payload))) / $elapsed / 1048576,
+      'latency_us'  => bench_percentiles($latencies),
+    ],
+    $samples ? ['samples' => $latencies] : [],
+  );
+}
+
+/**
+ * drives an echo exchange over several connections spread across a number of load generator processes
+ *
+ * A single process multiplexes its connections with stream_select() and
+ * saturates a core well before a server with several workers does; the
+ * connections are therefore split among child processes running
+ * loadgen.php, whose latency samples are merged.
+ *
+ * @param string $address
+ * @param int $connections
+ * @param int $size payload (and response) size in bytes
+ * @param float $duration
+ * @param int $processes
+ * @return array
+ */
+function bench_loadgen(string $address, int $connections, int $size, float $duration, int $processes = 1): array
+{
+  $processes = \max(1, \min($processes, $connections));
+
+  if ($processes === 1) {
+    return bench_pingpong($address, $connections, \str_repeat('x', $size), $duration, $size);
+  }
+
+  $children = [];
+
+  for ($idx = 0; $idx < $processes; $idx++) {
+    // the connections are spread as evenly as possible
+    $share = \intdiv($connections, $processes) + ($idx < $connections % $processes ? 1 : 0);
+    $proc = \proc_open(
+      bench_command(
+        __DIR__ . '/loadgen.php',
+        [
+          \sprintf('--address=%s', $address),
+          \sprintf('--connections=%d', $share),
+          \sprintf('--size=%d', $size),
+          \sprintf('--duration=%s', $duration),
+          '--samples=1',
+        ],
+      ),
+      [1 => ['pipe', 'w'], 2 => STDERR],
+      $pipes,
+    );
+
+    if (!\is_resource($proc)) {
+      throw new \RuntimeException('Could not start load generator');
+    }
+
+    $children[] = [$proc, $pipes[1]];
+  }
+
+  $requests = 0;
+  $seconds = 0.0;
+  $latencies = [];
+
+  foreach ($children as [$proc, $stdout]) {
+    $result = \json_decode(\stream_get_contents($stdout), true);
+    \fclose($stdout);
+    \proc_close($proc);
+
+    if (!\is_array($result)) {
+      throw new \RuntimeException('Load generator failed');
+    }
+
+    $requests += $result['requests'];
+    $seconds = \max($seconds, $result['seconds']);
+    \array_push($latencies, ...$result['samples']);
+  }
+
+  return [
+    'connections' => $connections,
+    'processes'   => $processes,
+    'requests'    => $requests,
+    'seconds'     => $seconds,
+    'rps'         => $requests / $seconds,
+    'mbps'        => ($requests * $size * 2) / $seconds / 1048576,
+    'latency_us'  => bench_percentiles($latencies),
+  ];
+}
+
+/**
+ * runs a freshly initialized loop to completion and returns the elapsed time along with the memory it held at peak
+ *
+ * @param callable $setup receives the loop before it runs
+ * @param array|null $options loop options
+ * @return array
+ */
+function bench_loop(callable $setup, ?array $options = null): array
+{
+  \gc_collect_cycles();
+
+  if (\function_exists('memory_reset_peak_usage')) {
+    \memory_reset_peak_usage();
+  }
+
+  $loop = \ringphp\Mrloop::init($options);
+  $base = \memory_get_usage();
+  $start = \hrtime(true);
+
+  $setup($loop);
+  $loop->run();
+
+  $seconds = (\hrtime(true) - $start) / 1e9;
+
+  return [$seconds, \memory_get_peak_usage() - $base];
+}
+
+/**
+ * prints benchmark results as JSON (or writes them to the specified file)
+ *
+ * @param string $name
+ * @param array $results
+ * @param string|null $output
+ * @return void
+ */
+function bench_report(string $name, array $results, ?string $output = null): void
+{
+  $json = \json_encode(
+    [
+      'benchmark' => $name,
+      'php'       => PHP_VERSION,
+      'kernel'    => \php_uname('r'),
+      'results'   => $results,
+    ],
+    JSON_PRETTY_PRINT | JSON_UNESCAPED_SLASHES,
+  ) . PHP_EOL;
+
+  if ($output === null) {
+    echo $json;
+  } elseif (\file_put_contents($output, $json) === false) {
+    throw new \RuntimeException(\sprintf('Could not write %s', $output));
+  }
+}
@@ -0,0 +1,162 @@
+<?php
+
+/**
+ * Compares request latency of blocking per-request connections
+ * (stream_socket_client) with that of pooled Mrloop::connect() connections
+ * against a local echo server.
+ *
+ * usage: php bench/connect_pool.php [--requests=10000] [--concurrency=1,16] [--size=64] [--port=9502]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+// child process: echo server
+if (($argv[1] ?? null) === 'server') {
+  $loop = Mrloop::init();
+
+  $loop->tcpServer(
+    (int) $argv[2],
+    4096,
+    null,
+    fn (string $message, Connection $conn) => $message,
+  );
+
+  $loop->run();
+
+  exit(0);
+}
+
+$options = bench_options(
+  $argv,
+  [
+    'requests'    => 10000,
+    'concurrency' => '1,16',
+    'size'        => 64,
+    'port'        => 9502,
+  ],
+);
+
+$requests = (int) $options['requests'];
+$port = (int) $options['port'];
+$payload = \str_repeat('x', (int) $options['size']);
+
+/**
+ * issues requests one at a time, each over a fresh blocking connection
+ */
+function blocking_requests(int $port, string $payload, int $requests): array
+{
+  $latencies = [];
+  $start = \hrtime(true);
+
+  for ($idx = 0; $idx < $requests; $idx++) {
+    $begin = \hrtime(true);
+
+    $client = \stream_socket_client(\sprintf("tcp://127.0.0.1:%d", $port), $errno, $errstr, 5.0);
+    \fwrite($client, $payload);
+
+    $received = 0;
+    while ($received < \strlen($payload) && ($chunk = \fread($client, 65536)) !== '' && $chunk !== false) {
+      $received += \strlen($chunk);
+    }
+    \fclose($client);
+
+    $latencies[] = (\hrtime(true) - $begin) / 1e3;
+  }
+
+  $elapsed = (\hrtime(true) - $start) / 1e9;
+
+  return [
+    'concurrency' => 1,
+    'requests'    => $requests,
+    'seconds'     => $elapsed,
+    'rps'         => $requests / $elapsed,
+    'latency_us'  => bench_percentiles($latencies),
+  ];
+}
+
+/**
+ * issues requests over pooled connections from several concurrent request chains
+ */
+function pooled_requests(int $port, string $payload, int $requests, int $concurrency): array
+{
+  $loop = Mrloop::init();
+  $latencies = [];
+  $issued = 0;
+  $completed = 0;
+  $start = \hrtime(true);
+
+  $request = function () use (&$request, &$issued, &$completed, &$latencies, $loop, $port, $payload, $requests) {
+    if ($issued++ >= $requests) {
+      return;
+    }
+
+    $begin = \hrtime(true);
+
+    $loop->connect(
+      '127.0.0.1',
+      $port,
+      function (?Connection $conn, ?string $error) use (&$request, &$completed, &$latencies, $begin, $loop, $payload, $requests) {
+        if ($conn === null) {
+          throw new \RuntimeException($error);
+        }
+
+        $received = 0;
+        $conn->write($payload);
+
+        $reader = function (string $chunk) use (&$reader, &$received, &$request, &$completed, &$latencies, $conn, $begin, $loop, $payload, $requests) {
+          $received += \strlen($chunk);
+
+          if ($chunk !== '' && $received < \strlen($payload)) {
+            $conn->read($reader);
+            return;
+          }
+
+          $latencies[] = (\hrtime(true) - $begin) / 1e3;
+          $conn->release();
+
+          if (++$completed === $requests) {
+            $loop->stop();
+            return;
+          }
+
+          $request();
+        };
+
+        $conn->read($reader);
+      },
+    );
+  };
+
+  for ($idx = 0; $idx < $concurrency; $idx++) {
+    $request();
+  }
+
+  $loop->run();
+
+  $elapsed = (\hrtime(true) - $start) / 1e9;
+
+  return [
+    'concurrency' => $concurrency,
+    'requests'    => $completed,
+    'seconds'     => $elapsed,
+    'rps'         => $completed / $elapsed,
+    'latency_us'  => bench_percentiles($latencies),
+  ];
+}
+
+$server = bench_spawn(__FILE__, ['server', $port], \sprintf("tcp://127.0.0.1:%d", $port));
+
+$results = ['blocking' => [blocking_requests($port, $payload, $requests)]];
+
+foreach (\explode(',', (string) $options['concurrency']) as $concurrency) {
+  $results['pooled'][] = pooled_requests($port, $payload, $requests, (int) $concurrency);
+}
+
+bench_stop($server);
+
+bench_report('connect_pool', $results);
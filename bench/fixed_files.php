@@ -0,0 +1,104 @@
+<?php
+
+/**
+ * Compares small-write throughput of addWriteStream() on a plain descriptor,
+ * on a registered descriptor, and on a registered descriptor with a pool of
+ * fixed buffers.
+ *
+ * usage: php bench/fixed_files.php [--duration=3] [--inflight=64] [--size=64] [--file=/dev/null]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Mrloop;
+
+$options = bench_options(
+  $argv,
+  [
+    'duration' => 3,
+    'inflight' => 64,
+    'size'     => 64,
+    'file'     => '/dev/null',
+  ],
+);
+
+/**
+ * keeps a fixed number of writes in flight for the specified duration
+ */
+function small_writes(string $mode, array $options): array
+{
+  $loop = Mrloop::init();
+  $fd = \fopen($options['file'], 'a');
+  $payload = \str_repeat('x', (int) $options['size']);
+  $deadline = \hrtime(true) + (int) ($options['duration'] * 1e9);
+  $writes = 0;
+  $inflight = 0;
+
+  if ($mode !== 'plain') {
+    $loop->registerFiles([$fd]);
+  }
+
+  if ($mode === 'fixed_buffers') {
+    $loop->registerBuffers((int) $options['inflight'], \max(4096, (int) $options['size']));
+  }
+
+  $write = function () use (&$write, &$writes, &$inflight, $deadline, $fd, $loop, $payload) {
+    $inflight++;
+
+    $loop->addWriteStream(
+      $fd,
+      $payload,
+      null,
+      function (int $nbytes) use (&$write, &$writes, &$inflight, $deadline, $loop) {
+        $inflight--;
+        $writes++;
+
+        if (\hrtime(true) < $deadline) {
+          $write();
+        } elseif ($inflight === 0) {
+          $loop->stop();
+        }
+      },
+    );
+  };
+
+  $start = \hrtime(true);
+
+  for ($idx = 0; $idx < (int) $options['inflight']; $idx++) {
+    $write();
+  }
+
+  $loop->run();
+
+  $elapsed = (\hrtime(true) - $start) / 1e9;
+
+  if ($mode !== 'plain') {
+    $loop->registerFiles([]);
+  }
+  \fclose($fd);
+
+  return [
+    'writes'    => $writes,
+    'seconds'   => $elapsed,
+    'ops'       => $writes / $elapsed,
+    'cpu'       => \getrusage(),
+  ];
+}
+
+$results = [];
+
+foreach (['plain', 'fixed_files', 'fixed_buffers'] as $mode) {
+  $before = \getrusage();
+  $result = small_writes($mode, $options);
+  $after = $result['cpu'];
+
+  $result['cpu_seconds'] = ($after['ru_utime.tv_sec'] + $after['ru_utime.tv_usec'] / 1e6 + $after['ru_stime.tv_sec'] + $after['ru_stime.tv_usec'] / 1e6)
+    - ($before['ru_utime.tv_sec'] + $before['ru_utime.tv_usec'] / 1e6 + $before['ru_stime.tv_sec'] + $before['ru_stime.tv_usec'] / 1e6);
+  unset($result['cpu']);
+
+  $results[$mode] = $result;
+}
+
+bench_report('fixed_files', $results);
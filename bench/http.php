@@ -0,0 +1,132 @@
+<?php
+
+/**
+ * Compares keep-alive request throughput and latency of httpServer(), which
+ * parses requests natively, with those of tcpServer() and a parser written
+ * in PHP. Both servers hand the callback the same request array and send
+ * byte-for-byte identical responses.
+ *
+ * usage: php bench/http.php [--duration=5] [--connections=1,16,64] [--port=9501]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+const BENCH_HTTP_BODY = 'Hello, world';
+
+/**
+ * parses the complete requests at the start of a buffer; whatever remains is left in it
+ */
+function bench_http_parse(string &$buffer): array
+{
+  $requests = [];
+
+  while (($end = \strpos($buffer, "\r\n\r\n")) !== false) {
+    $lines = \explode("\r\n", \substr($buffer, 0, $end));
+    [$method, $path, $version] = \explode(' ', \array_shift($lines), 3);
+    $headers = [];
+
+    foreach ($lines as $line) {
+      [$name, $value] = \explode(':', $line, 2);
+      $headers[\strtolower($name)] = \trim($value);
+    }
+
+    $length = (int) ($headers['content-length'] ?? 0);
+
+    if (\strlen($buffer) < $end + 4 + $length) {
+      break;
+    }
+
+    $requests[] = [
+      'method'  => $method,
+      'path'    => $path,
+      'version' => \substr($version, 5),
+      'headers' => $headers,
+      'body'    => \substr($buffer, $end + 4, $length),
+    ];
+
+    $buffer = \substr($buffer, $end + 4 + $length);
+  }
+
+  return $requests;
+}
+
+/**
+ * serializes a response as httpServer() does
+ */
+function bench_http_response(string $body): string
+{
+  return \sprintf("HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=UTF-8\r\nContent-Length: %d\r\n\r\n%s", \strlen($body), $body);
+}
+
+// child process: HTTP server parsing requests natively or in userland
+if (($argv[1] ?? null) === 'server') {
+  $loop = Mrloop::init();
+  $handler = fn (array $request) => BENCH_HTTP_BODY;
+
+  if ($argv[3] === 'native') {
+    $loop->httpServer((int) $argv[2], 4096, null, $handler);
+  } else {
+    $buffers = new \WeakMap();
+
+    $loop->tcpServer(
+      (int) $argv[2],
+      4096,
+      null,
+      function (string $message, Connection $conn) use ($handler, $buffers) {
+        $buffer = ($buffers[$conn] ?? '') . $message;
+        $response = '';
+
+        foreach (bench_http_parse($buffer) as $request) {
+          $response .= bench_http_response($handler($request));
+        }
+
+        $buffers[$conn] = $buffer;
+
+        return $response;
+      },
+    );
+  }
+
+  $loop->run();
+
+  exit(0);
+}
+
+$options = bench_options(
+  $argv,
+  [
+    'duration'    => 5,
+    'connections' => '1,16,64',
+    'port'        => 9501,
+  ],
+);
+
+$address = \sprintf('tcp://127.0.0.1:%d', $options['port']);
+$request = "GET /bench HTTP/1.1\r\nHost: localhost\r\nUser-Agent: mrloop-bench\r\nAccept: */*\r\n\r\n";
+$expect = \strlen(bench_http_response(BENCH_HTTP_BODY));
+$results = [];
+
+foreach (['native', 'userland'] as $parser) {
+  $server = bench_spawn(__FILE__, ['server', $options['port'], $parser], $address);
+
+  foreach (\explode(',', (string) $options['connections']) as $connections) {
+    $results[$parser][] = bench_pingpong($address, (int) $connections, $request, (float) $options['duration'], $expect);
+  }
+
+  bench_stop($server);
+}
+
+// throughput of the native parser relative to the userland one at each connection count
+foreach ($results['native'] as $idx => $result) {
+  $results['speedup'][] = [
+    'connections' => $result['connections'],
+    'rps'         => $result['rps'] / \max(1e-9, $results['userland'][$idx]['rps']),
+  ];
+}
+
+bench_report('http', $results);
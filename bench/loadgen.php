@@ -0,0 +1,60 @@
+<?php
+
+/**
+ * Local load generator: drives an echo exchange (each response as long as
+ * the request) against a running server over a number of connections for a
+ * fixed duration, and reports throughput and latency percentiles. It needs
+ * nothing beyond PHP and runs offline; the server may be any of the echo
+ * servers started by the scripts in this directory, or one of your own.
+ *
+ * usage: php bench/loadgen.php --address=tcp://127.0.0.1:9501 [--connections=64] [--size=64] [--duration=5] [--processes=1] [--output=path]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+$options = bench_options(
+  $argv,
+  [
+    'address'     => 'tcp://127.0.0.1:9501',
+    'connections' => 64,
+    'size'        => 64,
+    'duration'    => 5,
+    'processes'   => 1,
+    'samples'     => 0,
+    'output'      => null,
+  ],
+);
+
+// child process of bench_loadgen(): the raw samples are merged by the parent
+if ($options['samples']) {
+  echo \json_encode(
+    bench_pingpong(
+      (string) $options['address'],
+      (int) $options['connections'],
+      \str_repeat('x', (int) $options['size']),
+      (float) $options['duration'],
+      (int) $options['size'],
+      true,
+    ),
+  );
+
+  exit(0);
+}
+
+bench_report(
+  'loadgen',
+  [
+    'address' => $options['address'],
+    'size'    => (int) $options['size'],
+    'echo'    => bench_loadgen(
+      (string) $options['address'],
+      (int) $options['connections'],
+      (int) $options['size'],
+      (float) $options['duration'],
+      (int) $options['processes'],
+    ),
+  ],
+  $options['output'],
+);
@@ -0,0 +1,109 @@
+<?php
+
+/**
+ * Compares proxying responses from an upstream server with pipe() (kernel-side
+ * splice) to relaying them chunk by chunk through Connection::read() and
+ * Connection::write(), and reports the proxy's CPU time per gigabyte relayed.
+ *
+ * usage: php bench/pipe.php [--duration=5] [--connections=1,16] [--size=1048576] [--port=9505]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+// child process: upstream server (on the port following the specified one) and proxy in the specified mode
+if (($argv[1] ?? null) === 'server') {
+  [, , $mode, $port, $size] = $argv;
+
+  $loop = Mrloop::init();
+  $blob = \str_repeat('x', (int) $size);
+
+  $loop->tcpServer((int) $port + 1, 4096, null, fn (string $message, Connection $conn) => $blob);
+
+  $loop->tcpServer(
+    (int) $port,
+    4096,
+    null,
+    function (string $message, Connection $conn) use ($loop, $mode, $port, $size) {
+      $loop->connect(
+        '127.0.0.1',
+        (int) $port + 1,
+        function (?Connection $upstream, ?string $error) use ($conn, $loop, $message, $mode, $size) {
+          $upstream->write($message);
+
+          if ($mode === 'pipe') {
+            $loop->pipe($upstream, $conn, ['length' => (int) $size], fn () => $upstream->release());
+            return;
+          }
+
+          $relayed = 0;
+          $relay = function (string $chunk) use ($conn, &$relay, &$relayed, $size, $upstream) {
+            $conn->write($chunk);
+
+            if (($relayed += \strlen($chunk)) < (int) $size && $chunk !== '') {
+              $upstream->read($relay);
+            } else {
+              $upstream->release();
+            }
+          };
+
+          $upstream->read($relay);
+        },
+      );
+    },
+  );
+
+  $loop->run();
+
+  exit(0);
+}
+
+/**
+ * reads the CPU time (in seconds) consumed by a process so far
+ */
+function cpu_seconds(int $pid): float
+{
+  $stat = \file_get_contents(\sprintf("/proc/%d/stat", $pid));
+  $fields = \explode(' ', \substr($stat, \strrpos($stat, ')') + 2));
+
+  // utime and stime are the 12th and 13th fields following the process name
+  return ((int) $fields[11] + (int) $fields[12]) / 100;
+}
+
+$options = bench_options(
+  $argv,
+  [
+    'duration'    => 5,
+    'connections' => '1,16',
+    'size'        => 1048576,
+    'port'        => 9505,
+  ],
+);
+
+$address = \sprintf("tcp://127.0.0.1:%d", $options['port']);
+$results = [];
+
+foreach (['copy', 'pipe'] as $mode) {
+  $server = bench_spawn(__FILE__, ['server', $mode, $options['port'], $options['size']], $address);
+  $pid = \proc_get_status($server)['pid'];
+
+  foreach (\explode(',', (string) $options['connections']) as $connections) {
+    $before = cpu_seconds($pid);
+    $result = bench_pingpong($address, (int) $connections, 'GET', (float) $options['duration'], (int) $options['size']);
+    $cpu = cpu_seconds($pid) - $before;
+
+    $relayed = $result['requests'] * (int) $options['size'] / 1073741824;
+    $result['proxy_cpu_seconds'] = $cpu;
+    $result['proxy_cpu_seconds_per_gb'] = $relayed > 0 ? $cpu / $relayed : null;
+
+    $results[$mode][] = $result;
+  }
+
+  bench_stop($server);
+}
+
+bench_report('pipe', $results);
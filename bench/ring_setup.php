@@ -0,0 +1,80 @@
+<?php
+
+/**
+ * Compares echo throughput and latency of tcpServer() across setups of the
+ * extension-managed ring (queue depths, SQPOLL with and without a pinned
+ * polling thread, single issuer and cooperative task running). Setup flags
+ * the kernel does not support are shed, in which case the configuration
+ * measures the setup that remains.
+ *
+ * usage: php bench/ring_setup.php [--duration=5] [--connections=1,16,64] [--size=64] [--port=9501] [--cpu=0]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+// child process: echo server whose loop is initialized with the JSON-encoded options
+if (($argv[1] ?? null) === 'server') {
+  $loop = Mrloop::init(\json_decode($argv[3], true));
+
+  $loop->tcpServer(
+    (int) $argv[2],
+    4096,
+    null,
+    fn (string $message, Connection $conn) => $message,
+  );
+
+  $loop->run();
+
+  exit(0);
+}
+
+$options = bench_options(
+  $argv,
+  [
+    'duration'    => 5,
+    'connections' => '1,16,64',
+    'size'        => 64,
+    'port'        => 9501,
+    'cpu'         => 0,
+  ],
+);
+
+$configurations = [
+  'default'          => [],
+  'deep_queues'      => ['entries' => 16384, 'cq_entries' => 65536],
+  'sqpoll'           => ['sqpoll' => true],
+  'sqpoll_pinned'    => ['sqpoll' => ['idle' => 2000, 'cpu' => (int) $options['cpu']]],
+  'single_issuer'    => ['single_issuer' => true],
+  'coop_taskrun'     => ['single_issuer' => true, 'coop_taskrun' => true],
+  'sqpoll_coop'      => ['sqpoll' => true, 'single_issuer' => true, 'coop_taskrun' => true],
+];
+
+$address = \sprintf('tcp://127.0.0.1:%d', $options['port']);
+$payload = \str_repeat('x', (int) $options['size']);
+$results = [];
+
+foreach ($configurations as $name => $setup) {
+  $server = bench_spawn(__FILE__, ['server', $options['port'], \json_encode((object) $setup)], $address);
+
+  foreach (\explode(',', (string) $options['connections']) as $connections) {
+    $results[$name][] = \array_merge(
+      ['options' => $setup],
+      bench_pingpong(
+        $address,
+        (int) $connections,
+        $payload,
+        (float) $options['duration'],
+        \strlen($payload),
+      ),
+    );
+  }
+
+  bench_stop($server);
+}
+
+bench_report('ring_setup', $results);
@@ -0,0 +1,385 @@
+<?php
+
+/**
+ * Runs the benchmark suite and reports every result in a single JSON
+ * document, so that runs before and after a change can be compared:
+ *
+ * - echo: throughput and latency percentiles of a tcpServer() echo server
+ *   at each of several connection counts, driven by the local load
+ *   generator, along with the server's own stats() for each run
+ * - memory: server memory per idle connection
+ * - timers: a storm of one-shot timers spread over a window, with the
+ *   lateness of each
+ * - ticks: futureTick() churn in one and in many concurrent chains
+ * - files: write and read throughput of addWriteStream() and
+ *   addReadStream() on a temporary file (reads are likely served from the
+ *   page cache)
+ *
+ * Everything runs locally and offline. The server runs in a child process;
+ * the load generator runs in this one unless --processes is raised.
+ *
+ * usage: php bench/run.php [--only=echo,memory,timers,ticks,files] [--duration=5] [--connections=1,16,64,256] [--size=64]
+ *                          [--processes=1] [--port=9501] [--idle=500] [--timers=100000] [--spread=1] [--ticks=1000000]
+ *                          [--chains=1,1000] [--file-size=67108864] [--chunk=65536] [--inflight=16] [--output=path]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+// child process: echo server alongside a control server which reports its memory usage and statistics
+if (($argv[1] ?? null) === 'server') {
+  $loop = Mrloop::init(['stats' => true]);
+
+  $loop->tcpServer(
+    (int) $argv[2],
+    4096,
+    null,
+    fn (string $message, Connection $conn) => $message,
+  );
+
+  $loop->tcpServer(
+    (int) $argv[2] + 1,
+    null,
+    null,
+    function (string $message) use ($loop) {
+      try {
+        $stats = $loop->stats(\trim($message) === 'reset');
+      } catch (\Throwable $err) {
+        // the extension was built without statistics
+        $stats = null;
+      }
+
+      return \json_encode(['memory' => \memory_get_usage(), 'stats' => $stats]) . "\n";
+    },
+  );
+
+  $loop->run();
+
+  exit(0);
+}
+
+/**
+ * sends a command to the control server and returns its response
+ */
+function control(int $port, string $command): array
+{
+  $conn = \stream_socket_client(\sprintf('tcp://127.0.0.1:%d', $port), $errno, $errstr, 5.0);
+
+  if (!$conn) {
+    throw new \RuntimeException($errstr);
+  }
+
+  \fwrite($conn, $command);
+  $response = '';
+
+  while (!\str_ends_with($response, "\n") && ($chunk = \fread($conn, 65536)) !== false && $chunk !== '') {
+    $response .= $chunk;
+  }
+
+  \fclose($conn);
+
+  return \json_decode($response, true);
+}
+
+/**
+ * measures echo throughput and latency at each connection count
+ */
+function bench_echo(array $options): array
+{
+  $port = (int) $options['port'];
+  $address = \sprintf('tcp://127.0.0.1:%d', $port);
+  $server = bench_spawn(__FILE__, ['server', $port], $address);
+  $results = [];
+
+  try {
+    foreach (\explode(',', (string) $options['connections']) as $connections) {
+      control($port + 1, 'reset');
+
+      $result = bench_loadgen(
+        $address,
+        (int) $connections,
+        (int) $options['size'],
+        (float) $options['duration'],
+        (int) $options['processes'],
+      );
+
+      $results[] = \array_merge($result, ['server' => control($port + 1, 'stats')['stats']]);
+    }
+  } finally {
+    bench_stop($server);
+  }
+
+  return $results;
+}
+
+/**
+ * measures the server memory held by each idle connection
+ */
+function bench_memory(array $options): array
+{
+  $port = (int) $options['port'];
+  $address = \sprintf('tcp://127.0.0.1:%d', $port);
+  $server = bench_spawn(__FILE__, ['server', $port], $address);
+  $idle = (int) $options['idle'];
+  $clients = [];
+
+  try {
+    $before = control($port + 1, 'stats');
+
+    for ($idx = 0; $idx < $idle; $idx++) {
+      if (!($clients[] = \stream_socket_client($address, $errno, $errstr, 5.0))) {
+        throw new \RuntimeException(\sprintf('%s (raise the open file limit or lower --idle)', $errstr));
+      }
+    }
+
+    // the server counts its connections (the control connection included) when built with statistics; it is otherwise given a moment to accept them
+    $deadline = \microtime(true) + 5.0;
+    do {
+      \usleep(50000);
+      $after = control($port + 1, 'stats');
+    } while ($after['stats'] !== null && $after['stats']['connections'] <= $idle && \microtime(true) < $deadline);
+
+    foreach ($clients as $client) {
+      \fclose($client);
+    }
+  } finally {
+    bench_stop($server);
+  }
+
+  return [
+    'connections'    => $idle,
+    'memory_before'  => $before['memory'],
+    'memory_after'   => $after['memory'],
+    'per_connection' => ($after['memory'] - $before['memory']) / $idle,
+    'buffers'        => $after['stats']['memory'] ?? null,
+  ];
+}
+
+/**
+ * arms one-shot timers spread evenly over a window and measures how late each fires
+ */
+function bench_timers(array $options): array
+{
+  $count = (int) $options['timers'];
+  $spread = (float) $options['spread'];
+  $lateness = [];
+
+  [$seconds, $memory] = bench_loop(
+    function (Mrloop $loop) use ($count, $spread, &$lateness) {
+      $start = \hrtime(true);
+      $fired = 0;
+
+      for ($idx = 0; $idx < $count; $idx++) {
+        $interval = $spread * $idx / $count;
+        $due = $start + (int) ($interval * 1e9);
+
+        $loop->addTimer(
+          $interval,
+          function () use ($loop, $due, $count, &$fired, &$lateness) {
+            $lateness[] = \max(0, \hrtime(true) - $due) / 1e3;
+
+            if (++$fired === $count) {
+              $loop->stop();
+            }
+          },
+        );
+      }
+    },
+  );
+
+  return [
+    'timers'            => $count,
+    'spread'            => $spread,
+    'seconds'           => $seconds,
+    'timers_per_second' => $count / $seconds,
+    'peak_memory'       => $memory,
+    'lateness_us'       => bench_percentiles($lateness),
+  ];
+}
+
+/**
+ * runs chains of future ticks, each of which schedules its successor
+ */
+function bench_ticks(array $options): array
+{
+  $operations = (int) $options['ticks'];
+  $results = [];
+
+  foreach (\explode(',', (string) $options['chains']) as $chains) {
+    [$seconds, $memory] = bench_loop(
+      function (Mrloop $loop) use ($chains, $operations) {
+        $remaining = $operations;
+
+        $tick = function () use ($loop, &$remaining, &$tick) {
+          if (--$remaining > 0) {
+            $loop->futureTick($tick);
+          } elseif ($remaining === 0) {
+            $loop->stop();
+          }
+        };
+
+        for ($idx = 0; $idx < (int) $chains; $idx++) {
+          $loop->futureTick($tick);
+        }
+      },
+    );
+
+    $results[] = [
+      'chains'           => (int) $chains,
+      'ticks'            => $operations,
+      'seconds'          => $seconds,
+      'ticks_per_second' => $operations / $seconds,
+      'peak_memory'      => $memory,
+    ];
+  }
+
+  return $results;
+}
+
+/**
+ * writes a file in fixed-size chunks and reads it back, keeping a number of operations in flight
+ */
+function bench_files(array $options): array
+{
+  $size = (int) $options['file-size'];
+  $chunk = (int) $options['chunk'];
+  $inflight = (int) $options['inflight'];
+  $path = \tempnam(\sys_get_temp_dir(), 'mrloop-bench');
+  $payload = \str_repeat('x', $chunk);
+  $results = [];
+
+  try {
+    // appends land one after another however the writes in flight complete
+    $fd = \fopen($path, 'a');
+    $written = 0;
+
+    [$seconds] = bench_loop(
+      function (Mrloop $loop) use ($fd, $payload, $size, $inflight, &$written) {
+        $issued = 0;
+        $pending = 0;
+
+        $write = function () use ($loop, $fd, $payload, $size, &$write, &$issued, &$pending, &$written) {
+          $issued += \strlen($payload);
+          $pending++;
+
+          $loop->addWriteStream(
+            $fd,
+            $payload,
+            null,
+            function (int $nbytes) use ($loop, $size, &$write, &$issued, &$pending, &$written) {
+              $pending--;
+              $written += $nbytes;
+
+              if ($issued < $size) {
+                $write();
+              } elseif ($pending === 0) {
+                $loop->stop();
+              }
+            },
+          );
+        };
+
+        for ($idx = 0; $idx < $inflight && $issued < $size; $idx++) {
+          $write();
+        }
+      },
+    );
+
+    \fclose($fd);
+    $results['write'] = ['bytes' => $written, 'seconds' => $seconds, 'mbps' => $written / $seconds / 1048576];
+
+    $fd = \fopen($path, 'r');
+    $read = 0;
+
+    [$seconds] = bench_loop(
+      function (Mrloop $loop) use ($fd, $chunk, $written, $inflight, &$read) {
+        $offset = 0;
+        $pending = 0;
+
+        $next = function () use ($loop, $fd, $chunk, $written, &$next, &$offset, &$pending, &$read) {
+          $pending++;
+
+          $loop->addReadStream(
+            $fd,
+            $chunk,
+            null,
+            $offset,
+            function (string $contents, int $nbytes) use ($loop, $written, &$next, &$offset, &$pending, &$read) {
+              $pending--;
+              $read += \max(0, $nbytes);
+
+              if ($offset < $written) {
+                $next();
+              } elseif ($pending === 0) {
+                $loop->stop();
+              }
+            },
+          );
+
+          $offset += $chunk;
+        };
+
+        for ($idx = 0; $idx < $inflight && $offset < $written; $idx++) {
+          $next();
+        }
+      },
+    );
+
+    \fclose($fd);
+    $results['read'] = ['bytes' => $read, 'seconds' => $seconds, 'mbps' => $read / $seconds / 1048576];
+  } finally {
+    \unlink($path);
+  }
+
+  return \array_merge(['chunk' => $chunk, 'inflight' => $inflight], $results);
+}
+
+$options = bench_options(
+  $argv,
+  [
+    'only'        => 'echo,memory,timers,ticks,files',
+    'duration'    => 5,
+    'connections' => '1,16,64,256',
+    'size'        => 64,
+    'processes'   => 1,
+    'port'        => 9501,
+    'idle'        => 500,
+    'timers'      => 100000,
+    'spread'      => 1,
+    'ticks'       => 1000000,
+    'chains'      => '1,1000',
+    'file-size'   => 67108864,
+    'chunk'       => 65536,
+    'inflight'    => 16,
+    'output'      => null,
+  ],
+);
+
+$suites = [
+  'echo'   => 'bench_echo',
+  'memory' => 'bench_memory',
+  'timers' => 'bench_timers',
+  'ticks'  => 'bench_ticks',
+  'files'  => 'bench_files',
+];
+
+// the revision under test is recorded so that reports can be told apart
+$revision = @\shell_exec(\sprintf('git -C %s rev-parse --short HEAD 2>/dev/null', \escapeshellarg(__DIR__)));
+$results = [
+  'revision' => $revision ? \trim($revision) : null,
+  'options'  => $options,
+];
+
+foreach (\explode(',', (string) $options['only']) as $suite) {
+  if (!isset($suites[$suite])) {
+    throw new \InvalidArgumentException(\sprintf('Unknown suite %s', $suite));
+  }
+
+  $results[$suite] = $suites[$suite]($options);
+}
+
+bench_report('suite', $results, $options['output']);
@@ -0,0 +1,93 @@
+<?php
+
+/**
+ * Compares serving a file with sendFile() (kernel-side splice) to reading it
+ * into a PHP string with addReadStream() and writing that back out, and
+ * reports the server's CPU time per gigabyte served.
+ *
+ * usage: php bench/sendfile.php [--duration=5] [--connections=1,16] [--size=1048576] [--port=9503]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+// child process: file server in the specified mode
+if (($argv[1] ?? null) === 'server') {
+  [, , $mode, $port, $path] = $argv;
+
+  $loop = Mrloop::init();
+  $file = \fopen($path, 'r');
+  $size = \filesize($path);
+
+  $loop->tcpServer(
+    (int) $port,
+    4096,
+    null,
+    function (string $message, Connection $conn) use ($file, $loop, $mode, $size) {
+      if ($mode === 'splice') {
+        $loop->sendFile($file, $conn, 0, $size, fn (int $sent, ?string $error) => null);
+      } else {
+        $loop->addReadStream($file, $size, null, 0, fn (string $contents) => $conn->write($contents));
+      }
+    },
+  );
+
+  $loop->run();
+
+  exit(0);
+}
+
+/**
+ * reads the CPU time (in seconds) consumed by a process so far
+ */
+function cpu_seconds(int $pid): float
+{
+  $stat = \file_get_contents(\sprintf("/proc/%d/stat", $pid));
+  $fields = \explode(' ', \substr($stat, \strrpos($stat, ')') + 2));
+
+  // utime and stime are the 12th and 13th fields following the process name
+  return ((int) $fields[11] + (int) $fields[12]) / 100;
+}
+
+$options = bench_options(
+  $argv,
+  [
+    'duration'    => 5,
+    'connections' => '1,16',
+    'size'        => 1048576,
+    'port'        => 9503,
+  ],
+);
+
+$path = \sprintf("%s/mrloop-bench-%d.bin", \sys_get_temp_dir(), \getmypid());
+\file_put_contents($path, \str_repeat('x', (int) $options['size']));
+
+$address = \sprintf("tcp://127.0.0.1:%d", $options['port']);
+$results = [];
+
+foreach (['copy', 'splice'] as $mode) {
+  $server = bench_spawn(__FILE__, ['server', $mode, $options['port'], $path], $address);
+  $pid = \proc_get_status($server)['pid'];
+
+  foreach (\explode(',', (string) $options['connections']) as $connections) {
+    $before = cpu_seconds($pid);
+    $result = bench_pingpong($address, (int) $connections, 'GET', (float) $options['duration'], (int) $options['size']);
+    $cpu = cpu_seconds($pid) - $before;
+
+    $served = $result['requests'] * (int) $options['size'] / 1073741824;
+    $result['server_cpu_seconds'] = $cpu;
+    $result['server_cpu_seconds_per_gb'] = $served > 0 ? $cpu / $served : null;
+
+    $results[$mode][] = $result;
+  }
+
+  bench_stop($server);
+}
+
+\unlink($path);
+
+bench_report('sendfile', $results);
@@ -0,0 +1,67 @@
+<?php
+
+/**
+ * Compares echo throughput and latency of tcpServer() over a Unix domain
+ * socket and over loopback TCP.
+ *
+ * usage: php bench/uds_vs_tcp.php [--duration=5] [--connections=1,16,64] [--size=64] [--port=9501]
+ */
+
+declare(strict_types=1);
+
+require __DIR__ . '/common.php';
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+// child process: echo server on the specified address
+if (($argv[1] ?? null) === 'server') {
+  $loop = Mrloop::init();
+
+  $loop->tcpServer(
+    \is_numeric($argv[2]) ? (int) $argv[2] : $argv[2],
+    4096,
+    null,
+    fn (string $message, Connection $conn) => $message,
+  );
+
+  $loop->run();
+
+  exit(0);
+}
+
+$options = bench_options(
+  $argv,
+  [
+    'duration'    => 5,
+    'connections' => '1,16,64',
+    'size'        => 64,
+    'port'        => 9501,
+  ],
+);
+
+$path = \sprintf("%s/mrloop-bench-%d.sock", \sys_get_temp_dir(), \getmypid());
+$payload = \str_repeat('x', (int) $options['size']);
+$targets = [
+  'uds' => [\sprintf("unix://%s", $path), \sprintf("unix://%s", $path)],
+  'tcp' => [\sprintf("127.0.0.1:%d", $options['port']), \sprintf("tcp://127.0.0.1:%d", $options['port'])],
+];
+$results = [];
+
+foreach ($targets as $name => [$listen, $connect]) {
+  $server = bench_spawn(__FILE__, ['server', $listen], $connect);
+
+  foreach (\explode(',', (string) $options['connections']) as $connections) {
+    $results[$name][] = bench_pingpong(
+      $connect,
+      (int) $connections,
+      $payload,
+      (float) $options['duration'],
+      \strlen($payload),
+    );
+  }
+
+  bench_stop($server);
+}
+
+bench_report('uds_vs_tcp', $results);
@@ -11,6 +11,20 @@ PHP_ARG_WITH([mrloop],
     [specify path to mrloop library])],
   [no])
 
+PHP_ARG_WITH([picohttpparser],
+  [for picohttpparser library],
+  [AS_HELP_STRING([--with-picohttpparser],
+    [specify path to picohttpparser library])],
+  [no],
+  [no])
+
+PHP_ARG_ENABLE([mrloop-stats],
+  [whether to collect loop statistics],
+  [AS_HELP_STRING([--disable-mrloop-stats],
+    [compile out the counters and histograms reported by Mrloop::stats()])],
+  [yes],
+  [no])
+
 if test "$PHP_MRLOOP" != "no"; then
   dnl add PHP version check
   PHP_VERSION=$($PHP_CONFIG --vernum)
@@ -45,8 +59,24 @@ if test "$PHP_MRLOOP" != "no"; then
     AC_MSG_ERROR(Please download mrloop)
   fi
 
-  CFLAGS="-g -O3 -luring -I$PHP_MRLOOP/"
+  AC_MSG_CHECKING([for picohttpparser package])
+  if test "$PHP_PICOHTTPPARSER" = "no"; then
+    PHP_PICOHTTPPARSER="$PHP_MRLOOP"
+  fi
+
+  if test -s "$PHP_PICOHTTPPARSER/picohttpparser.c"; then
+    AC_MSG_RESULT(found picohttpparser package)
+  else
+    AC_MSG_RESULT(picohttpparser is not downloaded)
+    AC_MSG_ERROR(Please download picohttpparser)
+  fi
+
+  CFLAGS="-g -O3 -luring -lpthread -I$PHP_MRLOOP/ -I$PHP_PICOHTTPPARSER/"
   AC_DEFINE(HAVE_MRLOOP, 1, [ Have mrloop support ])
 
+  if test "$PHP_MRLOOP_STATS" != "no"; then
+    AC_DEFINE(HAVE_MRLOOP_STATS, 1, [ Have loop statistics ])
+  fi
+
   PHP_NEW_EXTENSION(mrloop, php_mrloop.c, $ext_shared)
 fi
@@ -1,10 +1,17 @@
 /* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_init, 0, 0, 0)
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 1, "null")
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_run, 0, 0, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_batch, 0, 0, 1)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Mrloop_flush arginfo_class_Mrloop_run
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_stop, 0, 0, 0)
 ZEND_END_ARG_INFO()
 
@@ -19,10 +26,32 @@ ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_tcpServer, 0, 0, 4)
-ZEND_ARG_TYPE_INFO(0, port, IS_LONG, 0)
+ZEND_ARG_TYPE_MASK(0, address, MAY_BE_LONG | MAY_BE_STRING, NULL)
 ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, connections, IS_LONG, 0, "null")
 ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, nbytes, IS_LONG, 0, "null")
 ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 1, "null")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_httpServer, 0, 0, 4)
+ZEND_ARG_TYPE_MASK(0, address, MAY_BE_LONG | MAY_BE_STRING, NULL)
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, connections, IS_LONG, 0, "null")
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, nbytes, IS_LONG, 0, "null")
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 1, "null")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_udpServer, 0, 0, 2)
+ZEND_ARG_TYPE_MASK(0, address, MAY_BE_LONG | MAY_BE_STRING, NULL)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 1, "null")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_connect, 0, 0, 3)
+ZEND_ARG_TYPE_INFO(0, host, IS_STRING, 0)
+ZEND_ARG_TYPE_INFO(0, port, IS_LONG, 0)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 1, "null")
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_addSignal, 0, 0, 2)
@@ -32,50 +61,233 @@ ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_addReadStream, 0, 0, 5)
 ZEND_ARG_TYPE_INFO(0, stream, IS_RESOURCE, 0)
-ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, nbytes, IS_LONG, 0, "null")
+ZEND_ARG_TYPE_MASK(0, nbytes, MAY_BE_ARRAY | MAY_BE_LONG | MAY_BE_NULL, "null")
 ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, vcount, IS_LONG, 0, "null")
 ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, offset, IS_LONG, 0, "null")
 ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_readStream, 0, 0, 4)
+ZEND_ARG_TYPE_INFO(0, stream, IS_RESOURCE, 0)
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, nbytes, IS_LONG, 1, "null")
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, offset, IS_LONG, 1, "null")
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_addWriteStream, 0, 0, 4)
 ZEND_ARG_TYPE_INFO(0, stream, IS_RESOURCE, 0)
-ZEND_ARG_TYPE_INFO(0, contents, IS_STRING, 0)
+ZEND_ARG_TYPE_MASK(0, contents, MAY_BE_ARRAY | MAY_BE_STRING, NULL)
 ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, vcount, IS_LONG, 0, "null")
 ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_writev, 0, 0, 2)
 ZEND_ARG_TYPE_INFO(0, fd, IS_LONG | IS_RESOURCE, 0)
-ZEND_ARG_TYPE_INFO(0, contents, IS_STRING, 0)
+ZEND_ARG_TYPE_MASK(0, contents, MAY_BE_ARRAY | MAY_BE_STRING, NULL)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_sendFile, 0, 0, 5)
+ZEND_ARG_INFO(0, file)
+ZEND_ARG_INFO(0, socket)
+ZEND_ARG_TYPE_INFO(0, offset, IS_LONG, 0)
+ZEND_ARG_TYPE_INFO(0, length, IS_LONG, 1)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_pipe, 0, 0, 4)
+ZEND_ARG_INFO(0, src)
+ZEND_ARG_INFO(0, dst)
+ZEND_ARG_TYPE_INFO(0, options, IS_ARRAY, 1)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_openFile, 0, 0, 3)
+ZEND_ARG_TYPE_INFO(0, path, IS_STRING, 0)
+ZEND_ARG_TYPE_INFO(0, mode, IS_STRING, 0)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_stat, 0, 0, 2)
+ZEND_ARG_TYPE_INFO(0, path, IS_STRING, 0)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_fsync, 0, 0, 2)
+ZEND_ARG_INFO(0, file)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Mrloop_fdatasync arginfo_class_Mrloop_fsync
+
+#define arginfo_class_Mrloop_close arginfo_class_Mrloop_fsync
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_rename, 0, 0, 3)
+ZEND_ARG_TYPE_INFO(0, from, IS_STRING, 0)
+ZEND_ARG_TYPE_INFO(0, to, IS_STRING, 0)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Mrloop_unlink arginfo_class_Mrloop_stat
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_registerFiles, 0, 0, 1)
+ZEND_ARG_TYPE_INFO(0, files, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_registerBuffers, 0, 0, 2)
+ZEND_ARG_TYPE_INFO(0, count, IS_LONG, 0)
+ZEND_ARG_TYPE_INFO(0, size, IS_LONG, 0)
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_futureTick, 0, 0, 1)
 ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_ARG_VARIADIC_INFO(0, args)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_stats, 0, 0, 0)
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, reset, _IS_BOOL, 0, "false")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_readAsync, 0, 0, 1)
+ZEND_ARG_INFO(0, file)
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, nbytes, IS_LONG, 1, "null")
+ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, offset, IS_LONG, 1, "null")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_writeAsync, 0, 0, 2)
+ZEND_ARG_INFO(0, file)
+ZEND_ARG_TYPE_INFO(0, contents, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_sleep, 0, 0, 1)
+ZEND_ARG_TYPE_INFO(0, seconds, IS_DOUBLE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Mrloop_accept, 0, 0, 1)
+ZEND_ARG_TYPE_INFO(0, server, IS_RESOURCE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Connection_write, 0, 0, 1)
+ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Connection_read, 0, 0, 1)
+ZEND_ARG_TYPE_INFO(0, callback, IS_CALLABLE, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Connection_release, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Connection_close, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Connection_remoteAddress, 0, 0, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Connection_remotePort, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Connection_fd, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_class_Timer_cancel, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+#define arginfo_class_Timer_reset arginfo_class_Timer_cancel
+
+#define arginfo_class_Timer_isActive arginfo_class_Timer_cancel
+
 ZEND_METHOD(Mrloop, init);
 ZEND_METHOD(Mrloop, stop);
 ZEND_METHOD(Mrloop, run);
+ZEND_METHOD(Mrloop, batch);
+ZEND_METHOD(Mrloop, flush);
 ZEND_METHOD(Mrloop, addTimer);
 ZEND_METHOD(Mrloop, addPeriodicTimer);
 ZEND_METHOD(Mrloop, tcpServer);
+ZEND_METHOD(Mrloop, httpServer);
+ZEND_METHOD(Mrloop, udpServer);
+ZEND_METHOD(Mrloop, connect);
 ZEND_METHOD(Mrloop, addSignal);
 ZEND_METHOD(Mrloop, addReadStream);
+ZEND_METHOD(Mrloop, readStream);
 ZEND_METHOD(Mrloop, addWriteStream);
 ZEND_METHOD(Mrloop, writev);
+ZEND_METHOD(Mrloop, sendFile);
+ZEND_METHOD(Mrloop, pipe);
+ZEND_METHOD(Mrloop, openFile);
+ZEND_METHOD(Mrloop, stat);
+ZEND_METHOD(Mrloop, fsync);
+ZEND_METHOD(Mrloop, fdatasync);
+ZEND_METHOD(Mrloop, close);
+ZEND_METHOD(Mrloop, rename);
+ZEND_METHOD(Mrloop, unlink);
+ZEND_METHOD(Mrloop, registerFiles);
+ZEND_METHOD(Mrloop, registerBuffers);
 ZEND_METHOD(Mrloop, futureTick);
+ZEND_METHOD(Mrloop, stats);
+ZEND_METHOD(Mrloop, readAsync);
+ZEND_METHOD(Mrloop, writeAsync);
+ZEND_METHOD(Mrloop, sleep);
+ZEND_METHOD(Mrloop, accept);
+ZEND_METHOD(Connection, write);
+ZEND_METHOD(Connection, read);
+ZEND_METHOD(Connection, release);
+ZEND_METHOD(Connection, close);
+ZEND_METHOD(Connection, remoteAddress);
+ZEND_METHOD(Connection, remotePort);
+ZEND_METHOD(Connection, fd);
+ZEND_METHOD(Timer, cancel);
+ZEND_METHOD(Timer, reset);
+ZEND_METHOD(Timer, isActive);
 
 static const zend_function_entry class_Mrloop_methods[] = {
   PHP_ME(Mrloop, init, arginfo_class_Mrloop_init, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(Mrloop, stop, arginfo_class_Mrloop_stop, ZEND_ACC_PUBLIC)
       PHP_ME(Mrloop, run, arginfo_class_Mrloop_run, ZEND_ACC_PUBLIC)
-        PHP_ME(Mrloop, addTimer, arginfo_class_Mrloop_addTimer, ZEND_ACC_PUBLIC)
-          PHP_ME(Mrloop, addPeriodicTimer, arginfo_class_Mrloop_addPeriodicTimer, ZEND_ACC_PUBLIC)
-            PHP_ME(Mrloop, tcpServer, arginfo_class_Mrloop_tcpServer, ZEND_ACC_PUBLIC)
-              PHP_ME(Mrloop, addSignal, arginfo_class_Mrloop_addSignal, ZEND_ACC_PUBLIC)
-                PHP_ME(Mrloop, addReadStream, arginfo_class_Mrloop_addReadStream, ZEND_ACC_PUBLIC)
-                  PHP_ME(Mrloop, addWriteStream, arginfo_class_Mrloop_addWriteStream, ZEND_ACC_PUBLIC)
-                    PHP_ME(Mrloop, writev, arginfo_class_Mrloop_writev, ZEND_ACC_PUBLIC)
-                      PHP_ME(Mrloop, futureTick, arginfo_class_Mrloop_futureTick, ZEND_ACC_PUBLIC)
-                        PHP_FE_END};
+        PHP_ME(Mrloop, batch, arginfo_class_Mrloop_batch, ZEND_ACC_PUBLIC)
+          PHP_ME(Mrloop, flush, arginfo_class_Mrloop_flush, ZEND_ACC_PUBLIC)
+            PHP_ME(Mrloop, addTimer, arginfo_class_Mrloop_addTimer, ZEND_ACC_PUBLIC)
+              PHP_ME(Mrloop, addPeriodicTimer, arginfo_class_Mrloop_addPeriodicTimer, ZEND_ACC_PUBLIC)
+                PHP_ME(Mrloop, tcpServer, arginfo_class_Mrloop_tcpServer, ZEND_ACC_PUBLIC)
+                  PHP_ME(Mrloop, httpServer, arginfo_class_Mrloop_httpServer, ZEND_ACC_PUBLIC)
+                    PHP_ME(Mrloop, udpServer, arginfo_class_Mrloop_udpServer, ZEND_ACC_PUBLIC)
+                      PHP_ME(Mrloop, connect, arginfo_class_Mrloop_connect, ZEND_ACC_PUBLIC)
+                        PHP_ME(Mrloop, addSignal, arginfo_class_Mrloop_addSignal, ZEND_ACC_PUBLIC)
+                          PHP_ME(Mrloop, addReadStream, arginfo_class_Mrloop_addReadStream, ZEND_ACC_PUBLIC)
+                            PHP_ME(Mrloop, readStream, arginfo_class_Mrloop_readStream, ZEND_ACC_PUBLIC)
+                              PHP_ME(Mrloop, addWriteStream, arginfo_class_Mrloop_addWriteStream, ZEND_ACC_PUBLIC)
+                                PHP_ME(Mrloop, writev, arginfo_class_Mrloop_writev, ZEND_ACC_PUBLIC)
+                                  PHP_ME(Mrloop, sendFile, arginfo_class_Mrloop_sendFile, ZEND_ACC_PUBLIC)
+                                    PHP_ME(Mrloop, pipe, arginfo_class_Mrloop_pipe, ZEND_ACC_PUBLIC)
+                                      PHP_ME(Mrloop, openFile, arginfo_class_Mrloop_openFile, ZEND_ACC_PUBLIC)
+                                        PHP_ME(Mrloop, stat, arginfo_class_Mrloop_stat, ZEND_ACC_PUBLIC)
+                                          PHP_ME(Mrloop, fsync, arginfo_class_Mrloop_fsync, ZEND_ACC_PUBLIC)
+                                            PHP_ME(Mrloop, fdatasync, arginfo_class_Mrloop_fdatasync, ZEND_ACC_PUBLIC)
+                                              PHP_ME(Mrloop, close, arginfo_class_Mrloop_close, ZEND_ACC_PUBLIC)
+                                                PHP_ME(Mrloop, rename, arginfo_class_Mrloop_rename, ZEND_ACC_PUBLIC)
+                                                  PHP_ME(Mrloop, unlink, arginfo_class_Mrloop_unlink, ZEND_ACC_PUBLIC)
+                                                    PHP_ME(Mrloop, registerFiles, arginfo_class_Mrloop_registerFiles, ZEND_ACC_PUBLIC)
+                                                      PHP_ME(Mrloop, registerBuffers, arginfo_class_Mrloop_registerBuffers, ZEND_ACC_PUBLIC)
+                                                        PHP_ME(Mrloop, futureTick, arginfo_class_Mrloop_futureTick, ZEND_ACC_PUBLIC)
+                                                          PHP_ME(Mrloop, stats, arginfo_class_Mrloop_stats, ZEND_ACC_PUBLIC)
+                                                            PHP_ME(Mrloop, readAsync, arginfo_class_Mrloop_readAsync, ZEND_ACC_PUBLIC)
+                                                              PHP_ME(Mrloop, writeAsync, arginfo_class_Mrloop_writeAsync, ZEND_ACC_PUBLIC)
+                                                                PHP_ME(Mrloop, sleep, arginfo_class_Mrloop_sleep, ZEND_ACC_PUBLIC)
+                                                                  PHP_ME(Mrloop, accept, arginfo_class_Mrloop_accept, ZEND_ACC_PUBLIC)
+                                                                    PHP_FE_END};
+
+static const zend_function_entry class_Connection_methods[] = {
+  PHP_ME(Connection, write, arginfo_class_Connection_write, ZEND_ACC_PUBLIC)
+    PHP_ME(Connection, read, arginfo_class_Connection_read, ZEND_ACC_PUBLIC)
+      PHP_ME(Connection, release, arginfo_class_Connection_release, ZEND_ACC_PUBLIC)
+        PHP_ME(Connection, close, arginfo_class_Connection_close, ZEND_ACC_PUBLIC)
+          PHP_ME(Connection, remoteAddress, arginfo_class_Connection_remoteAddress, ZEND_ACC_PUBLIC)
+            PHP_ME(Connection, remotePort, arginfo_class_Connection_remotePort, ZEND_ACC_PUBLIC)
+              PHP_ME(Connection, fd, arginfo_class_Connection_fd, ZEND_ACC_PUBLIC)
+                PHP_FE_END};
+
+static const zend_function_entry class_Timer_methods[] = {
+  PHP_ME(Timer, cancel, arginfo_class_Timer_cancel, ZEND_ACC_PUBLIC)
+    PHP_ME(Timer, reset, arginfo_class_Timer_reset, ZEND_ACC_PUBLIC)
+      PHP_ME(Timer, isActive, arginfo_class_Timer_isActive, ZEND_ACC_PUBLIC)
+        PHP_FE_END};
@@ -4,10 +4,19 @@
 #endif
 
 #include "src/loop.c"
+#include "src/uring.c"
+#include "src/slab.c"
+#include "src/stats.c"
+#include "src/http.c"
+#include "src/udp.c"
+#include "src/client.c"
+#include "src/timer.c"
+#include "src/file.c"
+#include "src/fiber.c"
 #include "php_mrloop.h"
 #include "mrloop_arginfo.h"
 
-/* {{{ proto Mrloop Mrloop::init() */
+/* {{{ proto Mrloop Mrloop::init( [ ?array options ] ) */
 PHP_METHOD(Mrloop, init)
 {
   php_mrloop_create(INTERNAL_FUNCTION_PARAM_PASSTHRU);
@@ -21,6 +30,20 @@ PHP_METHOD(Mrloop, run)
 }
 /* }}} */
 
+/* {{{ proto mixed Mrloop::batch( callable callback ) */
+PHP_METHOD(Mrloop, batch)
+{
+  php_mrloop_batch(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::flush() */
+PHP_METHOD(Mrloop, flush)
+{
+  php_mrloop_flush(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
 /* {{{ proto void Mrloop::stop() */
 PHP_METHOD(Mrloop, stop)
 {
@@ -28,27 +51,48 @@ PHP_METHOD(Mrloop, stop)
 }
 /* }}} */
 
-/* {{{ proto void Mrloop::addTimer( float interval [, callable callback ] ) */
+/* {{{ proto Timer Mrloop::addTimer( float interval [, callable callback ] ) */
 PHP_METHOD(Mrloop, addTimer)
 {
-  php_mrloop_add_timer(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+  php_mrloop_timer_add(INTERNAL_FUNCTION_PARAM_PASSTHRU, false);
 }
 /* }}} */
 
-/* {{{ proto void Mrloop::addPeriodicTimer( float interval [, callable callback ] ) */
+/* {{{ proto Timer Mrloop::addPeriodicTimer( float interval [, callable callback ] ) */
 PHP_METHOD(Mrloop, addPeriodicTimer)
 {
-  php_mrloop_add_periodic_timer(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+  php_mrloop_timer_add(INTERNAL_FUNCTION_PARAM_PASSTHRU, true);
 }
 /* }}} */
 
-/* {{{ proto void Mrloop::tcpServer( int port [, callable callback ] ) */
+/* {{{ proto void Mrloop::tcpServer( int|string address [, ?int connections [, ?int nbytes [, callable callback [, ?array options ]]]] ) */
 PHP_METHOD(Mrloop, tcpServer)
 {
   php_mrloop_tcp_server_listen(INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 /* }}} */
 
+/* {{{ proto void Mrloop::httpServer( int|string address [, ?int connections [, ?int nbytes [, callable callback [, ?array options ]]]] ) */
+PHP_METHOD(Mrloop, httpServer)
+{
+  php_mrloop_http_server_listen(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::udpServer( int|string address [, callable callback [, ?array options ]] ) */
+PHP_METHOD(Mrloop, udpServer)
+{
+  php_mrloop_udp_server_listen(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::connect( string host, int port, callable callback [, ?array options ] ) */
+PHP_METHOD(Mrloop, connect)
+{
+  php_mrloop_connect(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
 /* {{{ proto void Mrloop::addSignal( int signal [, callable callback ] ) */
 PHP_METHOD(Mrloop, addSignal)
 {
@@ -56,48 +100,258 @@ PHP_METHOD(Mrloop, addSignal)
 }
 /* }}} */
 
-/* {{{ proto void Mrloop::addReadStream( resource stream [, ?int nbytes = null [, callable callback ]] ) */
+/* {{{ proto void Mrloop::addReadStream( resource stream [, array|int|null nbytes = null [, ?int vcount [, ?int offset [, callable callback ]]]] ) */
 PHP_METHOD(Mrloop, addReadStream)
 {
   php_mrloop_add_read_stream(INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 /* }}} */
 
-/* {{{ proto void Mrloop::addWriteStream( resource stream [, string contents [, callable callback ]] ) */
+/* {{{ proto void Mrloop::readStream( resource stream [, ?int nbytes [, ?int offset [, callable callback ]]] ) */
+PHP_METHOD(Mrloop, readStream)
+{
+  php_mrloop_read_stream(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::addWriteStream( resource stream [, array|string contents [, ?int vcount [, callable callback ]]] ) */
 PHP_METHOD(Mrloop, addWriteStream)
 {
   php_mrloop_add_write_stream(INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 /* }}} */
 
-/* {{{ proto void Mrloop::writev( int fd [, string contents ] ) */
+/* {{{ proto void Mrloop::writev( int|resource fd [, array|string contents ] ) */
 PHP_METHOD(Mrloop, writev)
 {
   php_mrloop_writev(INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 /* }}} */
 
-/* {{{ proto void Mrloop::futureTick( callable callback ) */
+/* {{{ proto void Mrloop::sendFile( int|resource file, int|resource|Connection socket, int offset, ?int length, callable callback ) */
+PHP_METHOD(Mrloop, sendFile)
+{
+  php_mrloop_send_file(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::pipe( int|resource|Connection src, int|resource|Connection dst [, ?array options [, callable callback ]] ) */
+PHP_METHOD(Mrloop, pipe)
+{
+  php_mrloop_pipe(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::openFile( string path, string mode, callable callback ) */
+PHP_METHOD(Mrloop, openFile)
+{
+  php_mrloop_open_file(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::stat( string path, callable callback ) */
+PHP_METHOD(Mrloop, stat)
+{
+  php_mrloop_stat(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::fsync( int|resource file, callable callback ) */
+PHP_METHOD(Mrloop, fsync)
+{
+  php_mrloop_fsync(INTERNAL_FUNCTION_PARAM_PASSTHRU, false);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::fdatasync( int|resource file, callable callback ) */
+PHP_METHOD(Mrloop, fdatasync)
+{
+  php_mrloop_fsync(INTERNAL_FUNCTION_PARAM_PASSTHRU, true);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::close( int|resource file, callable callback ) */
+PHP_METHOD(Mrloop, close)
+{
+  php_mrloop_close(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::rename( string from, string to, callable callback ) */
+PHP_METHOD(Mrloop, rename)
+{
+  php_mrloop_rename(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::unlink( string path, callable callback ) */
+PHP_METHOD(Mrloop, unlink)
+{
+  php_mrloop_unlink(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::registerFiles( array files ) */
+PHP_METHOD(Mrloop, registerFiles)
+{
+  php_mrloop_register_files(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::registerBuffers( int count, int size ) */
+PHP_METHOD(Mrloop, registerBuffers)
+{
+  php_mrloop_register_buffers(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::futureTick( callable callback [, mixed ...args ] ) */
 PHP_METHOD(Mrloop, futureTick)
 {
   php_mrloop_add_future_tick(INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 /* }}} */
 
+/* {{{ proto array Mrloop::stats( [ bool reset = false ] ) */
+PHP_METHOD(Mrloop, stats)
+{
+  php_mrloop_stats(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto string Mrloop::readAsync( resource|int|Connection file [, ?int nbytes = null [, ?int offset = null ]] ) */
+PHP_METHOD(Mrloop, readAsync)
+{
+  php_mrloop_read_async(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto int Mrloop::writeAsync( resource|int|Connection file, string contents ) */
+PHP_METHOD(Mrloop, writeAsync)
+{
+  php_mrloop_write_async(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Mrloop::sleep( float seconds ) */
+PHP_METHOD(Mrloop, sleep)
+{
+  php_mrloop_sleep(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto resource Mrloop::accept( resource server ) */
+PHP_METHOD(Mrloop, accept)
+{
+  php_mrloop_accept(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Connection::write( string data ) */
+PHP_METHOD(Connection, write)
+{
+  php_mrloop_conn_write(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Connection::read( callable callback ) */
+PHP_METHOD(Connection, read)
+{
+  php_mrloop_conn_read(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Connection::release() */
+PHP_METHOD(Connection, release)
+{
+  php_mrloop_conn_release(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Connection::close() */
+PHP_METHOD(Connection, close)
+{
+  php_mrloop_conn_close(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto string Connection::remoteAddress() */
+PHP_METHOD(Connection, remoteAddress)
+{
+  php_mrloop_conn_remote_address(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto int Connection::remotePort() */
+PHP_METHOD(Connection, remotePort)
+{
+  php_mrloop_conn_remote_port(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto int Connection::fd() */
+PHP_METHOD(Connection, fd)
+{
+  php_mrloop_conn_fd(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Timer::cancel() */
+PHP_METHOD(Timer, cancel)
+{
+  php_mrloop_timer_cancel(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto void Timer::reset() */
+PHP_METHOD(Timer, reset)
+{
+  php_mrloop_timer_reset(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
+/* {{{ proto bool Timer::isActive() */
+PHP_METHOD(Timer, isActive)
+{
+  php_mrloop_timer_is_active(INTERNAL_FUNCTION_PARAM_PASSTHRU);
+}
+/* }}} */
+
 /* {{{ PHP_MINIT_FUNCTION */
 PHP_MINIT_FUNCTION(mrloop)
 {
-  zend_class_entry ce, exception_ce;
+  zend_class_entry ce, conn_ce, timer_ce, exception_ce;
 
   INIT_NS_CLASS_ENTRY(ce, "ringphp", "Mrloop", class_Mrloop_methods);
+  INIT_NS_CLASS_ENTRY(conn_ce, "ringphp", "Connection", class_Connection_methods);
+  INIT_NS_CLASS_ENTRY(timer_ce, "ringphp", "Timer", class_Timer_methods);
   INIT_CLASS_ENTRY(exception_ce, "MrloopException", NULL);
 
   php_mrloop_ce = zend_register_internal_class(&ce);
   php_mrloop_ce->create_object = php_mrloop_create_object;
 
   memcpy(&php_mrloop_object_handlers, zend_get_std_object_handlers(), sizeof(php_mrloop_object_handlers));
+  php_mrloop_object_handlers.offset = XtOffsetOf(php_mrloop_t, std);
   php_mrloop_object_handlers.free_obj = php_mrloop_free_object;
 
+  php_mrloop_conn_ce = zend_register_internal_class(&conn_ce);
+  php_mrloop_conn_ce->ce_flags |= ZEND_ACC_FINAL;
+  php_mrloop_conn_ce->create_object = php_mrloop_conn_create_object;
+
+  memcpy(&php_mrloop_conn_object_handlers, zend_get_std_object_handlers(), sizeof(php_mrloop_conn_object_handlers));
+  php_mrloop_conn_object_handlers.offset = XtOffsetOf(php_mrloop_conn_t, std);
+  php_mrloop_conn_object_handlers.free_obj = php_mrloop_conn_free_object;
+  php_mrloop_conn_object_handlers.clone_obj = NULL;
+
+  php_mrloop_timer_ce = zend_register_internal_class(&timer_ce);
+  php_mrloop_timer_ce->ce_flags |= ZEND_ACC_FINAL;
+  php_mrloop_timer_ce->create_object = php_mrloop_timer_create_object;
+
+  memcpy(&php_mrloop_timer_object_handlers, zend_get_std_object_handlers(), sizeof(php_mrloop_timer_object_handlers));
+  php_mrloop_timer_object_handlers.offset = XtOffsetOf(php_mrloop_timer_t, std);
+  php_mrloop_timer_object_handlers.free_obj = php_mrloop_timer_free_object;
+  php_mrloop_timer_object_handlers.clone_obj = NULL;
+
 #ifdef HAVE_SPL
   php_mrloop_exception_ce = zend_register_internal_class_ex(&exception_ce, spl_ce_RuntimeException);
 #else
@@ -133,18 +387,8 @@ PHP_RINIT_FUNCTION(mrloop)
 /* {{{ PHP_RSHUTDOWN_FUNCTION */
 PHP_RSHUTDOWN_FUNCTION(mrloop)
 {
-  if (MRLOOP_G(tcp_cb))
-  {
-    efree(MRLOOP_G(tcp_cb));
-  }
-
-  if (MRLOOP_G(sigc) > 0)
-  {
-    for (size_t idx = 0; idx < MRLOOP_G(sigc); idx++)
-    {
-      efree(MRLOOP_G(sig_cb)[idx]);
-    }
-  }
+  // signal callbacks are released along with the event loops to which they belong
+  MRLOOP_G(sig_loops) = NULL;
 
   return SUCCESS;
 }
@@ -157,6 +401,11 @@ PHP_MINFO_FUNCTION(mrloop)
   php_info_print_table_header(2, "mrloop support", "enabled");
   php_info_print_table_header(2, "mrloop version", MRLOOP_VERSION);
   php_info_print_table_header(2, "mrloop author", MRLOOP_AUTHOR);
+#ifdef HAVE_MRLOOP_STATS
+  php_info_print_table_header(2, "mrloop statistics", "enabled");
+#else
+  php_info_print_table_header(2, "mrloop statistics", "disabled");
+#endif
   php_info_print_table_end();
 }
 /* }}} */
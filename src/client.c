@@ -0,0 +1,732 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#include "client.h"
+
+static int php_mrloop_client_address(zend_string *host, zend_long port, php_sockaddr_storage_t *addr, socklen_t *addrlen)
+{
+  php_sockaddr_un_t *un;
+  char name[INET6_ADDRSTRLEN];
+  const char *spec;
+  size_t len;
+
+  memset(addr, 0, sizeof(php_sockaddr_storage_t));
+
+  spec = ZSTR_VAL(host);
+  len = ZSTR_LEN(host);
+
+  if (len > 7 && strncmp(spec, "unix://", 7) == 0)
+  {
+    un = (php_sockaddr_un_t *)addr;
+    if (len - 7 >= sizeof(un->sun_path))
+    {
+      return FAILURE;
+    }
+
+    un->sun_family = AF_UNIX;
+    memcpy(un->sun_path, spec + 7, len - 7);
+    *addrlen = (socklen_t)(offsetof(php_sockaddr_un_t, sun_path) + len - 7 + 1);
+
+    return SUCCESS;
+  }
+
+  if (port < 0 || port > 65535)
+  {
+    return FAILURE;
+  }
+
+  if (len > 1 && spec[0] == '[' && spec[len - 1] == ']')
+  {
+    spec++;
+    len -= 2;
+  }
+
+  if (len > 0 && len < INET6_ADDRSTRLEN)
+  {
+    memcpy(name, spec, len);
+    name[len] = '\0';
+
+    if (inet_pton(AF_INET, name, &((php_sockaddr_t *)addr)->sin_addr) == 1)
+    {
+      ((php_sockaddr_t *)addr)->sin_family = AF_INET;
+      ((php_sockaddr_t *)addr)->sin_port = htons((uint16_t)port);
+      *addrlen = sizeof(php_sockaddr_t);
+
+      return SUCCESS;
+    }
+
+    if (inet_pton(AF_INET6, name, &((php_sockaddr_in6_t *)addr)->sin6_addr) == 1)
+    {
+      ((php_sockaddr_in6_t *)addr)->sin6_family = AF_INET6;
+      ((php_sockaddr_in6_t *)addr)->sin6_port = htons((uint16_t)port);
+      *addrlen = sizeof(php_sockaddr_in6_t);
+
+      return SUCCESS;
+    }
+  }
+
+  // host names are resolved by a lookup; an empty one is no name at all
+  if (len == 0 || memchr(spec, '\0', len) != NULL)
+  {
+    return FAILURE;
+  }
+
+  *addrlen = 0;
+
+  return SUCCESS;
+}
+static php_mrloop_conn_t *php_mrloop_client_init(php_mrloop_t *evloop, int fd, zend_string *host, zend_long port, zend_string *key)
+{
+  php_mrloop_conn_t *conn;
+
+  // as with accepted connections, the event loop holds the initial reference until the socket is closed
+  conn = php_mrloop_conn_from_obj(php_mrloop_conn_create_object(php_mrloop_conn_ce));
+  conn->fd = fd;
+  conn->closing = false;
+  php_mrloop_conn_link(evloop, conn);
+  conn->addr = estrndup(ZSTR_VAL(host), ZSTR_LEN(host));
+  conn->port = (size_t)port;
+  conn->pool_key = key;
+  conn->buff_size = DEFAULT_CONN_BUFF_LEN;
+  conn->buffer = emalloc(conn->buff_size);
+
+  conn->recv_op.handler = php_mrloop_client_read_cb;
+  conn->recv_op.data = conn;
+  conn->write_op.handler = php_mrloop_tcp_client_send_cb;
+  conn->write_op.data = conn;
+
+  return conn;
+}
+static const char *php_mrloop_client_dial(php_mrloop_connect_t *attempt, zend_string *host, zend_long port, zend_string *key)
+{
+  struct io_uring_sqe *sqe, *timeout;
+  int fd;
+
+  if ((fd = socket(attempt->addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+  {
+    zend_string_release(key);
+    return strerror(errno);
+  }
+
+  attempt->conn = php_mrloop_client_init(attempt->evloop, fd, host, port, key);
+  attempt->op.handler = php_mrloop_client_connect_cb;
+
+  // the connect operation and its linked timeout are queued together (a full queue would be flushed between them)
+  if (attempt->timed && io_uring_sq_space_left(&attempt->evloop->uring->ring) < 2)
+  {
+    PHP_MRLOOP_STATS_SUBMIT(attempt->evloop, io_uring_submit(&attempt->evloop->uring->ring));
+  }
+
+  if ((sqe = php_mrloop_uring_sqe(attempt->evloop, &attempt->op)) == NULL)
+  {
+    php_mrloop_tcp_client_close(attempt->conn);
+    attempt->conn = NULL;
+
+    return "Could not acquire submission queue entry";
+  }
+
+  io_uring_prep_connect(sqe, fd, (struct sockaddr *)&attempt->addr, attempt->addrlen);
+
+  // otherwise, a connection to an unresponsive host is only abandoned once the kernel runs out of SYN retransmissions
+  if (attempt->timed)
+  {
+    sqe->flags |= IOSQE_IO_LINK;
+
+    if ((timeout = php_mrloop_uring_sqe(attempt->evloop, NULL)) != NULL)
+    {
+      io_uring_prep_link_timeout(timeout, &attempt->ts, 0);
+    }
+    else
+    {
+      sqe->flags &= ~IOSQE_IO_LINK;
+    }
+  }
+
+  php_mrloop_uring_submit(attempt->evloop);
+
+  return NULL;
+}
+static void php_mrloop_client_convey(php_mrloop_connect_t *attempt, php_mrloop_conn_t *conn, const char *error)
+{
+  php_mrloop_cb_t *cb = attempt->cb;
+  zval args[2], result;
+
+  if (error)
+  {
+    ZVAL_NULL(&args[0]);
+    ZVAL_STRING(&args[1], error);
+  }
+  else
+  {
+    ZVAL_OBJ_COPY(&args[0], &conn->std);
+    ZVAL_NULL(&args[1]);
+  }
+
+  cb->fci.retval = &result;
+  cb->fci.param_count = 2;
+  cb->fci.params = args;
+
+  if (php_mrloop_call(attempt->evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("There is an error in your callback");
+  }
+
+  zval_ptr_dtor(&result);
+  zval_ptr_dtor(&args[0]);
+  zval_ptr_dtor(&args[1]);
+
+  if (attempt->host)
+  {
+    zend_string_release(attempt->host);
+  }
+  PHP_MRLOOP_CB_FREE(cb);
+  efree(attempt);
+}
+static void php_mrloop_client_connect_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_connect_t *attempt = (php_mrloop_connect_t *)op->data;
+  php_mrloop_conn_t *conn = attempt->conn;
+
+  // a connect operation cut short by its linked timeout is cancelled
+  php_mrloop_client_convey(
+    attempt,
+    conn,
+    cqe->res == -ECANCELED && attempt->timed ? strerror(ETIMEDOUT) : cqe->res < 0 ? strerror(-cqe->res) : NULL);
+
+  if (cqe->res < 0)
+  {
+    php_mrloop_tcp_client_close(conn);
+  }
+}
+static int php_mrloop_client_resolve(php_mrloop_t *evloop, php_mrloop_connect_t *attempt)
+{
+  php_mrloop_lookup_t *lookup;
+  struct io_uring_sqe *sqe;
+  pthread_attr_t attr;
+  pthread_t thread;
+  sigset_t mask, omask;
+  int ret;
+
+  if ((lookup = malloc(sizeof(php_mrloop_lookup_t))) == NULL ||
+      (lookup->host = strndup(ZSTR_VAL(attempt->host), ZSTR_LEN(attempt->host))) == NULL)
+  {
+    free(lookup);
+    PHP_MRLOOP_THROW(strerror(ENOMEM));
+
+    return FAILURE;
+  }
+
+  lookup->port = (uint16_t)attempt->port;
+  lookup->status = 0;
+  lookup->addrlen = 0;
+  lookup->refcount = 2;
+
+  if ((lookup->efd = eventfd(0, EFD_CLOEXEC)) < 0)
+  {
+    free(lookup->host);
+    free(lookup);
+    PHP_MRLOOP_THROW(strerror(errno));
+
+    return FAILURE;
+  }
+
+  // signals are left to the event loop's thread (and its signalfd)
+  sigfillset(&mask);
+  pthread_sigmask(SIG_SETMASK, &mask, &omask);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  ret = pthread_create(&thread, &attr, php_mrloop_client_resolve_thread, lookup);
+  pthread_attr_destroy(&attr);
+
+  pthread_sigmask(SIG_SETMASK, &omask, NULL);
+
+  if (ret != 0)
+  {
+    close(lookup->efd);
+    free(lookup->host);
+    free(lookup);
+    PHP_MRLOOP_THROW(strerror(ret));
+
+    return FAILURE;
+  }
+
+  // a lookup which completes before the read is issued leaves the eventfd readable; the read then completes at once
+  attempt->op.handler = php_mrloop_client_resolve_cb;
+  if ((sqe = php_mrloop_uring_sqe(evloop, &attempt->op)) == NULL)
+  {
+    php_mrloop_lookup_release(lookup);
+    PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+
+    return FAILURE;
+  }
+
+  io_uring_prep_read(sqe, lookup->efd, &attempt->counter, sizeof(uint64_t), 0);
+  php_mrloop_uring_submit(evloop);
+
+  attempt->lookup = lookup;
+
+  attempt->sibling = evloop->lookups;
+  if (attempt->sibling)
+  {
+    attempt->sibling->psibling = &attempt->sibling;
+  }
+  attempt->psibling = &evloop->lookups;
+  evloop->lookups = attempt;
+
+  return SUCCESS;
+}
+static void *php_mrloop_client_resolve_thread(void *data)
+{
+  php_mrloop_lookup_t *lookup = (php_mrloop_lookup_t *)data;
+  php_addrinfo_t hints, *res;
+  uint64_t one = 1;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  if ((lookup->status = getaddrinfo(lookup->host, NULL, &hints, &res)) == 0)
+  {
+    memcpy(&lookup->addr, res->ai_addr, res->ai_addrlen);
+    lookup->addrlen = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    if (lookup->addr.ss_family == AF_INET6)
+    {
+      ((php_sockaddr_in6_t *)&lookup->addr)->sin6_port = htons(lookup->port);
+    }
+    else
+    {
+      ((php_sockaddr_t *)&lookup->addr)->sin_port = htons(lookup->port);
+    }
+  }
+
+  // the write publishes the result to the event loop's thread, which reads it once the eventfd read completes (it
+  // cannot fail, as a single write does not overflow the counter)
+  ZEND_IGNORE_VALUE(write(lookup->efd, &one, sizeof(uint64_t)));
+
+  php_mrloop_lookup_release(lookup);
+
+  return NULL;
+}
+static void php_mrloop_client_resolve_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_connect_t *attempt = (php_mrloop_connect_t *)op->data;
+  php_mrloop_lookup_t *lookup = attempt->lookup;
+  zend_string *key = attempt->key;
+  const char *error = NULL;
+
+  *attempt->psibling = attempt->sibling;
+  if (attempt->sibling)
+  {
+    attempt->sibling->psibling = attempt->psibling;
+  }
+  attempt->lookup = NULL;
+  attempt->key = NULL;
+
+  if (cqe->res < 0)
+  {
+    error = strerror(-cqe->res);
+  }
+  else if (lookup->status != 0)
+  {
+    error = gai_strerror(lookup->status);
+  }
+  else
+  {
+    memcpy(&attempt->addr, &lookup->addr, lookup->addrlen);
+    attempt->addrlen = lookup->addrlen;
+
+    // the connection takes over the pool key
+    error = php_mrloop_client_dial(attempt, attempt->host, attempt->port, key);
+    key = NULL;
+  }
+
+  php_mrloop_lookup_release(lookup);
+
+  if (key)
+  {
+    zend_string_release(key);
+  }
+
+  if (error)
+  {
+    php_mrloop_client_convey(attempt, NULL, error);
+  }
+}
+static void php_mrloop_lookup_release(php_mrloop_lookup_t *lookup)
+{
+  if (__atomic_sub_fetch(&lookup->refcount, 1, __ATOMIC_ACQ_REL) > 0)
+  {
+    return;
+  }
+
+  close(lookup->efd);
+  free(lookup->host);
+  free(lookup);
+}
+static void php_mrloop_lookups_free(php_mrloop_t *evloop)
+{
+  php_mrloop_connect_t *attempt;
+
+  // in a forked worker, the resolver threads (which are not forked) never drop their references; the lookups leak
+  while ((attempt = evloop->lookups) != NULL)
+  {
+    evloop->lookups = attempt->sibling;
+
+    php_mrloop_lookup_release(attempt->lookup);
+    zend_string_release(attempt->host);
+    zend_string_release(attempt->key);
+    PHP_MRLOOP_CB_FREE(attempt->cb);
+    efree(attempt);
+  }
+}
+static void php_mrloop_client_read_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_conn_t *conn = (php_mrloop_conn_t *)op->data;
+  php_mrloop_cb_t *cb = conn->read_cb;
+  zval args[1], result;
+
+  conn->recv_armed = false;
+  conn->read_cb = NULL;
+
+  // the callback may close the connection; the context must outlive the processing of this completion
+  GC_ADDREF(&conn->std);
+
+  // reads cancelled by closure of the connection are not reported
+  if (cb && !conn->closing)
+  {
+    if (cqe->res > 0)
+    {
+      ZVAL_STRINGL(&args[0], conn->buffer, cqe->res);
+    }
+    else
+    {
+      ZVAL_EMPTY_STRING(&args[0]);
+    }
+
+    // data written from within the callback is flushed once it returns
+    conn->dispatching = true;
+
+    cb->fci.retval = &result;
+    cb->fci.param_count = 1;
+    cb->fci.params = args;
+
+    if (php_mrloop_call(conn->evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+    {
+      PHP_MRLOOP_THROW("There is an error in your callback");
+    }
+
+    conn->dispatching = false;
+
+    zval_ptr_dtor(&result);
+    zval_ptr_dtor(&args[0]);
+
+    php_mrloop_tcp_client_flush(conn);
+  }
+
+  if (cb)
+  {
+    PHP_MRLOOP_CB_FREE(cb);
+  }
+
+  if (conn->closing)
+  {
+    php_mrloop_tcp_client_release(conn);
+  }
+  else if (cqe->res <= 0)
+  {
+    php_mrloop_tcp_client_close(conn);
+  }
+
+  OBJ_RELEASE(&conn->std);
+}
+static void php_mrloop_connect(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+  php_mrloop_connect_t *attempt;
+  php_mrloop_conn_t *conn;
+  struct io_uring_sqe *sqe;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  zend_string *host, *key;
+  zend_long port;
+  HashTable *options;
+  const char *error;
+  double timeout;
+
+  obj = getThis();
+  options = NULL;
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(3, 4)
+  Z_PARAM_STR(host)
+  Z_PARAM_LONG(port)
+  Z_PARAM_FUNC(fci, fci_cache)
+  Z_PARAM_OPTIONAL
+  Z_PARAM_ARRAY_HT_OR_NULL(options)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if ((timeout = php_mrloop_option_double(options, "timeout", 0)) < 0)
+  {
+    PHP_MRLOOP_THROW("Timeout must not be negative");
+    return;
+  }
+
+  if (php_mrloop_uring(this) == NULL)
+  {
+    return;
+  }
+
+  attempt = emalloc(sizeof(php_mrloop_connect_t));
+  attempt->op.handler = php_mrloop_client_connect_cb;
+  attempt->op.data = attempt;
+  attempt->evloop = this;
+  attempt->conn = NULL;
+  attempt->addrlen = 0;
+  attempt->timed = timeout > 0;
+  attempt->ts.tv_sec = (long long)timeout;
+  attempt->ts.tv_nsec = (long long)((timeout - (double)attempt->ts.tv_sec) * 1e9);
+  attempt->lookup = NULL;
+  attempt->host = NULL;
+  attempt->port = port;
+  attempt->key = NULL;
+  attempt->sibling = NULL;
+  attempt->psibling = NULL;
+
+  key = zend_strpprintf(0, "%s:" ZEND_LONG_FMT, ZSTR_VAL(host), port);
+
+  if ((conn = php_mrloop_pool_checkout(this, key)) != NULL)
+  {
+    zend_string_release(key);
+
+    if ((sqe = php_mrloop_uring_sqe(this, &attempt->op)) == NULL)
+    {
+      php_mrloop_tcp_client_close(conn);
+      efree(attempt);
+      PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+
+      return;
+    }
+
+    // pooled connections are conveyed to the callback just as asynchronously as fresh ones
+    attempt->conn = conn;
+    io_uring_prep_nop(sqe);
+    php_mrloop_uring_submit(this);
+  }
+  else if (php_mrloop_client_address(host, port, &attempt->addr, &attempt->addrlen) == FAILURE)
+  {
+    zend_string_release(key);
+    efree(attempt);
+    PHP_MRLOOP_THROW("Could not resolve remote address");
+
+    return;
+  }
+  else if (attempt->addrlen == 0)
+  {
+    attempt->host = zend_string_copy(host);
+    attempt->key = key;
+
+    if (php_mrloop_client_resolve(this, attempt) == FAILURE)
+    {
+      zend_string_release(attempt->host);
+      zend_string_release(key);
+      efree(attempt);
+
+      return;
+    }
+  }
+  else if ((error = php_mrloop_client_dial(attempt, host, port, key)) != NULL)
+  {
+    efree(attempt);
+    PHP_MRLOOP_THROW(error);
+
+    return;
+  }
+
+  attempt->cb = emalloc(sizeof(php_mrloop_cb_t));
+  PHP_CB_TO_MRLOOP_CB(attempt->cb, fci, fci_cache);
+}
+static void php_mrloop_conn_read(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_conn_t *this;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_CONN_OBJ(getThis());
+
+  if (this->closing || this->pooled || this->evloop == NULL)
+  {
+    PHP_MRLOOP_THROW("Connection is closed");
+    return;
+  }
+
+  if (this->server)
+  {
+    PHP_MRLOOP_THROW("Data received on server connections is conveyed to the server callback");
+    return;
+  }
+
+  if (this->recv_armed)
+  {
+    PHP_MRLOOP_THROW("A read is already pending on the connection");
+    return;
+  }
+
+  this->read_cb = emalloc(sizeof(php_mrloop_cb_t));
+  PHP_CB_TO_MRLOOP_CB(this->read_cb, fci, fci_cache);
+
+  php_mrloop_tcp_client_recv(this);
+}
+static void php_mrloop_conn_release(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_conn_t *this, *head, *conn;
+  size_t count;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  this = PHP_MRLOOP_CONN_OBJ(getThis());
+
+  if (this->evloop == NULL)
+  {
+    PHP_MRLOOP_THROW("Connection is closed");
+    return;
+  }
+
+  if (this->server || this->pool_key == NULL)
+  {
+    PHP_MRLOOP_THROW("Only outbound connections can be pooled");
+    return;
+  }
+
+  if (this->closing || this->pooled)
+  {
+    return;
+  }
+
+  if (this->recv_armed)
+  {
+    PHP_MRLOOP_THROW("Connections with pending reads cannot be pooled");
+    return;
+  }
+
+  if (this->evloop->pool == NULL)
+  {
+    ALLOC_HASHTABLE(this->evloop->pool);
+    zend_hash_init(this->evloop->pool, 8, NULL, NULL, 0);
+  }
+
+  head = zend_hash_find_ptr(this->evloop->pool, this->pool_key);
+
+  count = 0;
+  for (conn = head; conn != NULL; conn = conn->pool_next)
+  {
+    count++;
+  }
+
+  // surplus idle connections are not worth the file descriptors they occupy
+  if (count >= PHP_MRLOOP_POOL_SIZE)
+  {
+    php_mrloop_tcp_client_close(this);
+    return;
+  }
+
+  // queued writes are still delivered; the connection is merely unavailable until checked out anew
+  this->pooled = true;
+  this->pool_next = head;
+  zend_hash_update_ptr(this->evloop->pool, this->pool_key, this);
+}
+static php_mrloop_conn_t *php_mrloop_pool_checkout(php_mrloop_t *evloop, zend_string *key)
+{
+  php_mrloop_conn_t *conn;
+  char probe;
+  ssize_t nbytes;
+
+  if (evloop->pool == NULL)
+  {
+    return NULL;
+  }
+
+  while ((conn = zend_hash_find_ptr(evloop->pool, key)) != NULL)
+  {
+    php_mrloop_pool_remove(conn);
+
+    // idle connections have nothing to read; data or end-of-file means the peer has moved on
+    nbytes = recv(conn->fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (nbytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      return conn;
+    }
+
+    php_mrloop_tcp_client_close(conn);
+  }
+
+  return NULL;
+}
+static void php_mrloop_pool_remove(php_mrloop_conn_t *conn)
+{
+  HashTable *pool = conn->evloop->pool;
+  php_mrloop_conn_t *head, **link;
+
+  if (!conn->pooled || pool == NULL)
+  {
+    return;
+  }
+
+  conn->pooled = false;
+  head = zend_hash_find_ptr(pool, conn->pool_key);
+
+  for (link = &head; *link != NULL; link = &(*link)->pool_next)
+  {
+    if (*link == conn)
+    {
+      *link = conn->pool_next;
+      break;
+    }
+  }
+  conn->pool_next = NULL;
+
+  if (head == NULL)
+  {
+    zend_hash_del(pool, conn->pool_key);
+  }
+  else
+  {
+    zend_hash_update_ptr(pool, conn->pool_key, head);
+  }
+}
+static void php_mrloop_pool_free(php_mrloop_t *evloop)
+{
+  php_mrloop_conn_t *conn, *next;
+
+  if (evloop->pool == NULL)
+  {
+    return;
+  }
+
+  ZEND_HASH_FOREACH_PTR(evloop->pool, conn)
+  {
+    for (; conn != NULL; conn = next)
+    {
+      next = conn->pool_next;
+      conn->pool_next = NULL;
+      conn->pooled = false;
+      php_mrloop_tcp_client_close(conn);
+    }
+  }
+  ZEND_HASH_FOREACH_END();
+
+  zend_hash_destroy(evloop->pool);
+  FREE_HASHTABLE(evloop->pool);
+  evloop->pool = NULL;
+}
@@ -0,0 +1,106 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#ifndef __CLIENT_H__
+#define __CLIENT_H__
+
+#define PHP_MRLOOP_POOL_SIZE 16
+
+struct php_mrloop_lookup_t;
+typedef struct php_mrloop_lookup_t php_mrloop_lookup_t;
+
+/* outbound connection attempt (or checkout of a pooled connection) */
+struct php_mrloop_connect_t
+{
+  /* connect operation (or, while a host name is resolved, read of the eventfd signalled by the resolver thread) */
+  php_mrloop_op_t op;
+  /* event loop in which the attempt is subsumed */
+  php_mrloop_t *evloop;
+  /* connection being established */
+  php_mrloop_conn_t *conn;
+  /* callback to which the connection is conveyed */
+  php_mrloop_cb_t *cb;
+  /* remote address */
+  php_sockaddr_storage_t addr;
+  /* length of remote address */
+  socklen_t addrlen;
+  /* time allowed for the connection to be established (linked to the connect operation) */
+  struct __kernel_timespec ts;
+  /* whether the connect operation is subject to a timeout */
+  bool timed;
+  /* host name being resolved (NULL unless a lookup is pending) */
+  php_mrloop_lookup_t *lookup;
+  /* eventfd counter */
+  uint64_t counter;
+  /* host to which to connect (retained while its name is resolved) */
+  zend_string *host;
+  /* port to which to connect */
+  zend_long port;
+  /* connection pool key (retained while the host name is resolved) */
+  zend_string *key;
+  /* next attempt awaiting a lookup */
+  php_mrloop_connect_t *sibling;
+  /* link pointing at this attempt */
+  php_mrloop_connect_t **psibling;
+};
+
+/*
+ * host name lookup performed by a resolver thread
+ *
+ * getaddrinfo() blocks for as long as DNS takes to answer, so it runs on a
+ * thread of its own, which signals completion through an eventfd read on the
+ * extension-managed ring. The lookup is allocated with malloc() and freed by
+ * whichever of the thread and the event loop is done with it last.
+ */
+struct php_mrloop_lookup_t
+{
+  /* host name to resolve */
+  char *host;
+  /* port of the resolved address */
+  uint16_t port;
+  /* eventfd through which the resolver thread signals completion */
+  int efd;
+  /* getaddrinfo() status (0 upon success) */
+  int status;
+  /* resolved address */
+  php_sockaddr_storage_t addr;
+  /* length of resolved address */
+  socklen_t addrlen;
+  /* references held by the resolver thread and the event loop */
+  int refcount;
+};
+
+/* converts a host (IP address or unix:///path) and port to a socket address; a host name is left to a lookup (and the address length zero) */
+static int php_mrloop_client_address(zend_string *host, zend_long port, php_sockaddr_storage_t *addr, socklen_t *addrlen);
+/* creates outbound connection object for a socket */
+static php_mrloop_conn_t *php_mrloop_client_init(php_mrloop_t *evloop, int fd, zend_string *host, zend_long port, zend_string *key);
+/* creates a socket for a connection attempt whose address is known and issues the connect operation (along with a linked timeout, if one is set); returns the error which prevented it (or NULL) */
+static const char *php_mrloop_client_dial(php_mrloop_connect_t *attempt, zend_string *host, zend_long port, zend_string *key);
+/* conveys a connection (or a description of the failure to establish one) to the connect callback and releases the attempt */
+static void php_mrloop_client_convey(php_mrloop_connect_t *attempt, php_mrloop_conn_t *conn, const char *error);
+/* conveys established (or reused) connection to the connect callback */
+static void php_mrloop_client_connect_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* hands the host name of a connection attempt to a resolver thread; returns FAILURE (after throwing) if the lookup cannot be started */
+static int php_mrloop_client_resolve(php_mrloop_t *evloop, php_mrloop_connect_t *attempt);
+/* resolves a host name on a thread other than the event loop's */
+static void *php_mrloop_client_resolve_thread(void *data);
+/* dials the address found by a lookup (or reports the failure of the lookup) */
+static void php_mrloop_client_resolve_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* drops a reference to a lookup (freeing it once neither the resolver thread nor the event loop holds one) */
+static void php_mrloop_lookup_release(php_mrloop_lookup_t *lookup);
+/* abandons connection attempts awaiting lookups (the resolver threads finish on their own) */
+static void php_mrloop_lookups_free(php_mrloop_t *evloop);
+/* conveys data received on an outbound connection to the pending read callback */
+static void php_mrloop_client_read_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* establishes an outbound TCP connection (or reuses an idle pooled one) */
+static void php_mrloop_connect(INTERNAL_FUNCTION_PARAMETERS);
+/* reads the next chunk of data available on an outbound connection */
+static void php_mrloop_conn_read(INTERNAL_FUNCTION_PARAMETERS);
+/* returns an outbound connection to the connection pool */
+static void php_mrloop_conn_release(INTERNAL_FUNCTION_PARAMETERS);
+/* retrieves a live idle connection for the specified key from the connection pool */
+static php_mrloop_conn_t *php_mrloop_pool_checkout(php_mrloop_t *evloop, zend_string *key);
+/* removes connection from the connection pool */
+static void php_mrloop_pool_remove(php_mrloop_conn_t *conn);
+/* closes idle pooled connections and releases the connection pool */
+static void php_mrloop_pool_free(php_mrloop_t *evloop);
+
+#endif
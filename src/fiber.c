@@ -0,0 +1,351 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#include "loop.h"
+
+static php_mrloop_await_t *php_mrloop_await_init(php_mrloop_t *evloop, int type, int fd, struct io_uring_sqe **sqe)
+{
+  php_mrloop_await_t *await;
+
+  if (EG(active_fiber) == NULL)
+  {
+    PHP_MRLOOP_THROW("Operations may only be awaited within a fiber");
+    return NULL;
+  }
+
+  if (php_mrloop_uring(evloop) == NULL)
+  {
+    return NULL;
+  }
+
+  await = php_mrloop_slab_alloc(evloop, sizeof(php_mrloop_await_t));
+  memset(await, 0, sizeof(php_mrloop_await_t));
+  await->op.handler = php_mrloop_await_cb;
+  await->op.data = await;
+  await->evloop = evloop;
+  await->type = type;
+  await->fd = fd;
+
+  if ((*sqe = php_mrloop_uring_sqe(evloop, &await->op)) == NULL)
+  {
+    php_mrloop_slab_release(evloop, await, sizeof(php_mrloop_await_t));
+    PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+
+    return NULL;
+  }
+
+  return await;
+}
+static void php_mrloop_await_prep_rw(php_mrloop_await_t *await, struct io_uring_sqe *sqe, size_t start, __u64 offset)
+{
+  char *base = ZSTR_VAL(await->buffer) + start;
+  unsigned nbytes = (unsigned)(ZSTR_LEN(await->buffer) - start);
+  int slot, fd;
+
+  slot = php_mrloop_uring_fixed_file(await->evloop, await->fd);
+  fd = slot > -1 ? slot : await->fd;
+
+  if (await->type == PHP_MRLOOP_AWAIT_READ)
+  {
+    io_uring_prep_read(sqe, fd, base, nbytes, offset);
+  }
+  else
+  {
+    io_uring_prep_write(sqe, fd, base, nbytes, offset);
+  }
+
+  if (slot > -1)
+  {
+    sqe->flags |= IOSQE_FIXED_FILE;
+  }
+}
+static void php_mrloop_await_suspend(php_mrloop_await_t *await, zval *return_value)
+{
+  await->fiber = &EG(active_fiber)->std;
+  GC_ADDREF(await->fiber);
+
+  // the operation is submitted before the fiber yields (or, in a batch, once the batch ends) and the fiber is resumed
+  // by the completion handler; whatever it is resumed with is returned
+  php_mrloop_uring_submit(await->evloop);
+  zend_call_method(NULL, zend_ce_fiber, &php_mrloop_fiber_suspend_fn, "suspend", sizeof("suspend") - 1, return_value, 0, NULL, NULL);
+}
+static void php_mrloop_await_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_await_t *await = (php_mrloop_await_t *)op->data;
+  php_mrloop_t *evloop = await->evloop;
+  zend_object *fiber = await->fiber;
+  struct io_uring_sqe *sqe;
+  php_stream *stream;
+  const char *error = NULL;
+  zval value;
+
+  ZVAL_NULL(&value);
+
+  switch (await->type)
+  {
+  case PHP_MRLOOP_AWAIT_READ:
+    if (cqe->res < 0)
+    {
+      error = strerror(-cqe->res);
+      break;
+    }
+
+    // the kernel wrote straight into the string; it only remains to trim it to the number of bytes read
+    if ((size_t)cqe->res < ZSTR_LEN(await->buffer))
+    {
+      await->buffer = zend_string_truncate(await->buffer, (size_t)cqe->res, 0);
+    }
+    ZSTR_VAL(await->buffer)[cqe->res] = '\0';
+
+    ZVAL_STR(&value, await->buffer);
+    await->buffer = NULL;
+    break;
+
+  case PHP_MRLOOP_AWAIT_WRITE:
+    if (cqe->res < 0)
+    {
+      error = strerror(-cqe->res);
+      break;
+    }
+
+    await->written += (size_t)cqe->res;
+
+    // short writes are resumed where they left off; the fiber sees only the outcome of the whole write
+    if (cqe->res > 0 && await->written < ZSTR_LEN(await->buffer))
+    {
+      if ((sqe = php_mrloop_uring_sqe(evloop, &await->op)) == NULL)
+      {
+        error = "Could not acquire submission queue entry";
+        break;
+      }
+
+      php_mrloop_await_prep_rw(await, sqe, await->written, (__u64)-1);
+      php_mrloop_uring_submit(evloop);
+
+      return;
+    }
+
+    ZVAL_LONG(&value, (zend_long)await->written);
+    break;
+
+  case PHP_MRLOOP_AWAIT_SLEEP:
+    // timeouts which elapse complete with -ETIME
+    if (cqe->res < 0 && cqe->res != -ETIME)
+    {
+      error = strerror(-cqe->res);
+    }
+    break;
+
+  case PHP_MRLOOP_AWAIT_ACCEPT:
+    if (cqe->res < 0)
+    {
+      error = strerror(-cqe->res);
+      break;
+    }
+
+    if ((stream = php_stream_sock_open_from_socket(cqe->res, NULL)) == NULL)
+    {
+      close(cqe->res);
+      error = "Could not create stream";
+      break;
+    }
+
+    php_stream_to_zval(stream, &value);
+    break;
+  }
+
+  if (await->buffer)
+  {
+    zend_string_release(await->buffer);
+  }
+  php_mrloop_slab_release(evloop, await, sizeof(php_mrloop_await_t));
+
+  php_mrloop_await_resume(evloop, fiber, &value, error);
+}
+static void php_mrloop_await_resume(php_mrloop_t *evloop, zend_object *fiber, zval *value, const char *error)
+{
+  zval exception, result;
+
+  ZVAL_UNDEF(&result);
+
+  if (error)
+  {
+    object_init_ex(&exception, php_mrloop_exception_ce);
+    zend_update_property_string(zend_ce_exception, Z_OBJ(exception), "message", sizeof("message") - 1, error);
+
+    zend_call_method(fiber, zend_ce_fiber, &php_mrloop_fiber_throw_fn, "throw", sizeof("throw") - 1, &result, 1, &exception, NULL);
+    zval_ptr_dtor(&exception);
+  }
+  else
+  {
+    zend_call_method(fiber, zend_ce_fiber, &php_mrloop_fiber_resume_fn, "resume", sizeof("resume") - 1, &result, 1, value, NULL);
+  }
+
+  zval_ptr_dtor(value);
+  zval_ptr_dtor(&result);
+  OBJ_RELEASE(fiber);
+
+  // exceptions the fiber does not catch propagate from run()
+  if (EG(exception))
+  {
+    mr_stop(evloop->loop);
+  }
+}
+static void php_mrloop_read_async(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj, *file;
+  php_mrloop_t *this;
+  php_mrloop_await_t *await;
+  struct io_uring_sqe *sqe;
+  zend_long nbytes, offset;
+  bool nbytes_null, offset_null;
+  int fd;
+
+  obj = getThis();
+  nbytes = DEFAULT_STREAM_BUFF_LEN;
+  offset = 0;
+  nbytes_null = true;
+  offset_null = true;
+
+  ZEND_PARSE_PARAMETERS_START(1, 3)
+  Z_PARAM_ZVAL(file)
+  Z_PARAM_OPTIONAL
+  Z_PARAM_LONG_OR_NULL(nbytes, nbytes_null)
+  Z_PARAM_LONG_OR_NULL(offset, offset_null)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (nbytes_null)
+  {
+    nbytes = DEFAULT_STREAM_BUFF_LEN;
+  }
+
+  if (nbytes < 1 || nbytes > UINT_MAX)
+  {
+    PHP_MRLOOP_THROW("Number of bytes to read must be positive");
+    return;
+  }
+
+  if (!offset_null && offset < 0)
+  {
+    PHP_MRLOOP_THROW("Offset must not be negative");
+    return;
+  }
+
+  if (php_mrloop_file_fd(file, &fd) == FAILURE)
+  {
+    return;
+  }
+
+  if ((await = php_mrloop_await_init(this, PHP_MRLOOP_AWAIT_READ, fd, &sqe)) == NULL)
+  {
+    return;
+  }
+
+  // reads without an offset start at (and advance) the file position
+  await->buffer = zend_string_alloc((size_t)nbytes, 0);
+  php_mrloop_await_prep_rw(await, sqe, 0, offset_null ? (__u64)-1 : (__u64)offset);
+
+  php_mrloop_await_suspend(await, return_value);
+}
+static void php_mrloop_write_async(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj, *file;
+  php_mrloop_t *this;
+  php_mrloop_await_t *await;
+  struct io_uring_sqe *sqe;
+  zend_string *contents;
+  int fd;
+
+  obj = getThis();
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_ZVAL(file)
+  Z_PARAM_STR(contents)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (ZSTR_LEN(contents) == 0)
+  {
+    RETURN_LONG(0);
+  }
+
+  if (php_mrloop_file_fd(file, &fd) == FAILURE)
+  {
+    return;
+  }
+
+  if ((await = php_mrloop_await_init(this, PHP_MRLOOP_AWAIT_WRITE, fd, &sqe)) == NULL)
+  {
+    return;
+  }
+
+  // the string is pinned rather than copied until the write completes
+  await->buffer = zend_string_copy(contents);
+  php_mrloop_await_prep_rw(await, sqe, 0, (__u64)-1);
+
+  php_mrloop_await_suspend(await, return_value);
+}
+static void php_mrloop_sleep(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+  php_mrloop_await_t *await;
+  struct io_uring_sqe *sqe;
+  double seconds;
+
+  obj = getThis();
+
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+  Z_PARAM_DOUBLE(seconds)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (seconds < 0)
+  {
+    PHP_MRLOOP_THROW("Sleep duration must not be negative");
+    return;
+  }
+
+  if ((await = php_mrloop_await_init(this, PHP_MRLOOP_AWAIT_SLEEP, -1, &sqe)) == NULL)
+  {
+    return;
+  }
+
+  await->ts.tv_sec = (long long)seconds;
+  await->ts.tv_nsec = (long long)((seconds - (double)await->ts.tv_sec) * 1e9);
+  io_uring_prep_timeout(sqe, &await->ts, 0, 0);
+
+  php_mrloop_await_suspend(await, return_value);
+}
+static void php_mrloop_accept(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj, *server;
+  php_mrloop_t *this;
+  php_mrloop_await_t *await;
+  struct io_uring_sqe *sqe;
+  int fd;
+
+  obj = getThis();
+
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+  Z_PARAM_RESOURCE(server)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (php_mrloop_file_fd(server, &fd) == FAILURE)
+  {
+    return;
+  }
+
+  if ((await = php_mrloop_await_init(this, PHP_MRLOOP_AWAIT_ACCEPT, fd, &sqe)) == NULL)
+  {
+    return;
+  }
+
+  io_uring_prep_accept(sqe, fd, NULL, NULL, SOCK_CLOEXEC);
+
+  php_mrloop_await_suspend(await, return_value);
+}
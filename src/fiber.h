@@ -0,0 +1,64 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#ifndef __FIBER_H__
+#define __FIBER_H__
+
+#define PHP_MRLOOP_AWAIT_READ 0
+#define PHP_MRLOOP_AWAIT_WRITE 1
+#define PHP_MRLOOP_AWAIT_SLEEP 2
+#define PHP_MRLOOP_AWAIT_ACCEPT 3
+
+struct php_mrloop_await_t;
+typedef struct php_mrloop_await_t php_mrloop_await_t;
+
+/*
+ * operation awaited by a suspended fiber
+ *
+ * The awaiting method issues the operation to the extension-managed ring
+ * and suspends the fiber in which it is called; the completion handler
+ * resumes the fiber with the result of the operation (or throws the error
+ * into it), whereupon the method returns. No PHP callback is involved, and
+ * the record itself is carved from a slab of the event loop.
+ */
+struct php_mrloop_await_t
+{
+  /* awaited operation */
+  php_mrloop_op_t op;
+  /* event loop in which the operation is subsumed */
+  php_mrloop_t *evloop;
+  /* type of operation (PHP_MRLOOP_AWAIT_*) */
+  int type;
+  /* suspended fiber (a reference to which is held until the fiber is resumed) */
+  zend_object *fiber;
+  /* descriptor on which the operation is performed */
+  int fd;
+  /* string into which data is read (read only) or whence it is written (write only) */
+  zend_string *buffer;
+  /* number of bytes written thus far (write only) */
+  size_t written;
+  /* duration of the sleep (sleep only) */
+  struct __kernel_timespec ts;
+};
+
+/* Fiber methods by which fibers are suspended, resumed and thrown into (each looked up upon first use) */
+static zend_function *php_mrloop_fiber_suspend_fn, *php_mrloop_fiber_resume_fn, *php_mrloop_fiber_throw_fn;
+
+/* allocates an awaited operation bound to a submission queue entry; returns NULL (after throwing) outside of a fiber or upon failure */
+static php_mrloop_await_t *php_mrloop_await_init(php_mrloop_t *evloop, int type, int fd, struct io_uring_sqe **sqe);
+/* prepares a read or write of the awaited operation's buffer (from the specified position in it) on its descriptor */
+static void php_mrloop_await_prep_rw(php_mrloop_await_t *await, struct io_uring_sqe *sqe, size_t start, __u64 offset);
+/* submits the awaited operation and suspends the current fiber until it completes; the fiber is resumed with the result */
+static void php_mrloop_await_suspend(php_mrloop_await_t *await, zval *return_value);
+/* processes completion of an awaited operation and resumes the fiber which awaits it */
+static void php_mrloop_await_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* resumes a suspended fiber with a value (or throws an error into it) and releases it */
+static void php_mrloop_await_resume(php_mrloop_t *evloop, zend_object *fiber, zval *value, const char *error);
+/* reads from a descriptor in the current fiber */
+static void php_mrloop_read_async(INTERNAL_FUNCTION_PARAMETERS);
+/* writes to a descriptor in the current fiber */
+static void php_mrloop_write_async(INTERNAL_FUNCTION_PARAMETERS);
+/* suspends the current fiber for the specified number of seconds */
+static void php_mrloop_sleep(INTERNAL_FUNCTION_PARAMETERS);
+/* accepts a connection on a listening socket in the current fiber */
+static void php_mrloop_accept(INTERNAL_FUNCTION_PARAMETERS);
+
+#endif
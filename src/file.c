@@ -0,0 +1,1076 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#include "file.h"
+
+static int php_mrloop_file_fd(zval *res, int *fd)
+{
+  php_stream *stream;
+  php_mrloop_conn_t *conn;
+
+  *fd = -1;
+
+  if (Z_TYPE_P(res) == IS_LONG)
+  {
+    *fd = (int)Z_LVAL_P(res);
+  }
+  else if (Z_TYPE_P(res) == IS_OBJECT && instanceof_function(Z_OBJCE_P(res), php_mrloop_conn_ce))
+  {
+    conn = PHP_MRLOOP_CONN_OBJ(res);
+    *fd = conn->closing ? -1 : conn->fd;
+  }
+  else if (Z_TYPE_P(res) == IS_RESOURCE)
+  {
+    if ((stream = (php_stream *)zend_fetch_resource_ex(res, NULL, php_file_le_stream())) == NULL ||
+        php_stream_cast(stream, PHP_STREAM_AS_FD | PHP_STREAM_CAST_INTERNAL, (void *)fd, 1) == FAILURE)
+    {
+      *fd = -1;
+    }
+  }
+
+  if (*fd < 0 || fcntl(*fd, F_GETFD) < 0)
+  {
+    PHP_MRLOOP_THROW("Detected invalid file descriptor");
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+static php_mrloop_splice_t *php_mrloop_splice_init(php_mrloop_t *evloop, int in_fd, int out_fd, size_t pipe_size, zend_fcall_info *fci, zend_fcall_info_cache *fci_cache)
+{
+  php_mrloop_splice_t *transfer;
+  int fds[2], size;
+
+  if (php_mrloop_uring(evloop) == NULL)
+  {
+    return NULL;
+  }
+
+  if (pipe2(fds, O_CLOEXEC) < 0)
+  {
+    PHP_MRLOOP_THROW(strerror(errno));
+    return NULL;
+  }
+
+  // larger pipes mean fewer round trips per transfer; the default capacity is used if resizing is refused
+  fcntl(fds[1], F_SETPIPE_SZ, (int)pipe_size);
+  size = fcntl(fds[1], F_GETPIPE_SZ);
+
+  transfer = ecalloc(1, sizeof(php_mrloop_splice_t));
+  transfer->evloop = evloop;
+  transfer->in_op.handler = php_mrloop_splice_in_cb;
+  transfer->in_op.data = transfer;
+  transfer->out_op.handler = php_mrloop_splice_out_cb;
+  transfer->out_op.data = transfer;
+  transfer->in_fd = in_fd;
+  transfer->out_fd = out_fd;
+  transfer->pipe[0] = fds[0];
+  transfer->pipe[1] = fds[1];
+  transfer->pipe_size = size > 0 ? (size_t)size : 65536;
+  transfer->offset = -1;
+  transfer->remaining = -1;
+
+  transfer->cb = emalloc(sizeof(php_mrloop_cb_t));
+  PHP_CB_TO_MRLOOP_CB(transfer->cb, (*fci), (*fci_cache));
+
+  return transfer;
+}
+static bool php_mrloop_splice_in(php_mrloop_splice_t *transfer)
+{
+  struct io_uring_sqe *sqe;
+  size_t nbytes;
+  int slot;
+
+  nbytes = transfer->pipe_size - transfer->buffered;
+  if (transfer->remaining > -1 && (size_t)transfer->remaining < nbytes)
+  {
+    nbytes = (size_t)transfer->remaining;
+  }
+
+  if ((sqe = php_mrloop_uring_sqe(transfer->evloop, &transfer->in_op)) == NULL)
+  {
+    return false;
+  }
+
+  if ((slot = php_mrloop_uring_fixed_file(transfer->evloop, transfer->in_fd)) > -1)
+  {
+    io_uring_prep_splice(sqe, slot, transfer->offset, transfer->pipe[1], -1, (unsigned)nbytes, SPLICE_F_MOVE | SPLICE_F_FD_IN_FIXED);
+  }
+  else
+  {
+    io_uring_prep_splice(sqe, transfer->in_fd, transfer->offset, transfer->pipe[1], -1, (unsigned)nbytes, SPLICE_F_MOVE);
+  }
+
+  transfer->in_armed = true;
+
+  // an empty pipe is drained by a write linked to the read, which saves a round trip per chunk; a short read severs
+  // the link (the write completes with -ECANCELED) and the buffered data is then written on its own
+  if (nbytes > 0 && transfer->buffered == 0 && !transfer->out_armed)
+  {
+    sqe->flags |= IOSQE_IO_LINK;
+    transfer->buffered = nbytes;
+
+    if (!php_mrloop_splice_out(transfer))
+    {
+      sqe->flags &= ~IOSQE_IO_LINK;
+    }
+
+    transfer->buffered = 0;
+  }
+
+  php_mrloop_uring_submit(transfer->evloop);
+
+  return true;
+}
+static bool php_mrloop_splice_out(php_mrloop_splice_t *transfer)
+{
+  struct io_uring_sqe *sqe;
+  int slot;
+
+  if ((sqe = php_mrloop_uring_sqe(transfer->evloop, &transfer->out_op)) == NULL)
+  {
+    return false;
+  }
+
+  if ((slot = php_mrloop_uring_fixed_file(transfer->evloop, transfer->out_fd)) > -1)
+  {
+    io_uring_prep_splice(sqe, transfer->pipe[0], -1, slot, -1, (unsigned)transfer->buffered, SPLICE_F_MOVE);
+    sqe->flags |= IOSQE_FIXED_FILE;
+  }
+  else
+  {
+    io_uring_prep_splice(sqe, transfer->pipe[0], -1, transfer->out_fd, -1, (unsigned)transfer->buffered, SPLICE_F_MOVE);
+  }
+
+  transfer->out_armed = true;
+  php_mrloop_uring_submit(transfer->evloop);
+
+  return true;
+}
+static void php_mrloop_splice_pump(php_mrloop_splice_t *transfer)
+{
+  if (transfer->error)
+  {
+    php_mrloop_splice_fail(transfer, transfer->error);
+    return;
+  }
+
+  if (!transfer->out_armed && transfer->buffered > 0 && !php_mrloop_splice_out(transfer))
+  {
+    php_mrloop_splice_fail(transfer, EBUSY);
+    return;
+  }
+
+  // reads stop while the pipe is full, which holds a fast source back until the destination catches up
+  if (!transfer->in_armed && !transfer->eof && transfer->remaining != 0 && transfer->buffered < transfer->pipe_size &&
+      !php_mrloop_splice_in(transfer))
+  {
+    php_mrloop_splice_fail(transfer, EBUSY);
+    return;
+  }
+
+  if (!transfer->in_armed && !transfer->out_armed)
+  {
+    php_mrloop_splice_done(transfer);
+  }
+}
+static void php_mrloop_splice_in_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_splice_t *transfer = (php_mrloop_splice_t *)op->data;
+
+  transfer->in_armed = false;
+
+  if (cqe->res < 0)
+  {
+    php_mrloop_splice_fail(transfer, -cqe->res);
+    return;
+  }
+
+  // end-of-file concludes transfers of unspecified (or overlong) length
+  if (cqe->res == 0)
+  {
+    transfer->eof = true;
+  }
+
+  if (transfer->offset > -1)
+  {
+    transfer->offset += cqe->res;
+  }
+  if (transfer->remaining > -1)
+  {
+    transfer->remaining -= cqe->res;
+  }
+  transfer->buffered += (size_t)cqe->res;
+
+  php_mrloop_splice_pump(transfer);
+}
+static void php_mrloop_splice_out_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_splice_t *transfer = (php_mrloop_splice_t *)op->data;
+
+  transfer->out_armed = false;
+
+  // writes linked to short (or failed) reads are cancelled; the outcome of the read determines what happens next
+  if (cqe->res == -ECANCELED && !transfer->error)
+  {
+    php_mrloop_splice_pump(transfer);
+    return;
+  }
+
+  if (cqe->res <= 0)
+  {
+    php_mrloop_splice_fail(transfer, cqe->res == 0 ? EPIPE : -cqe->res);
+    return;
+  }
+
+  transfer->sent += cqe->res;
+  transfer->buffered -= cqe->res;
+
+  php_mrloop_splice_pump(transfer);
+}
+static void php_mrloop_splice_fail(php_mrloop_splice_t *transfer, int error)
+{
+  struct io_uring_sqe *sqe;
+
+  if (!transfer->error)
+  {
+    transfer->error = error;
+
+    // a read from an idle socket (or a write to a stalled one) would otherwise keep the transfer alive indefinitely
+    if (transfer->in_armed && (sqe = php_mrloop_uring_sqe(transfer->evloop, NULL)) != NULL)
+    {
+      io_uring_prep_cancel(sqe, &transfer->in_op, 0);
+    }
+    if (transfer->out_armed && (sqe = php_mrloop_uring_sqe(transfer->evloop, NULL)) != NULL)
+    {
+      io_uring_prep_cancel(sqe, &transfer->out_op, 0);
+    }
+    php_mrloop_uring_submit(transfer->evloop);
+  }
+
+  if (!transfer->in_armed && !transfer->out_armed)
+  {
+    php_mrloop_splice_done(transfer);
+  }
+}
+static void php_mrloop_splice_done(php_mrloop_splice_t *transfer)
+{
+  php_mrloop_cb_t *cb = transfer->cb;
+  zval args[2], result;
+
+  close(transfer->pipe[0]);
+  close(transfer->pipe[1]);
+
+  ZVAL_LONG(&args[0], (zend_long)transfer->sent);
+  if (transfer->error)
+  {
+    ZVAL_STRING(&args[1], strerror(transfer->error));
+  }
+  else
+  {
+    ZVAL_NULL(&args[1]);
+  }
+
+  cb->fci.retval = &result;
+  cb->fci.param_count = 2;
+  cb->fci.params = args;
+
+  if (php_mrloop_call(transfer->evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("There is an error in your callback");
+  }
+
+  zval_ptr_dtor(&result);
+  zval_ptr_dtor(&args[1]);
+
+  if (transfer->src)
+  {
+    OBJ_RELEASE(transfer->src);
+  }
+  if (transfer->dst)
+  {
+    OBJ_RELEASE(transfer->dst);
+  }
+
+  PHP_MRLOOP_CB_FREE(cb);
+  efree(transfer);
+}
+static void php_mrloop_send_file(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj, *file, *socket;
+  php_mrloop_t *this;
+  php_mrloop_splice_t *transfer;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  zend_long offset, length;
+  bool length_null;
+  int in_fd, out_fd;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+  offset = 0;
+  length_null = true;
+
+  ZEND_PARSE_PARAMETERS_START(5, 5)
+  Z_PARAM_ZVAL(file)
+  Z_PARAM_ZVAL(socket)
+  Z_PARAM_LONG(offset)
+  Z_PARAM_LONG_OR_NULL(length, length_null)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (php_mrloop_file_fd(file, &in_fd) == FAILURE || php_mrloop_file_fd(socket, &out_fd) == FAILURE)
+  {
+    return;
+  }
+
+  if (offset < 0 || (!length_null && length < 0))
+  {
+    PHP_MRLOOP_THROW("Offset and length must be non-negative");
+    return;
+  }
+
+  if ((transfer = php_mrloop_splice_init(this, in_fd, out_fd, PHP_MRLOOP_SPLICE_PIPE_SIZE, &fci, &fci_cache)) == NULL)
+  {
+    return;
+  }
+
+  transfer->offset = (int64_t)offset;
+  transfer->remaining = length_null ? -1 : (int64_t)length;
+
+  if (Z_TYPE_P(socket) == IS_OBJECT)
+  {
+    transfer->dst = Z_OBJ_P(socket);
+    GC_ADDREF(transfer->dst);
+  }
+
+  // empty ranges complete (asynchronously, like any other) upon the first zero-length splice
+  if (!php_mrloop_splice_in(transfer))
+  {
+    php_mrloop_splice_fail(transfer, EBUSY);
+  }
+}
+static void php_mrloop_pipe(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj, *src, *dst;
+  php_mrloop_t *this;
+  php_mrloop_conn_t *conn;
+  php_mrloop_splice_t *transfer;
+  HashTable *options;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  zend_long length, buff_size;
+  int in_fd, out_fd;
+
+  obj = getThis();
+  options = NULL;
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(4, 4)
+  Z_PARAM_ZVAL(src)
+  Z_PARAM_ZVAL(dst)
+  Z_PARAM_ARRAY_HT_OR_NULL(options)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (php_mrloop_file_fd(src, &in_fd) == FAILURE || php_mrloop_file_fd(dst, &out_fd) == FAILURE)
+  {
+    return;
+  }
+
+  if (Z_TYPE_P(src) == IS_OBJECT)
+  {
+    // the loop itself reads from accepted connections (and from outbound ones with a pending read)
+    conn = PHP_MRLOOP_CONN_OBJ(src);
+    if (conn->server != NULL || conn->read_cb != NULL)
+    {
+      PHP_MRLOOP_THROW("Connection is already being read from");
+      return;
+    }
+  }
+
+  length = php_mrloop_option_long(options, "length", -1);
+  buff_size = php_mrloop_option_long(options, "buffer_size", PHP_MRLOOP_SPLICE_PIPE_SIZE);
+
+  if (length < -1 || buff_size <= 0 || buff_size > INT_MAX)
+  {
+    PHP_MRLOOP_THROW("Length and buffer size must be positive");
+    return;
+  }
+
+  if ((transfer = php_mrloop_splice_init(this, in_fd, out_fd, (size_t)buff_size, &fci, &fci_cache)) == NULL)
+  {
+    return;
+  }
+
+  transfer->remaining = (int64_t)length;
+
+  if (Z_TYPE_P(src) == IS_OBJECT)
+  {
+    transfer->src = Z_OBJ_P(src);
+    GC_ADDREF(transfer->src);
+  }
+  if (Z_TYPE_P(dst) == IS_OBJECT)
+  {
+    transfer->dst = Z_OBJ_P(dst);
+    GC_ADDREF(transfer->dst);
+  }
+
+  if (!php_mrloop_splice_in(transfer))
+  {
+    php_mrloop_splice_fail(transfer, EBUSY);
+  }
+}
+static void php_mrloop_stream_arm(php_mrloop_stream_t *stream, php_mrloop_stream_slot_t *slot)
+{
+  struct io_uring_sqe *sqe;
+  int fixed;
+
+  if ((sqe = php_mrloop_uring_sqe(stream->evloop, &slot->op)) == NULL)
+  {
+    stream->finished = true;
+    PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+
+    return;
+  }
+
+  // buffers retained by userspace are replaced; the rest are reused as they are
+  if (GC_REFCOUNT(slot->buffer) > 1)
+  {
+    zend_string_release(slot->buffer);
+    slot->buffer = zend_string_alloc(stream->nbytes, 0);
+  }
+  ZSTR_LEN(slot->buffer) = stream->nbytes;
+  zend_string_forget_hash_val(slot->buffer);
+
+  slot->armed = true;
+  slot->done = false;
+  slot->stale = false;
+
+  if ((fixed = php_mrloop_uring_fixed_file(stream->evloop, stream->fd)) > -1)
+  {
+    io_uring_prep_read(sqe, fixed, ZSTR_VAL(slot->buffer), (unsigned)stream->nbytes, (__u64)slot->offset);
+    sqe->flags |= IOSQE_FIXED_FILE;
+  }
+  else
+  {
+    io_uring_prep_read(sqe, stream->fd, ZSTR_VAL(slot->buffer), (unsigned)stream->nbytes, (__u64)slot->offset);
+  }
+
+  php_mrloop_uring_submit(stream->evloop);
+}
+static int64_t php_mrloop_stream_advance(php_mrloop_stream_t *stream)
+{
+  int64_t offset = stream->offset;
+
+  if (stream->offset > -1)
+  {
+    stream->offset += stream->nbytes;
+  }
+
+  return offset;
+}
+static void php_mrloop_stream_read_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_stream_slot_t *slot = (php_mrloop_stream_slot_t *)op->data;
+  php_mrloop_stream_t *stream = slot->stream;
+
+  slot->armed = false;
+  slot->res = cqe->res;
+
+  if (stream->finished)
+  {
+    php_mrloop_stream_free(stream);
+    return;
+  }
+
+  // reads issued past a short read are reissued at the offsets reserved for them
+  if (slot->stale)
+  {
+    php_mrloop_stream_arm(stream, slot);
+  }
+  else
+  {
+    slot->done = true;
+    php_mrloop_stream_deliver(stream);
+
+    return;
+  }
+
+  if (stream->finished)
+  {
+    php_mrloop_stream_free(stream);
+  }
+}
+static void php_mrloop_stream_deliver(php_mrloop_stream_t *stream)
+{
+  php_mrloop_stream_slot_t *slot, *other;
+  php_mrloop_cb_t *cb = stream->cb;
+  zval args[2], result;
+  bool proceed;
+
+  while (!stream->finished && (slot = &stream->slots[stream->next])->done)
+  {
+    slot->done = false;
+
+    if (slot->res < 0)
+    {
+      stream->finished = true;
+      PHP_MRLOOP_THROW(strerror(-slot->res));
+
+      break;
+    }
+
+    // the callback sees the buffer as a string exactly as long as the chunk; its capacity is restored upon reuse
+    ZSTR_LEN(slot->buffer) = (size_t)slot->res;
+    ZSTR_VAL(slot->buffer)[slot->res] = '\0';
+
+    ZVAL_STR_COPY(&args[0], slot->buffer);
+    ZVAL_LONG(&args[1], slot->res);
+
+    cb->fci.retval = &result;
+    cb->fci.param_count = 2;
+    cb->fci.params = args;
+
+    if (php_mrloop_call(stream->evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+    {
+      PHP_MRLOOP_THROW("There is an error in your callback");
+    }
+
+    proceed = Z_TYPE(result) != IS_FALSE && EG(exception) == NULL;
+
+    zval_ptr_dtor(&result);
+    zval_ptr_dtor(&args[0]);
+
+    // end-of-file is conveyed as an empty chunk
+    if (slot->res == 0 || !proceed)
+    {
+      stream->finished = true;
+      break;
+    }
+
+    if (slot->offset > -1 && (size_t)slot->res < stream->nbytes)
+    {
+      // a short read of a regular file leaves a gap which the reads issued after it do not cover
+      stream->offset = slot->offset + slot->res;
+      slot->offset = php_mrloop_stream_advance(stream);
+      php_mrloop_stream_arm(stream, slot);
+
+      // the others are reissued in delivery order; those in flight once they complete
+      for (size_t idx = 1; idx < stream->nslots && !stream->finished; idx++)
+      {
+        other = &stream->slots[(stream->next + idx) % stream->nslots];
+        other->offset = php_mrloop_stream_advance(stream);
+
+        if (other->armed)
+        {
+          other->stale = true;
+        }
+        else
+        {
+          php_mrloop_stream_arm(stream, other);
+        }
+      }
+
+      continue;
+    }
+
+    stream->next = (stream->next + 1) % stream->nslots;
+    slot->offset = php_mrloop_stream_advance(stream);
+    php_mrloop_stream_arm(stream, slot);
+  }
+
+  if (stream->finished)
+  {
+    php_mrloop_stream_free(stream);
+  }
+}
+static void php_mrloop_stream_free(php_mrloop_stream_t *stream)
+{
+  for (size_t idx = 0; idx < stream->nslots; idx++)
+  {
+    // the kernel may still write to the buffer of a read in flight
+    if (stream->slots[idx].armed)
+    {
+      return;
+    }
+  }
+
+  for (size_t idx = 0; idx < stream->nslots; idx++)
+  {
+    zend_string_release(stream->slots[idx].buffer);
+  }
+
+  zval_ptr_dtor(&stream->resource);
+  PHP_MRLOOP_CB_FREE(stream->cb);
+  efree(stream);
+}
+static void php_mrloop_read_stream(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj, *res;
+  php_mrloop_t *this;
+  php_mrloop_stream_t *stream;
+  php_stream *handle;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  zend_long nbytes, offset;
+  bool nbytes_null, offset_null;
+  php_stat_t st;
+  int fd;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+  nbytes_null = true;
+  offset_null = true;
+  fd = -1;
+
+  ZEND_PARSE_PARAMETERS_START(4, 4)
+  Z_PARAM_RESOURCE(res)
+  Z_PARAM_LONG_OR_NULL(nbytes, nbytes_null)
+  Z_PARAM_LONG_OR_NULL(offset, offset_null)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  PHP_STREAM_TO_FD(handle, res, fd);
+
+  if (fd < 0 || fstat(fd, &st) < 0)
+  {
+    PHP_MRLOOP_THROW("Detected invalid file descriptor");
+    return;
+  }
+
+  if ((!nbytes_null && nbytes < 1) || (!offset_null && offset < 0))
+  {
+    PHP_MRLOOP_THROW("Chunk size must be positive and offset non-negative");
+    return;
+  }
+
+  if (php_mrloop_uring(this) == NULL)
+  {
+    return;
+  }
+
+  stream = ecalloc(1, sizeof(php_mrloop_stream_t));
+  stream->evloop = this;
+  stream->fd = fd;
+  stream->nbytes = nbytes_null ? PHP_MRLOOP_STREAM_CHUNK_SIZE : (size_t)nbytes;
+  ZVAL_COPY(&stream->resource, res);
+
+  // regular files are read at explicit offsets, which allows for several reads in flight; anything else is read in sequence
+  if (S_ISREG(st.st_mode))
+  {
+    stream->offset = offset_null ? 0 : (int64_t)offset;
+    stream->nslots = PHP_MRLOOP_STREAM_READS;
+  }
+  else
+  {
+    stream->offset = -1;
+    stream->nslots = 1;
+  }
+
+  stream->cb = emalloc(sizeof(php_mrloop_cb_t));
+  PHP_CB_TO_MRLOOP_CB(stream->cb, fci, fci_cache);
+
+  for (size_t idx = 0; idx < stream->nslots; idx++)
+  {
+    stream->slots[idx].op.handler = php_mrloop_stream_read_cb;
+    stream->slots[idx].op.data = &stream->slots[idx];
+    stream->slots[idx].stream = stream;
+    stream->slots[idx].buffer = zend_string_alloc(stream->nbytes, 0);
+  }
+
+  for (size_t idx = 0; idx < stream->nslots && !stream->finished; idx++)
+  {
+    stream->slots[idx].offset = php_mrloop_stream_advance(stream);
+    php_mrloop_stream_arm(stream, &stream->slots[idx]);
+  }
+
+  if (stream->finished)
+  {
+    php_mrloop_stream_free(stream);
+  }
+}
+static php_mrloop_fs_t *php_mrloop_fs_init(php_mrloop_t *evloop, int type, zend_fcall_info *fci, zend_fcall_info_cache *fci_cache, struct io_uring_sqe **sqe)
+{
+  php_mrloop_fs_t *fs;
+
+  if (php_mrloop_uring(evloop) == NULL)
+  {
+    return NULL;
+  }
+
+  fs = php_mrloop_slab_alloc(evloop, sizeof(php_mrloop_fs_t));
+  memset(fs, 0, sizeof(php_mrloop_fs_t));
+  fs->op.handler = php_mrloop_fs_cb;
+  fs->op.data = fs;
+  fs->evloop = evloop;
+  fs->type = type;
+
+  if ((*sqe = php_mrloop_uring_sqe(evloop, &fs->op)) == NULL)
+  {
+    php_mrloop_slab_release(evloop, fs, sizeof(php_mrloop_fs_t));
+    PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+
+    return NULL;
+  }
+
+  fs->cb = php_mrloop_cb_alloc(evloop, fci, fci_cache);
+
+  return fs;
+}
+static void php_mrloop_fs_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_fs_t *fs = (php_mrloop_fs_t *)op->data;
+  php_mrloop_cb_t *cb = fs->cb;
+  php_stream *stream;
+  zval args[2], result, *error;
+  uint32_t argc;
+
+  // operations without a result convey only the error
+  argc = fs->type == PHP_MRLOOP_FS_OPEN || fs->type == PHP_MRLOOP_FS_STAT ? 2 : 1;
+  error = &args[argc - 1];
+  ZVAL_NULL(&args[0]);
+
+  if (cqe->res < 0)
+  {
+    ZVAL_STRING(error, strerror(-cqe->res));
+  }
+  else
+  {
+    ZVAL_NULL(error);
+
+    if (fs->type == PHP_MRLOOP_FS_OPEN)
+    {
+      if ((stream = php_stream_fopen_from_fd(cqe->res, fs->mode, NULL)) == NULL)
+      {
+        close(cqe->res);
+        ZVAL_STRING(error, "Could not create stream");
+      }
+      else
+      {
+        php_stream_to_zval(stream, &args[0]);
+      }
+    }
+    else if (fs->type == PHP_MRLOOP_FS_STAT)
+    {
+      array_init_size(&args[0], 13);
+      add_assoc_long(&args[0], "dev", (zend_long)makedev(fs->stx.stx_dev_major, fs->stx.stx_dev_minor));
+      add_assoc_long(&args[0], "ino", (zend_long)fs->stx.stx_ino);
+      add_assoc_long(&args[0], "mode", (zend_long)fs->stx.stx_mode);
+      add_assoc_long(&args[0], "nlink", (zend_long)fs->stx.stx_nlink);
+      add_assoc_long(&args[0], "uid", (zend_long)fs->stx.stx_uid);
+      add_assoc_long(&args[0], "gid", (zend_long)fs->stx.stx_gid);
+      add_assoc_long(&args[0], "rdev", (zend_long)makedev(fs->stx.stx_rdev_major, fs->stx.stx_rdev_minor));
+      add_assoc_long(&args[0], "size", (zend_long)fs->stx.stx_size);
+      add_assoc_long(&args[0], "atime", (zend_long)fs->stx.stx_atime.tv_sec);
+      add_assoc_long(&args[0], "mtime", (zend_long)fs->stx.stx_mtime.tv_sec);
+      add_assoc_long(&args[0], "ctime", (zend_long)fs->stx.stx_ctime.tv_sec);
+      add_assoc_long(&args[0], "blksize", (zend_long)fs->stx.stx_blksize);
+      add_assoc_long(&args[0], "blocks", (zend_long)fs->stx.stx_blocks);
+    }
+  }
+
+  cb->fci.retval = &result;
+  cb->fci.param_count = argc;
+  cb->fci.params = args;
+
+  if (php_mrloop_call(fs->evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("There is an error in your callback");
+  }
+
+  zval_ptr_dtor(&result);
+  zval_ptr_dtor(&args[0]);
+  if (argc > 1)
+  {
+    zval_ptr_dtor(&args[1]);
+  }
+
+  if (fs->path)
+  {
+    zend_string_release(fs->path);
+  }
+  if (fs->target)
+  {
+    zend_string_release(fs->target);
+  }
+
+  php_mrloop_cb_release(fs->evloop, cb);
+  php_mrloop_slab_release(fs->evloop, fs, sizeof(php_mrloop_fs_t));
+}
+static void php_mrloop_open_file(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+  php_mrloop_fs_t *fs;
+  struct io_uring_sqe *sqe;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  zend_string *path, *mode;
+  int flags;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(3, 3)
+  Z_PARAM_PATH_STR(path)
+  Z_PARAM_STR(mode)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (ZSTR_LEN(mode) == 0 || ZSTR_LEN(mode) >= sizeof(fs->mode) || php_stream_parse_fopen_modes(ZSTR_VAL(mode), &flags) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("Invalid file mode");
+    return;
+  }
+
+  if (php_check_open_basedir(ZSTR_VAL(path)))
+  {
+    PHP_MRLOOP_THROW("Path is outside of the allowed directories");
+    return;
+  }
+
+  if ((fs = php_mrloop_fs_init(this, PHP_MRLOOP_FS_OPEN, &fci, &fci_cache, &sqe)) == NULL)
+  {
+    return;
+  }
+
+  fs->path = zend_string_copy(path);
+  memcpy(fs->mode, ZSTR_VAL(mode), ZSTR_LEN(mode) + 1);
+
+  io_uring_prep_openat(sqe, AT_FDCWD, ZSTR_VAL(fs->path), flags | O_CLOEXEC, 0666);
+  php_mrloop_uring_submit(this);
+}
+static void php_mrloop_stat(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+  php_mrloop_fs_t *fs;
+  struct io_uring_sqe *sqe;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  zend_string *path;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_PATH_STR(path)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (php_check_open_basedir(ZSTR_VAL(path)))
+  {
+    PHP_MRLOOP_THROW("Path is outside of the allowed directories");
+    return;
+  }
+
+  if ((fs = php_mrloop_fs_init(this, PHP_MRLOOP_FS_STAT, &fci, &fci_cache, &sqe)) == NULL)
+  {
+    return;
+  }
+
+  fs->path = zend_string_copy(path);
+
+  io_uring_prep_statx(sqe, AT_FDCWD, ZSTR_VAL(fs->path), 0, STATX_BASIC_STATS, &fs->stx);
+  php_mrloop_uring_submit(this);
+}
+static void php_mrloop_fsync(INTERNAL_FUNCTION_PARAMETERS, bool datasync)
+{
+  zval *obj, *file;
+  php_mrloop_t *this;
+  php_mrloop_fs_t *fs;
+  struct io_uring_sqe *sqe;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  int fd, slot;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_ZVAL(file)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (php_mrloop_file_fd(file, &fd) == FAILURE)
+  {
+    return;
+  }
+
+  // data buffered by PHP streams has to reach the kernel before it can reach storage
+  if (Z_TYPE_P(file) == IS_RESOURCE)
+  {
+    php_stream_flush((php_stream *)zend_fetch_resource_ex(file, NULL, php_file_le_stream()));
+  }
+
+  if ((fs = php_mrloop_fs_init(this, PHP_MRLOOP_FS_FSYNC, &fci, &fci_cache, &sqe)) == NULL)
+  {
+    return;
+  }
+
+  if ((slot = php_mrloop_uring_fixed_file(this, fd)) > -1)
+  {
+    io_uring_prep_fsync(sqe, slot, datasync ? IORING_FSYNC_DATASYNC : 0);
+    sqe->flags |= IOSQE_FIXED_FILE;
+  }
+  else
+  {
+    io_uring_prep_fsync(sqe, fd, datasync ? IORING_FSYNC_DATASYNC : 0);
+  }
+
+  php_mrloop_uring_submit(this);
+}
+static void php_mrloop_close(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj, *file;
+  php_mrloop_t *this;
+  php_mrloop_fs_t *fs;
+  struct io_uring_sqe *sqe;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  int fd;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_ZVAL(file)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (Z_TYPE_P(file) == IS_OBJECT || php_mrloop_file_fd(file, &fd) == FAILURE)
+  {
+    if (!EG(exception))
+    {
+      PHP_MRLOOP_THROW("Connections are closed with Connection::close()");
+    }
+    return;
+  }
+
+  // a registered descriptor would otherwise keep its slot (and the file) after it is closed
+  if (php_mrloop_uring_release_file(this, fd) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("Could not unregister file");
+    return;
+  }
+
+  if (Z_TYPE_P(file) == IS_RESOURCE)
+  {
+    // streams own their descriptors; closing a duplicate leaves the final (potentially slow) release to the ring
+    if ((fd = dup(fd)) < 0)
+    {
+      PHP_MRLOOP_THROW(strerror(errno));
+      return;
+    }
+
+    zend_list_close(Z_RES_P(file));
+  }
+
+  if ((fs = php_mrloop_fs_init(this, PHP_MRLOOP_FS_CLOSE, &fci, &fci_cache, &sqe)) == NULL)
+  {
+    if (Z_TYPE_P(file) == IS_RESOURCE)
+    {
+      close(fd);
+    }
+    return;
+  }
+
+  io_uring_prep_close(sqe, fd);
+  php_mrloop_uring_submit(this);
+}
+static void php_mrloop_rename(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+  php_mrloop_fs_t *fs;
+  struct io_uring_sqe *sqe;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  zend_string *from, *to;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(3, 3)
+  Z_PARAM_PATH_STR(from)
+  Z_PARAM_PATH_STR(to)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (php_check_open_basedir(ZSTR_VAL(from)) || php_check_open_basedir(ZSTR_VAL(to)))
+  {
+    PHP_MRLOOP_THROW("Path is outside of the allowed directories");
+    return;
+  }
+
+  if ((fs = php_mrloop_fs_init(this, PHP_MRLOOP_FS_RENAME, &fci, &fci_cache, &sqe)) == NULL)
+  {
+    return;
+  }
+
+  fs->path = zend_string_copy(from);
+  fs->target = zend_string_copy(to);
+
+  io_uring_prep_renameat(sqe, AT_FDCWD, ZSTR_VAL(fs->path), AT_FDCWD, ZSTR_VAL(fs->target), 0);
+  php_mrloop_uring_submit(this);
+}
+static void php_mrloop_unlink(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+  php_mrloop_fs_t *fs;
+  struct io_uring_sqe *sqe;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  zend_string *path;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_PATH_STR(path)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (php_check_open_basedir(ZSTR_VAL(path)))
+  {
+    PHP_MRLOOP_THROW("Path is outside of the allowed directories");
+    return;
+  }
+
+  if ((fs = php_mrloop_fs_init(this, PHP_MRLOOP_FS_UNLINK, &fci, &fci_cache, &sqe)) == NULL)
+  {
+    return;
+  }
+
+  fs->path = zend_string_copy(path);
+
+  io_uring_prep_unlinkat(sqe, AT_FDCWD, ZSTR_VAL(fs->path), 0);
+  php_mrloop_uring_submit(this);
+}
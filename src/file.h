@@ -0,0 +1,184 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#ifndef __FILE_H__
+#define __FILE_H__
+
+#define PHP_MRLOOP_SPLICE_PIPE_SIZE 262144
+#define PHP_MRLOOP_STREAM_CHUNK_SIZE 65536
+#define PHP_MRLOOP_STREAM_READS 2
+#define PHP_MRLOOP_FS_OPEN 1
+#define PHP_MRLOOP_FS_STAT 2
+#define PHP_MRLOOP_FS_FSYNC 3
+#define PHP_MRLOOP_FS_CLOSE 4
+#define PHP_MRLOOP_FS_RENAME 5
+#define PHP_MRLOOP_FS_UNLINK 6
+
+struct php_mrloop_splice_t;
+struct php_mrloop_stream_t;
+struct php_mrloop_stream_slot_t;
+struct php_mrloop_fs_t;
+typedef struct php_mrloop_splice_t php_mrloop_splice_t;
+typedef struct php_mrloop_stream_t php_mrloop_stream_t;
+typedef struct php_mrloop_stream_slot_t php_mrloop_stream_slot_t;
+typedef struct php_mrloop_fs_t php_mrloop_fs_t;
+typedef struct statx php_statx_t;
+
+/* kernel-side transfer between two descriptors via an intermediate pipe, which bounds the data in flight */
+struct php_mrloop_splice_t
+{
+  /* event loop in which the transfer is subsumed */
+  php_mrloop_t *evloop;
+  /* source -> pipe operation */
+  php_mrloop_op_t in_op;
+  /* pipe -> destination operation */
+  php_mrloop_op_t out_op;
+  /* source file descriptor */
+  int in_fd;
+  /* destination file descriptor */
+  int out_fd;
+  /* intermediate pipe (read end, write end) */
+  int pipe[2];
+  /* capacity of the intermediate pipe */
+  size_t pipe_size;
+  /* offset in the source from which the next chunk is read (-1 reads from the current position) */
+  int64_t offset;
+  /* number of bytes yet to be read from the source (-1 reads until end-of-file) */
+  int64_t remaining;
+  /* number of bytes in the pipe yet to be written to the destination */
+  size_t buffered;
+  /* number of bytes written to the destination */
+  size_t sent;
+  /* whether the source -> pipe operation is in flight */
+  bool in_armed;
+  /* whether the pipe -> destination operation is in flight */
+  bool out_armed;
+  /* whether the end of the source has been reached */
+  bool eof;
+  /* error that ended the transfer prematurely (conveyed once no operation is in flight) */
+  int error;
+  /* source connection (pinned until the transfer completes) */
+  zend_object *src;
+  /* destination connection (pinned until the transfer completes) */
+  zend_object *dst;
+  /* callback invoked upon completion of the transfer */
+  php_mrloop_cb_t *cb;
+};
+
+/* read in flight on behalf of a streaming read */
+struct php_mrloop_stream_slot_t
+{
+  /* read operation */
+  php_mrloop_op_t op;
+  /* streaming read to which the slot belongs */
+  php_mrloop_stream_t *stream;
+  /* string into which data is read (reused for as long as userspace does not retain it) */
+  zend_string *buffer;
+  /* offset at which the read is issued (-1 for non-seekable descriptors) */
+  int64_t offset;
+  /* result of the read */
+  int res;
+  /* whether the read is in flight */
+  bool armed;
+  /* whether the read has completed and awaits delivery */
+  bool done;
+  /* whether the read was issued at an offset invalidated by a preceding short read */
+  bool stale;
+};
+
+/* read of a descriptor, chunk by chunk, until end-of-file (or until the callback returns false) */
+struct php_mrloop_stream_t
+{
+  /* event loop in which the streaming read is subsumed */
+  php_mrloop_t *evloop;
+  /* stream resource (retained for the duration of the streaming read) */
+  zval resource;
+  /* file descriptor */
+  int fd;
+  /* size of each chunk */
+  size_t nbytes;
+  /* offset at which the next read is issued (-1 for non-seekable descriptors) */
+  int64_t offset;
+  /* reads, of which the seekable descriptors of regular files keep several in flight */
+  php_mrloop_stream_slot_t slots[PHP_MRLOOP_STREAM_READS];
+  /* number of reads in use */
+  size_t nslots;
+  /* slot whose read is delivered next */
+  size_t next;
+  /* whether the streaming read has ended (no further reads are issued) */
+  bool finished;
+  /* callback to which chunks are conveyed */
+  php_mrloop_cb_t *cb;
+};
+
+/* filesystem operation whose arguments are retained until it completes */
+struct php_mrloop_fs_t
+{
+  /* filesystem operation */
+  php_mrloop_op_t op;
+  /* event loop in which the operation is subsumed */
+  php_mrloop_t *evloop;
+  /* type of operation (PHP_MRLOOP_FS_*) */
+  int type;
+  /* path on which the operation is performed */
+  zend_string *path;
+  /* destination path (rename only) */
+  zend_string *target;
+  /* fopen-style mode of the stream to create (open only) */
+  char mode[8];
+  /* file metadata (stat only) */
+  php_statx_t stx;
+  /* callback to which the outcome of the operation is conveyed */
+  php_mrloop_cb_t *cb;
+};
+
+/* resolves an integer, stream resource or Connection object to a file descriptor */
+static int php_mrloop_file_fd(zval *res, int *fd);
+/* creates a transfer between two descriptors with a pipe of (at least) the specified capacity; returns NULL (after throwing) upon failure */
+static php_mrloop_splice_t *php_mrloop_splice_init(php_mrloop_t *evloop, int in_fd, int out_fd, size_t pipe_size, zend_fcall_info *fci, zend_fcall_info_cache *fci_cache);
+/* moves as much of the source as the pipe can accommodate into the pipe (linking a write if the pipe is empty); returns false if no submission queue entry is available */
+static bool php_mrloop_splice_in(php_mrloop_splice_t *transfer);
+/* moves the contents of the pipe to the destination; returns false if no submission queue entry is available */
+static bool php_mrloop_splice_out(php_mrloop_splice_t *transfer);
+/* issues whichever operations the state of the pipe permits and concludes finished transfers */
+static void php_mrloop_splice_pump(php_mrloop_splice_t *transfer);
+/* processes completion of a source -> pipe operation */
+static void php_mrloop_splice_in_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* processes completion of a pipe -> destination operation */
+static void php_mrloop_splice_out_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* records the error that ends a transfer, cancels operations in flight and concludes the transfer once none remains */
+static void php_mrloop_splice_fail(php_mrloop_splice_t *transfer, int error);
+/* conveys the outcome of a transfer to its callback and releases the transfer */
+static void php_mrloop_splice_done(php_mrloop_splice_t *transfer);
+/* transfers (a range of) a file to a socket without copying its contents into userspace */
+static void php_mrloop_send_file(INTERNAL_FUNCTION_PARAMETERS);
+/* copies data from one descriptor to another without copying it into userspace */
+static void php_mrloop_pipe(INTERNAL_FUNCTION_PARAMETERS);
+/* issues the read of a streaming read slot at the offset assigned to it */
+static void php_mrloop_stream_arm(php_mrloop_stream_t *stream, php_mrloop_stream_slot_t *slot);
+/* returns the offset at which the next chunk is read and advances past it (-1 for non-seekable descriptors) */
+static int64_t php_mrloop_stream_advance(php_mrloop_stream_t *stream);
+/* processes completion of a streaming read slot */
+static void php_mrloop_stream_read_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* conveys completed reads to the callback in the order in which they were issued */
+static void php_mrloop_stream_deliver(php_mrloop_stream_t *stream);
+/* releases streaming read once no reads are in flight */
+static void php_mrloop_stream_free(php_mrloop_stream_t *stream);
+/* reads a stream chunk by chunk until end-of-file */
+static void php_mrloop_read_stream(INTERNAL_FUNCTION_PARAMETERS);
+/* allocates a filesystem operation bound to a submission queue entry; returns NULL (after throwing) upon failure */
+static php_mrloop_fs_t *php_mrloop_fs_init(php_mrloop_t *evloop, int type, zend_fcall_info *fci, zend_fcall_info_cache *fci_cache, struct io_uring_sqe **sqe);
+/* conveys the outcome of a filesystem operation to its callback */
+static void php_mrloop_fs_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* opens a file and conveys a stream for it */
+static void php_mrloop_open_file(INTERNAL_FUNCTION_PARAMETERS);
+/* retrieves file metadata */
+static void php_mrloop_stat(INTERNAL_FUNCTION_PARAMETERS);
+/* flushes file contents (and, unless datasync is specified, metadata) to storage */
+static void php_mrloop_fsync(INTERNAL_FUNCTION_PARAMETERS, bool datasync);
+/* closes a file descriptor or stream */
+static void php_mrloop_close(INTERNAL_FUNCTION_PARAMETERS);
+/* renames a file */
+static void php_mrloop_rename(INTERNAL_FUNCTION_PARAMETERS);
+/* deletes a file */
+static void php_mrloop_unlink(INTERNAL_FUNCTION_PARAMETERS);
+
+#endif
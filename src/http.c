@@ -0,0 +1,542 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#include "http.h"
+
+static void php_mrloop_http_recv(php_mrloop_conn_t *client, char *buffer, size_t nbytes)
+{
+  php_mrloop_server_t *server = client->server;
+  phr_header_t headers[DEFAULT_HTTP_HEADER_LIMIT];
+  const char *method, *path;
+  size_t method_len, path_len, num_headers, offset, length, body_len, value_len, remaining;
+  int minor_version, ret;
+  char *data;
+  bool keepalive, chunked, framed, invalid, close_after;
+  smart_str response = {0};
+  zval request, fields, *prev;
+  zend_string *name;
+
+  // parse straight from the receive buffer unless part of a request is already pending
+  if (client->npending > 0)
+  {
+    if (client->npending + nbytes > client->pending_cap)
+    {
+      client->pending_cap = client->npending + nbytes;
+      client->pending = erealloc(client->pending, client->pending_cap);
+    }
+
+    memcpy(client->pending + client->npending, buffer, nbytes);
+    client->npending += nbytes;
+
+    data = client->pending;
+    length = client->npending;
+  }
+  else
+  {
+    data = buffer;
+    length = nbytes;
+  }
+
+  offset = 0;
+  close_after = false;
+
+  while (offset < length)
+  {
+    num_headers = DEFAULT_HTTP_HEADER_LIMIT;
+    ret = phr_parse_request(data + offset, length - offset, &method, &method_len, &path, &path_len, &minor_version, headers, &num_headers, 0);
+
+    // request is incomplete
+    if (ret == -2)
+    {
+      break;
+    }
+
+    if (ret == -1)
+    {
+      php_mrloop_http_error(&response, 400);
+      close_after = true;
+
+      break;
+    }
+
+    body_len = 0;
+    chunked = false;
+    framed = false;
+    invalid = false;
+    keepalive = minor_version == 1;
+
+    for (size_t idx = 0; idx < num_headers; idx++)
+    {
+      // skip obsolete line folding
+      if (headers[idx].name == NULL)
+      {
+        continue;
+      }
+
+      if (headers[idx].name_len == 14 && strncasecmp(headers[idx].name, "content-length", 14) == 0)
+      {
+        // a malformed length, or one that conflicts with another, leaves the end of the body open to interpretation
+        if (php_mrloop_http_content_length(headers[idx].value, headers[idx].value_len, server->max_request, &value_len) == FAILURE ||
+            (framed && value_len != body_len))
+        {
+          invalid = true;
+          break;
+        }
+
+        body_len = value_len;
+        framed = true;
+      }
+      else if (headers[idx].name_len == 10 && strncasecmp(headers[idx].name, "connection", 10) == 0)
+      {
+        if (headers[idx].value_len == 5 && strncasecmp(headers[idx].value, "close", 5) == 0)
+        {
+          keepalive = false;
+        }
+        else if (headers[idx].value_len == 10 && strncasecmp(headers[idx].value, "keep-alive", 10) == 0)
+        {
+          keepalive = true;
+        }
+      }
+      else if (headers[idx].name_len == 17 && strncasecmp(headers[idx].name, "transfer-encoding", 17) == 0)
+      {
+        chunked = true;
+      }
+    }
+
+    // requests framed both ways are a classic vector for smuggling requests past proxies
+    if (invalid || (chunked && framed))
+    {
+      php_mrloop_http_error(&response, 400);
+      close_after = true;
+
+      break;
+    }
+
+    if (chunked)
+    {
+      php_mrloop_http_error(&response, 501);
+      close_after = true;
+
+      break;
+    }
+
+    if ((size_t)ret + body_len > server->max_request)
+    {
+      php_mrloop_http_error(&response, 413);
+      close_after = true;
+
+      break;
+    }
+
+    // body is incomplete
+    if (length - offset < (size_t)ret + body_len)
+    {
+      break;
+    }
+
+    array_init_size(&request, 5);
+    add_assoc_stringl(&request, "method", (char *)method, method_len);
+    add_assoc_stringl(&request, "path", (char *)path, path_len);
+    add_assoc_string(&request, "version", minor_version == 1 ? "1.1" : "1.0");
+
+    array_init_size(&fields, (uint32_t)num_headers);
+    for (size_t idx = 0; idx < num_headers; idx++)
+    {
+      if (headers[idx].name == NULL)
+      {
+        continue;
+      }
+
+      name = zend_string_alloc(headers[idx].name_len, 0);
+      zend_str_tolower_copy(ZSTR_VAL(name), headers[idx].name, headers[idx].name_len);
+
+      // repeated fields are combined into a comma-separated list
+      if ((prev = zend_hash_find(Z_ARRVAL(fields), name)) != NULL && Z_TYPE_P(prev) == IS_STRING)
+      {
+        zend_string *combined = zend_string_concat3(Z_STRVAL_P(prev), Z_STRLEN_P(prev), ", ", 2, headers[idx].value, headers[idx].value_len);
+        zval_ptr_dtor(prev);
+        ZVAL_STR(prev, combined);
+      }
+      else
+      {
+        add_assoc_stringl_ex(&fields, ZSTR_VAL(name), ZSTR_LEN(name), (char *)headers[idx].value, headers[idx].value_len);
+      }
+
+      zend_string_release(name);
+    }
+    add_assoc_zval(&request, "headers", &fields);
+    add_assoc_stringl(&request, "body", data + offset + ret, body_len);
+
+    // requests pipelined behind one whose callback fails are not processed; the connection is closed once the responses
+    // serialized thus far are written
+    if (!php_mrloop_http_dispatch(client, &request, minor_version, keepalive, method_len == 4 && memcmp(method, "HEAD", 4) == 0, &response))
+    {
+      zval_ptr_dtor(&request);
+      close_after = true;
+
+      break;
+    }
+    zval_ptr_dtor(&request);
+
+    offset += (size_t)ret + body_len;
+
+    if (!keepalive)
+    {
+      close_after = true;
+      break;
+    }
+  }
+
+  remaining = close_after ? 0 : length - offset;
+
+  if (remaining > server->max_request)
+  {
+    php_mrloop_http_error(&response, 413);
+    close_after = true;
+    remaining = 0;
+  }
+
+  // responses to all requests pipelined in this batch are sent with a single write
+  if (response.s)
+  {
+    php_mrloop_tcp_client_send(client, smart_str_extract(&response));
+  }
+
+  if (remaining > 0)
+  {
+    if (data == client->pending)
+    {
+      memmove(client->pending, client->pending + offset, remaining);
+    }
+    else
+    {
+      if (remaining > client->pending_cap)
+      {
+        client->pending_cap = remaining;
+        client->pending = erealloc(client->pending, client->pending_cap);
+      }
+
+      memcpy(client->pending, data + offset, remaining);
+    }
+  }
+  client->npending = remaining;
+
+  if (close_after)
+  {
+    php_mrloop_tcp_client_close(client);
+  }
+}
+static int php_mrloop_http_content_length(const char *value, size_t value_len, size_t limit, size_t *length)
+{
+  *length = 0;
+
+  if (value_len == 0)
+  {
+    return FAILURE;
+  }
+
+  for (size_t pos = 0; pos < value_len; pos++)
+  {
+    if (value[pos] < '0' || value[pos] > '9')
+    {
+      return FAILURE;
+    }
+
+    // lengths past the limit are rejected as such, however far past it they are
+    if (*length <= limit)
+    {
+      *length = (*length * 10) + (size_t)(value[pos] - '0');
+    }
+  }
+
+  if (*length > limit)
+  {
+    *length = limit + 1;
+  }
+
+  return SUCCESS;
+}
+static bool php_mrloop_http_dispatch(php_mrloop_conn_t *client, zval *request, int minor_version, bool keepalive, bool head, smart_str *response)
+{
+  php_mrloop_cb_t *cb = client->server->cb;
+  zval args[2], result, *status, *headers, *body;
+  zend_string *contents;
+
+  ZVAL_COPY_VALUE(&args[0], request);
+  ZVAL_OBJ(&args[1], &client->std);
+
+  cb->fci.retval = &result;
+  cb->fci.param_count = 2;
+  cb->fci.params = args;
+
+  if (php_mrloop_call(client->evloop, &cb->fci, &cb->fci_cache) == FAILURE || EG(exception))
+  {
+    zval_ptr_dtor(&result);
+
+    return php_mrloop_http_abort(client, minor_version, head, response);
+  }
+
+  if (Z_TYPE(result) == IS_STRING)
+  {
+    php_mrloop_http_serialize(client, response, minor_version, 200, NULL, Z_STR(result), keepalive, head);
+  }
+  else if (Z_TYPE(result) == IS_ARRAY)
+  {
+    status = zend_hash_str_find(Z_ARRVAL(result), ZEND_STRL("status"));
+    headers = zend_hash_str_find(Z_ARRVAL(result), ZEND_STRL("headers"));
+    body = zend_hash_str_find(Z_ARRVAL(result), ZEND_STRL("body"));
+
+    if (body)
+    {
+      ZVAL_DEREF(body);
+    }
+
+    // a response that would go out garbled (or split in two) is treated like a failed callback
+    if (body && Z_TYPE_P(body) > IS_STRING)
+    {
+      PHP_MRLOOP_THROW("Response body must be a scalar");
+    }
+    else if (headers && Z_TYPE_P(headers) == IS_ARRAY)
+    {
+      php_mrloop_http_headers_valid(Z_ARRVAL_P(headers));
+    }
+
+    if (EG(exception))
+    {
+      zval_ptr_dtor(&result);
+
+      return php_mrloop_http_abort(client, minor_version, head, response);
+    }
+
+    contents = body ? zval_get_string(body) : NULL;
+
+    php_mrloop_http_serialize(
+      client,
+      response,
+      minor_version,
+      status ? zval_get_long(status) : 200,
+      headers && Z_TYPE_P(headers) == IS_ARRAY ? Z_ARRVAL_P(headers) : (HashTable *)&zend_empty_array,
+      contents,
+      keepalive,
+      head);
+
+    if (contents)
+    {
+      zend_string_release(contents);
+    }
+  }
+  else
+  {
+    php_mrloop_http_serialize(client, response, minor_version, 204, (HashTable *)&zend_empty_array, NULL, keepalive, head);
+  }
+
+  zval_ptr_dtor(&result);
+
+  return true;
+}
+static bool php_mrloop_http_abort(php_mrloop_conn_t *client, int minor_version, bool head, smart_str *response)
+{
+  php_mrloop_http_serialize(client, response, minor_version, 500, NULL, NULL, false, head);
+
+  // the loop is stopped so that the exception propagates from run()
+  mr_stop(client->evloop->loop);
+
+  return false;
+}
+static int php_mrloop_http_headers_valid(HashTable *headers)
+{
+  zend_string *key;
+  zval *entry;
+  const char *value;
+  size_t value_len;
+
+  ZEND_HASH_FOREACH_STR_KEY_VAL(headers, key, entry)
+  {
+    if (key == NULL)
+    {
+      continue;
+    }
+
+    if (ZSTR_LEN(key) == 0 || strspn(ZSTR_VAL(key), PHP_MRLOOP_HTTP_TOKEN) != ZSTR_LEN(key))
+    {
+      PHP_MRLOOP_THROW("Response header names must be tokens");
+      return FAILURE;
+    }
+
+    ZVAL_DEREF(entry);
+    if (Z_TYPE_P(entry) > IS_STRING)
+    {
+      PHP_MRLOOP_THROW("Response header values must be scalars");
+      return FAILURE;
+    }
+
+    // line breaks in a value would end the header (or the head of the response) early
+    if (Z_TYPE_P(entry) == IS_STRING)
+    {
+      value = Z_STRVAL_P(entry);
+      value_len = Z_STRLEN_P(entry);
+
+      if (memchr(value, '\r', value_len) || memchr(value, '\n', value_len) || memchr(value, '\0', value_len))
+      {
+        PHP_MRLOOP_THROW("Response header values must not contain CR, LF or NUL characters");
+        return FAILURE;
+      }
+    }
+  }
+  ZEND_HASH_FOREACH_END();
+
+  return SUCCESS;
+}
+static void php_mrloop_http_serialize(php_mrloop_conn_t *client, smart_str *response, int minor_version, zend_long status, HashTable *headers, zend_string *body, bool keepalive, bool head)
+{
+  zend_string *key, *value;
+  zval *entry;
+
+  smart_str_appendl(response, "HTTP/1.", 7);
+  smart_str_append_long(response, minor_version);
+  smart_str_appendc(response, ' ');
+  smart_str_append_long(response, status);
+  smart_str_appendc(response, ' ');
+  smart_str_appends(response, php_mrloop_http_reason(status));
+  smart_str_appendl(response, "\r\n", 2);
+
+  if (headers == NULL)
+  {
+    smart_str_appendl(response, ZEND_STRL("Content-Type: text/html; charset=UTF-8\r\n"));
+  }
+  else
+  {
+    ZEND_HASH_FOREACH_STR_KEY_VAL(headers, key, entry)
+    {
+      // framing headers are computed here
+      if (key == NULL ||
+          zend_string_equals_literal_ci(key, "content-length") ||
+          zend_string_equals_literal_ci(key, "transfer-encoding") ||
+          zend_string_equals_literal_ci(key, "connection"))
+      {
+        continue;
+      }
+
+      value = zval_get_string(entry);
+
+      smart_str_append(response, key);
+      smart_str_appendl(response, ": ", 2);
+      smart_str_append(response, value);
+      smart_str_appendl(response, "\r\n", 2);
+
+      zend_string_release(value);
+    }
+    ZEND_HASH_FOREACH_END();
+  }
+
+  smart_str_appendl(response, ZEND_STRL("Content-Length: "));
+  smart_str_append_unsigned(response, body ? ZSTR_LEN(body) : 0);
+  smart_str_appendl(response, "\r\n", 2);
+
+  if (!keepalive)
+  {
+    smart_str_appendl(response, ZEND_STRL("Connection: close\r\n"));
+  }
+  else if (minor_version == 0)
+  {
+    smart_str_appendl(response, ZEND_STRL("Connection: keep-alive\r\n"));
+  }
+
+  smart_str_appendl(response, "\r\n", 2);
+
+  if (body == NULL || head)
+  {
+    return;
+  }
+
+  // larger bodies are queued by reference behind the head of the response (and written along with it) instead of
+  // being copied into it
+  if (client && ZSTR_LEN(body) > PHP_MRLOOP_HTTP_INLINE_BODY)
+  {
+    php_mrloop_tcp_client_send(client, smart_str_extract(response));
+    php_mrloop_tcp_client_send(client, zend_string_copy(body));
+  }
+  else
+  {
+    smart_str_append(response, body);
+  }
+}
+static void php_mrloop_http_error(smart_str *response, zend_long status)
+{
+  zend_string *body = zend_string_init(php_mrloop_http_reason(status), strlen(php_mrloop_http_reason(status)), 0);
+
+  php_mrloop_http_serialize(NULL, response, 1, status, NULL, body, false, false);
+  zend_string_release(body);
+}
+static const char *php_mrloop_http_reason(zend_long status)
+{
+  switch (status)
+  {
+  case 100:
+    return "Continue";
+  case 101:
+    return "Switching Protocols";
+  case 200:
+    return "OK";
+  case 201:
+    return "Created";
+  case 202:
+    return "Accepted";
+  case 204:
+    return "No Content";
+  case 206:
+    return "Partial Content";
+  case 301:
+    return "Moved Permanently";
+  case 302:
+    return "Found";
+  case 303:
+    return "See Other";
+  case 304:
+    return "Not Modified";
+  case 307:
+    return "Temporary Redirect";
+  case 308:
+    return "Permanent Redirect";
+  case 400:
+    return "Bad Request";
+  case 401:
+    return "Unauthorized";
+  case 403:
+    return "Forbidden";
+  case 404:
+    return "Not Found";
+  case 405:
+    return "Method Not Allowed";
+  case 408:
+    return "Request Timeout";
+  case 409:
+    return "Conflict";
+  case 411:
+    return "Length Required";
+  case 413:
+    return "Content Too Large";
+  case 415:
+    return "Unsupported Media Type";
+  case 416:
+    return "Range Not Satisfiable";
+  case 422:
+    return "Unprocessable Content";
+  case 429:
+    return "Too Many Requests";
+  case 500:
+    return "Internal Server Error";
+  case 501:
+    return "Not Implemented";
+  case 502:
+    return "Bad Gateway";
+  case 503:
+    return "Service Unavailable";
+  case 504:
+    return "Gateway Timeout";
+  default:
+    return "Unknown";
+  }
+}
+static void php_mrloop_http_server_listen(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_server_listen(INTERNAL_FUNCTION_PARAM_PASSTHRU, PHP_MRLOOP_PROTOCOL_HTTP);
+}
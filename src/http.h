@@ -0,0 +1,34 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#ifndef __HTTP_H__
+#define __HTTP_H__
+
+#include "picohttpparser.c"
+
+#define PHP_MRLOOP_HTTP_MAX_REQUEST 1048576
+
+/* size up to which response bodies are copied after the headers rather than written from the string returned */
+#define PHP_MRLOOP_HTTP_INLINE_BODY 1024
+
+/* characters of which header names (RFC 9110 tokens) consist */
+#define PHP_MRLOOP_HTTP_TOKEN "!#$%&'*+-.^_`|~0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+
+/* parses requests received from a client (including pipelined ones) and issues responses */
+static void php_mrloop_http_recv(php_mrloop_conn_t *client, char *buffer, size_t nbytes);
+/* parses a Content-Length value (saturating past the limit); returns FAILURE unless it consists of digits alone */
+static int php_mrloop_http_content_length(const char *value, size_t value_len, size_t limit, size_t *length);
+/* conveys a parsed request to the HTTP server callback and serializes the ensuing response; returns false (after serializing an error response) if the callback fails */
+static bool php_mrloop_http_dispatch(php_mrloop_conn_t *client, zval *request, int minor_version, bool keepalive, bool head, smart_str *response);
+/* serializes a server error response to a request whose callback failed and stops the loop; returns false */
+static bool php_mrloop_http_abort(php_mrloop_conn_t *client, int minor_version, bool head, smart_str *response);
+/* checks that response header names are tokens and their values scalars free of line breaks; returns FAILURE (after throwing) otherwise */
+static int php_mrloop_http_headers_valid(HashTable *headers);
+/* serializes a status line, headers, and body into a response (queueing both on the client if the body is large and a client is given) */
+static void php_mrloop_http_serialize(php_mrloop_conn_t *client, smart_str *response, int minor_version, zend_long status, HashTable *headers, zend_string *body, bool keepalive, bool head);
+/* serializes an error response after which the connection is closed */
+static void php_mrloop_http_error(smart_str *response, zend_long status);
+/* returns the reason phrase of a status code */
+static const char *php_mrloop_http_reason(zend_long status);
+/* starts an HTTP server */
+static void php_mrloop_http_server_listen(INTERNAL_FUNCTION_PARAMETERS);
+
+#endif
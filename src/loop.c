@@ -8,35 +8,190 @@ static zend_object *php_mrloop_create_object(zend_class_entry *ce)
 
   obj->std.handlers = &php_mrloop_object_handlers;
   obj->loop = NULL;
+  obj->uring = NULL;
+  memset(&obj->uring_setup, 0, sizeof(php_mrloop_uring_setup_t));
+  obj->uring_setup.entries = PHP_MRLOOP_URING_ENTRIES;
+  obj->servers = NULL;
+  obj->udp_servers = NULL;
+  obj->pool = NULL;
+  obj->wheel = NULL;
+  obj->timers = NULL;
+  obj->conns = NULL;
+  obj->lookups = NULL;
+  obj->batch = 0;
+  obj->mr_pending = false;
+  memset(obj->slabs, 0, sizeof(obj->slabs));
+  obj->ticks = NULL;
+  obj->tick_head = 0;
+  obj->nticks = 0;
+  obj->tick_cap = 0;
+  obj->tick_budget = PHP_MRLOOP_TICK_BUDGET;
+  obj->tick_armed = false;
+  obj->running = false;
+  obj->sig_cb = NULL;
+  obj->sigc = 0;
+  obj->sig_next = NULL;
+  obj->sig_fd = -1;
+  sigemptyset(&obj->sig_mask);
+  sigemptyset(&obj->sig_blocked);
+  obj->sig_op.handler = php_mrloop_signal_cb;
+  obj->sig_op.data = obj;
+  obj->sig_armed = false;
+  memset(&obj->stats, 0, sizeof(php_mrloop_stats_t));
 
   return &obj->std;
 }
 static void php_mrloop_free_object(zend_object *obj)
 {
   php_mrloop_t *intern = php_mrloop_from_obj(obj);
+  php_mrloop_server_t *server, *next;
+  php_mrloop_udp_t *udp, *udp_next;
 
   if (intern->loop)
   {
     mr_free(intern->loop);
   }
 
+  php_mrloop_pool_free(intern);
+  php_mrloop_conns_free(intern);
+  php_mrloop_lookups_free(intern);
+
+  for (server = intern->servers; server != NULL; server = next)
+  {
+    next = server->next;
+    php_mrloop_tcp_server_free(server);
+  }
+
+  for (udp = intern->udp_servers; udp != NULL; udp = udp_next)
+  {
+    udp_next = udp->next;
+    php_mrloop_udp_server_free(udp);
+  }
+
+  php_mrloop_wheel_free(intern);
+
+  if (intern->uring)
+  {
+    php_mrloop_uring_free(intern->uring);
+  }
+
+  php_mrloop_signal_free(intern);
+  php_mrloop_tick_free(intern);
+  php_mrloop_slab_free(intern);
+
+  // the object itself is released by the engine
+  zend_object_std_dtor(obj);
+}
+static zend_object *php_mrloop_conn_create_object(zend_class_entry *ce)
+{
+  php_mrloop_conn_t *conn = zend_object_alloc(sizeof(php_mrloop_conn_t), ce);
+  zend_object_std_init(&conn->std, ce);
+
+  conn->std.handlers = &php_mrloop_conn_object_handlers;
+  conn->fd = -1;
+  // connections not bound to a server (i.e. those created in userspace) are unusable
+  conn->closing = true;
+
+  return &conn->std;
+}
+static void php_mrloop_conn_free_object(zend_object *obj)
+{
+  php_mrloop_conn_t *conn = php_mrloop_conn_from_obj(obj);
+
+  // during shutdown, the connection may be released before its event loop
+  if (conn->psibling)
+  {
+    php_mrloop_conn_unlink(conn);
+  }
+
+  if (conn->fd > -1)
+  {
+    if (conn->evloop)
+    {
+      php_mrloop_uring_release_file(conn->evloop, conn->fd);
+    }
+    close(conn->fd);
+  }
+
+  if (conn->addr)
+  {
+    efree(conn->addr);
+  }
+  if (conn->buffer)
+  {
+    efree(conn->buffer);
+  }
+  if (conn->pending)
+  {
+    efree(conn->pending);
+  }
+  if (conn->read_cb)
+  {
+    PHP_MRLOOP_CB_FREE(conn->read_cb);
+  }
+  if (conn->pool_key)
+  {
+    zend_string_release(conn->pool_key);
+  }
+
+  for (size_t idx = 0; idx < conn->nqueue; idx++)
+  {
+    zend_string_release(conn->queue[idx]);
+  }
+  if (conn->queue)
+  {
+    efree(conn->queue);
+    efree(conn->iov);
+  }
+
   zend_object_std_dtor(obj);
-  efree(intern);
 }
 
 static void php_mrloop_signal_handler(const int sig)
 {
-  exit(EXIT_SUCCESS);
+  // signals with userspace handlers are blocked and read via a signalfd; the rest meet their default fate
+  signal(sig, SIG_DFL);
+  raise(sig);
 }
 static void php_mrloop_create(INTERNAL_FUNCTION_PARAMETERS)
 {
   php_mrloop_t *evloop;
+  php_mrloop_uring_setup_t setup;
+  HashTable *options;
+  zend_long tick_budget;
 
-  ZEND_PARSE_PARAMETERS_NONE();
+  options = NULL;
+
+  ZEND_PARSE_PARAMETERS_START(0, 1)
+  Z_PARAM_OPTIONAL
+  Z_PARAM_ARRAY_HT_OR_NULL(options)
+  ZEND_PARSE_PARAMETERS_END();
+
+  memset(&setup, 0, sizeof(php_mrloop_uring_setup_t));
+  setup.entries = PHP_MRLOOP_URING_ENTRIES;
+
+  // the options configure the extension-managed ring (mrloop creates its own ring with fixed defaults)
+  if (options && php_mrloop_uring_configure(&setup, options) == FAILURE)
+  {
+    return;
+  }
+
+  if ((tick_budget = php_mrloop_option_long(options, "tick_budget", PHP_MRLOOP_TICK_BUDGET)) < 1)
+  {
+    PHP_MRLOOP_THROW("Tick budget must be positive");
+    return;
+  }
 
   object_init_ex(return_value, php_mrloop_ce);
   evloop = PHP_MRLOOP_OBJ(return_value);
 
+  evloop->uring_setup = setup;
+  evloop->tick_budget = (size_t)tick_budget;
+#ifdef HAVE_MRLOOP_STATS
+  evloop->stats.enabled = php_mrloop_option_bool(options, "stats", false);
+  evloop->stats.since = php_mrloop_stats_now();
+#endif
+
   mr_loop_t *loop = mr_create_loop(php_mrloop_signal_handler);
   evloop->loop = loop;
 }
@@ -51,6 +206,8 @@ static void php_mrloop_stop(INTERNAL_FUNCTION_PARAMETERS)
 
   this = PHP_MRLOOP_OBJ(obj);
 
+  // ticks yet to run remain queued for the next run
+  this->running = false;
   mr_stop(this->loop);
 }
 static void php_mrloop_run(INTERNAL_FUNCTION_PARAMETERS)
@@ -64,385 +221,1935 @@ static void php_mrloop_run(INTERNAL_FUNCTION_PARAMETERS)
 
   this = PHP_MRLOOP_OBJ(obj);
 
+  // ticks queued in a batch before the loop starts (or left over from a stopped run) have yet to be scheduled
+  if (this->nticks > 0)
+  {
+    php_mrloop_tick_arm(this);
+  }
+
+  // operations queued before the loop starts (in a batch or otherwise) must not wait for the first completion
+  php_mrloop_flush_all(this);
+
+  this->running = true;
   mr_run(this->loop);
+  this->running = false;
+}
+static void php_mrloop_batch_begin(php_mrloop_t *evloop)
+{
+  evloop->batch++;
+}
+static void php_mrloop_batch_end(php_mrloop_t *evloop)
+{
+  if (evloop->batch > 0 && --evloop->batch == 0)
+  {
+    // ticks are drained before submission so that the operations they queue are submitted along with the rest
+    if (evloop->running && evloop->nticks > 0)
+    {
+      php_mrloop_tick_drain(evloop);
+    }
+
+    php_mrloop_flush_all(evloop);
+  }
 }
+static void php_mrloop_flush_all(php_mrloop_t *evloop)
+{
+  if (evloop->mr_pending)
+  {
+    evloop->mr_pending = false;
+    mr_flush(evloop->loop);
+    PHP_MRLOOP_STATS_COUNT(evloop, mr_flushes, 1);
+  }
 
-static int php_mrloop_timer_cb(void *data)
+  if (evloop->uring && io_uring_sq_ready(&evloop->uring->ring) > 0)
+  {
+    PHP_MRLOOP_STATS_SUBMIT(evloop, io_uring_submit(&evloop->uring->ring));
+  }
+}
+static void php_mrloop_mr_submit(php_mrloop_t *evloop)
 {
-  php_mrloop_cb_t *cb = (php_mrloop_cb_t *)data;
+  if (evloop->batch > 0)
+  {
+    evloop->mr_pending = true;
+    return;
+  }
+
+  mr_flush(evloop->loop);
+  PHP_MRLOOP_STATS_COUNT(evloop, mr_flushes, 1);
+}
+static void php_mrloop_batch(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  fci.retval = return_value;
+  fci.param_count = 0;
+  fci.params = NULL;
+
+  php_mrloop_batch_begin(this);
+
+  if (php_mrloop_call(this, &fci, &fci_cache) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("There is an error in your callback");
+  }
+
+  // an exception thrown by the callable propagates only after whatever it queued has been submitted
+  php_mrloop_batch_end(this);
+}
+static void php_mrloop_flush(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+
+  obj = getThis();
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  php_mrloop_flush_all(this);
+}
+
+static void php_mrloop_tick_arm(php_mrloop_t *evloop)
+{
+  if (evloop->tick_armed)
+  {
+    return;
+  }
+
+  evloop->tick_armed = true;
+  mr_call_soon(evloop->loop, php_mrloop_tick_cb, evloop);
+}
+static int php_mrloop_tick_cb(void *data)
+{
+  php_mrloop_t *evloop = (php_mrloop_t *)data;
+
+  evloop->tick_armed = false;
+
+  // the queue is drained as the batch closes
+  php_mrloop_batch_begin(evloop);
+  php_mrloop_batch_end(evloop);
+
+  return 0;
+}
+static void php_mrloop_tick_drain(php_mrloop_t *evloop)
+{
+  php_mrloop_tick_t tick;
   zval result;
-  int type;
+  size_t budget;
+  int ret;
 
-  cb->fci.retval = &result;
-  cb->fci.param_count = 0;
-  cb->fci.params = NULL;
+  // an exception pending from the completion that precedes the drain would see every tick skipped
+  if (EG(exception))
+  {
+    return;
+  }
 
-  type = cb->signal;
+  // the ticks are run in a batch of their own; those they queue join the queue rather than draining it anew
+  evloop->batch++;
 
-  if (zend_call_function(&cb->fci, &cb->fci_cache) == FAILURE)
+  for (budget = evloop->tick_budget; evloop->running && evloop->nticks > 0 && budget > 0; budget--)
   {
-    efree(cb);
-    mr_stop((mr_loop_t *)cb->data);
+    // the tick is copied out of the ring, which the callback may grow
+    tick = evloop->ticks[evloop->tick_head];
+    evloop->tick_head = (evloop->tick_head + 1) & (evloop->tick_cap - 1);
+    evloop->nticks--;
 
-    PHP_MRLOOP_THROW("There is an error in your callback");
-    zval_ptr_dtor(&result);
+    tick.fci.retval = &result;
+    tick.fci.param_count = tick.argc;
+    tick.fci.params = tick.args;
+
+    ret = php_mrloop_call(evloop, &tick.fci, &tick.fci_cache);
+    PHP_MRLOOP_STATS_COUNT(evloop, ticks, 1);
+
+    if (ret == SUCCESS)
+    {
+      zval_ptr_dtor(&result);
+    }
+    php_mrloop_tick_release(evloop, &tick);
 
-    return 0;
+    if (ret == FAILURE)
+    {
+      PHP_MRLOOP_THROW("There is an error in your callback");
+    }
+
+    // the loop is stopped so that the exception propagates from run(); the remaining ticks stay queued
+    if (EG(exception))
+    {
+      mr_stop(evloop->loop);
+      break;
+    }
   }
 
-  // add explicit timer cancellation to periodic timer
-  if (type == PHP_MRLOOP_PERIODIC_TIMER && Z_TYPE(result) == IS_LONG && Z_LVAL(result) == 0)
+  evloop->batch--;
+
+  // ticks in excess of the budget run once pending completions have been processed
+  if (evloop->running && evloop->nticks > 0 && !EG(exception))
   {
-    zval_ptr_dtor(&result);
-    efree(cb);
+    php_mrloop_tick_arm(evloop);
+  }
+}
+static void php_mrloop_tick_release(php_mrloop_t *evloop, php_mrloop_tick_t *tick)
+{
+  for (uint32_t idx = 0; idx < tick->argc; idx++)
+  {
+    zval_ptr_dtor(&tick->args[idx]);
+  }
+  if (tick->argc > 0)
+  {
+    php_mrloop_slab_release(evloop, tick->args, tick->argc * sizeof(zval));
+  }
 
-    return 0;
+  zval_ptr_dtor(&tick->fci.function_name);
+  if (tick->fci.object)
+  {
+    OBJ_RELEASE(tick->fci.object);
+  }
+}
+static void php_mrloop_tick_free(php_mrloop_t *evloop)
+{
+  while (evloop->nticks > 0)
+  {
+    php_mrloop_tick_release(evloop, &evloop->ticks[evloop->tick_head]);
+    evloop->tick_head = (evloop->tick_head + 1) & (evloop->tick_cap - 1);
+    evloop->nticks--;
   }
 
-  zval_ptr_dtor(&result);
-  efree(cb);
+  if (evloop->ticks)
+  {
+    efree(evloop->ticks);
+  }
 
-  return type == PHP_MRLOOP_TIMER || type == PHP_MRLOOP_FUTURE_TICK ? 0 : 1;
+  evloop->ticks = NULL;
+  evloop->tick_head = 0;
+  evloop->tick_cap = 0;
 }
-static void php_mrloop_add_timer(INTERNAL_FUNCTION_PARAMETERS)
+static void php_mrloop_add_future_tick(INTERNAL_FUNCTION_PARAMETERS)
 {
-  zval *obj;
-  double interval;
+  zval *obj, *args;
   php_mrloop_t *this;
-  php_mrloop_cb_t *cb;
+  php_mrloop_tick_t *tick, *ticks;
   zend_fcall_info fci;
   zend_fcall_info_cache fci_cache;
+  uint32_t argc;
+  size_t idx;
 
   fci = empty_fcall_info;
   fci_cache = empty_fcall_info_cache;
   obj = getThis();
+  args = NULL;
+  argc = 0;
 
-  ZEND_PARSE_PARAMETERS_START(2, 2)
-  Z_PARAM_DOUBLE(interval)
+  ZEND_PARSE_PARAMETERS_START(1, -1)
   Z_PARAM_FUNC(fci, fci_cache)
+  Z_PARAM_VARIADIC('*', args, argc)
   ZEND_PARSE_PARAMETERS_END();
 
   this = PHP_MRLOOP_OBJ(obj);
-  cb = emalloc(sizeof(php_mrloop_cb_t));
-  PHP_CB_TO_MRLOOP_CB(cb, fci, fci_cache);
 
-  cb->signal = PHP_MRLOOP_TIMER;
-  cb->data = this->loop;
+  // the ring is unrolled into one twice its size once full
+  if (this->nticks == this->tick_cap)
+  {
+    ticks = emalloc((this->tick_cap > 0 ? this->tick_cap * 2 : PHP_MRLOOP_TICK_QUEUE_SIZE) * sizeof(php_mrloop_tick_t));
+
+    for (idx = 0; idx < this->nticks; idx++)
+    {
+      ticks[idx] = this->ticks[(this->tick_head + idx) & (this->tick_cap - 1)];
+    }
+
+    if (this->ticks)
+    {
+      efree(this->ticks);
+    }
+
+    this->ticks = ticks;
+    this->tick_head = 0;
+    this->tick_cap = this->tick_cap > 0 ? this->tick_cap * 2 : PHP_MRLOOP_TICK_QUEUE_SIZE;
+  }
+
+  tick = &this->ticks[(this->tick_head + this->nticks) & (this->tick_cap - 1)];
+  PHP_CB_TO_MRLOOP_CB(tick, fci, fci_cache);
+
+  // the arguments are conveyed as they are, sans the closure that would otherwise bind them
+  tick->argc = argc;
+  tick->args = argc > 0 ? php_mrloop_slab_alloc(this, argc * sizeof(zval)) : NULL;
+  for (idx = 0; idx < argc; idx++)
+  {
+    ZVAL_COPY(&tick->args[idx], &args[idx]);
+  }
 
-  mr_call_after(this->loop, php_mrloop_timer_cb, (interval * 1000), cb);
+  this->nticks++;
+
+  // ticks queued in a batch (a completion being processed included) are run as it closes
+  if (this->batch == 0 || !this->running)
+  {
+    php_mrloop_tick_arm(this);
+  }
 
   return;
 }
-static void php_mrloop_add_periodic_timer(INTERNAL_FUNCTION_PARAMETERS)
+
+static size_t php_mrloop_iov_slice(php_iovec_t *iov, char *base, size_t nbytes, size_t vcount)
+{
+  size_t idx, share;
+
+  // vectors are never empty (save for that describing an empty region)
+  if (vcount > nbytes)
+  {
+    vcount = nbytes > 0 ? nbytes : 1;
+  }
+
+  share = nbytes / vcount;
+  for (idx = 0; idx < vcount; idx++)
+  {
+    iov[idx].iov_base = base + (idx * share);
+    iov[idx].iov_len = idx == vcount - 1 ? nbytes - (idx * share) : share;
+  }
+
+  return vcount;
+}
+static php_mrloop_read_t *php_mrloop_read_init(php_mrloop_t *evloop, zval *nbytes, size_t vcount)
+{
+  php_mrloop_read_t *request;
+  zval *size;
+  size_t count, idx;
+
+  if (Z_TYPE_P(nbytes) == IS_ARRAY)
+  {
+    count = zend_hash_num_elements(Z_ARRVAL_P(nbytes));
+
+    if (count == 0 || count > PHP_MRLOOP_READ_MAX_IOV)
+    {
+      PHP_MRLOOP_THROW("List of buffer sizes must contain between 1 and 1024 sizes");
+      return NULL;
+    }
+
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(nbytes), size)
+    {
+      if (Z_TYPE_P(size) != IS_LONG || Z_LVAL_P(size) < 1)
+      {
+        PHP_MRLOOP_THROW("Buffer sizes must be positive integers");
+        return NULL;
+      }
+    }
+    ZEND_HASH_FOREACH_END();
+
+    // each buffer is its own string and is described by a single vector
+    request = php_mrloop_slab_alloc(evloop, sizeof(php_mrloop_read_t));
+    request->evloop = evloop;
+    PHP_MRLOOP_STATS_STAMP(evloop, request);
+    request->list = true;
+    request->nbuffers = count;
+    request->iovcnt = count;
+    request->iovcap = count;
+    request->buffers = php_mrloop_slab_alloc(evloop, count * sizeof(zend_string *));
+    request->iov = php_mrloop_slab_alloc(evloop, count * sizeof(php_iovec_t));
+
+    idx = 0;
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(nbytes), size)
+    {
+      request->buffers[idx] = zend_string_alloc((size_t)Z_LVAL_P(size), 0);
+      request->iov[idx].iov_base = ZSTR_VAL(request->buffers[idx]);
+      request->iov[idx].iov_len = (size_t)Z_LVAL_P(size);
+      idx++;
+    }
+    ZEND_HASH_FOREACH_END();
+
+    return request;
+  }
+
+  if (Z_TYPE_P(nbytes) == IS_LONG && Z_LVAL_P(nbytes) < 1)
+  {
+    PHP_MRLOOP_THROW("Number of bytes to read must be positive");
+    return NULL;
+  }
+
+  if (vcount < 1 || vcount > PHP_MRLOOP_READ_MAX_IOV)
+  {
+    PHP_MRLOOP_THROW("Vector count must be between 1 and 1024");
+    return NULL;
+  }
+
+  // a single string whose contents are split across the requested number of vectors
+  request = php_mrloop_slab_alloc(evloop, sizeof(php_mrloop_read_t));
+  request->evloop = evloop;
+  PHP_MRLOOP_STATS_STAMP(evloop, request);
+  request->list = false;
+  request->nbuffers = 1;
+  request->buffers = php_mrloop_slab_alloc(evloop, sizeof(zend_string *));
+  request->buffers[0] = zend_string_alloc(Z_TYPE_P(nbytes) == IS_LONG ? (size_t)Z_LVAL_P(nbytes) : DEFAULT_STREAM_BUFF_LEN, 0);
+  request->iovcap = vcount;
+  request->iov = php_mrloop_slab_alloc(evloop, vcount * sizeof(php_iovec_t));
+  request->iovcnt = php_mrloop_iov_slice(request->iov, ZSTR_VAL(request->buffers[0]), ZSTR_LEN(request->buffers[0]), vcount);
+
+  return request;
+}
+static void php_mrloop_read_free(php_mrloop_read_t *request)
+{
+  for (size_t idx = 0; idx < request->nbuffers; idx++)
+  {
+    if (request->buffers[idx])
+    {
+      zend_string_release(request->buffers[idx]);
+    }
+  }
+
+  php_mrloop_slab_release(request->evloop, request->buffers, request->nbuffers * sizeof(zend_string *));
+  php_mrloop_slab_release(request->evloop, request->iov, request->iovcap * sizeof(php_iovec_t));
+  php_mrloop_slab_release(request->evloop, request, sizeof(php_mrloop_read_t));
+}
+static php_mrloop_write_t *php_mrloop_write_init(php_mrloop_t *evloop, HashTable *chunks, zend_string *contents, size_t vcount)
+{
+  php_mrloop_write_t *request;
+  zval *chunk;
+  size_t count, idx;
+
+  if (chunks)
+  {
+    count = zend_hash_num_elements(chunks);
+
+    if (count == 0 || count > PHP_MRLOOP_WRITE_MAX_IOV)
+    {
+      PHP_MRLOOP_THROW("List of chunks must contain between 1 and 1024 strings");
+      return NULL;
+    }
+
+    ZEND_HASH_FOREACH_VAL(chunks, chunk)
+    {
+      if (Z_TYPE_P(chunk) != IS_STRING)
+      {
+        PHP_MRLOOP_THROW("Chunks must be strings");
+        return NULL;
+      }
+    }
+    ZEND_HASH_FOREACH_END();
+
+    // the strings are pinned rather than concatenated; each is described by a single vector
+    request = php_mrloop_slab_alloc(evloop, sizeof(php_mrloop_write_t));
+    request->evloop = evloop;
+    PHP_MRLOOP_STATS_STAMP(evloop, request);
+    request->nchunks = count;
+    request->iovcnt = count;
+    request->iovcap = count;
+    request->chunks = php_mrloop_slab_alloc(evloop, count * sizeof(zend_string *));
+    request->iov = php_mrloop_slab_alloc(evloop, count * sizeof(php_iovec_t));
+
+    idx = 0;
+    ZEND_HASH_FOREACH_VAL(chunks, chunk)
+    {
+      request->chunks[idx] = zend_string_copy(Z_STR_P(chunk));
+      request->iov[idx].iov_base = Z_STRVAL_P(chunk);
+      request->iov[idx].iov_len = Z_STRLEN_P(chunk);
+      idx++;
+    }
+    ZEND_HASH_FOREACH_END();
+
+    return request;
+  }
+
+  if (vcount < 1 || vcount > PHP_MRLOOP_WRITE_MAX_IOV)
+  {
+    PHP_MRLOOP_THROW("Vector count must be between 1 and 1024");
+    return NULL;
+  }
+
+  request = php_mrloop_slab_alloc(evloop, sizeof(php_mrloop_write_t));
+  request->evloop = evloop;
+  PHP_MRLOOP_STATS_STAMP(evloop, request);
+  request->nchunks = 1;
+  request->chunks = php_mrloop_slab_alloc(evloop, sizeof(zend_string *));
+  request->chunks[0] = zend_string_copy(contents);
+  request->iovcap = vcount;
+  request->iov = php_mrloop_slab_alloc(evloop, vcount * sizeof(php_iovec_t));
+  request->iovcnt = php_mrloop_iov_slice(request->iov, ZSTR_VAL(contents), ZSTR_LEN(contents), vcount);
+
+  return request;
+}
+static void php_mrloop_write_free(php_mrloop_write_t *request)
+{
+  for (size_t idx = 0; idx < request->nchunks; idx++)
+  {
+    zend_string_release(request->chunks[idx]);
+  }
+
+  php_mrloop_slab_release(request->evloop, request->chunks, request->nchunks * sizeof(zend_string *));
+  php_mrloop_slab_release(request->evloop, request->iov, request->iovcap * sizeof(php_iovec_t));
+  php_mrloop_slab_release(request->evloop, request, sizeof(php_mrloop_write_t));
+}
+static void php_mrloop_readv_cb(void *data, int res)
 {
-  zval *obj;
-  double interval;
-  php_mrloop_t *this;
   php_mrloop_cb_t *cb;
-  zend_fcall_info fci;
-  zend_fcall_info_cache fci_cache;
+  php_mrloop_read_t *request;
+  php_mrloop_t *evloop;
+  zval args[2], result;
+  size_t remaining, nbytes;
+
+  cb = (php_mrloop_cb_t *)data;
+  request = (php_mrloop_read_t *)cb->data;
+  evloop = request->evloop;
+  PHP_MRLOOP_STATS_ELAPSED(evloop, latency[PHP_MRLOOP_STATS_READ], request);
+
+  if (res < 0)
+  {
+    PHP_MRLOOP_THROW(strerror(-res));
+
+    php_mrloop_read_free(request);
+    php_mrloop_cb_release(evloop, cb);
+
+    return;
+  }
+
+  // the kernel wrote straight into the strings; it only remains to trim them to the number of bytes read
+  remaining = (size_t)res;
+  for (size_t idx = 0; idx < request->nbuffers; idx++)
+  {
+    nbytes = remaining < ZSTR_LEN(request->buffers[idx]) ? remaining : ZSTR_LEN(request->buffers[idx]);
+    remaining -= nbytes;
+
+    if (nbytes < ZSTR_LEN(request->buffers[idx]))
+    {
+      request->buffers[idx] = zend_string_truncate(request->buffers[idx], nbytes, 0);
+    }
+    ZSTR_VAL(request->buffers[idx])[nbytes] = '\0';
+  }
+
+  if (request->list)
+  {
+    array_init_size(&args[0], (uint32_t)request->nbuffers);
+    for (size_t idx = 0; idx < request->nbuffers; idx++)
+    {
+      add_next_index_str(&args[0], request->buffers[idx]);
+      request->buffers[idx] = NULL;
+    }
+  }
+  else
+  {
+    ZVAL_STR(&args[0], request->buffers[0]);
+    request->buffers[0] = NULL;
+  }
+  ZVAL_LONG(&args[1], res);
+
+  cb->fci.retval = &result;
+  cb->fci.param_count = 2;
+  cb->fci.params = args;
+
+  php_mrloop_batch_begin(evloop);
+
+  if (php_mrloop_call(evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("There is an error in your callback");
+  }
+
+  php_mrloop_batch_end(evloop);
+
+  zval_ptr_dtor(&result);
+  zval_ptr_dtor(&args[0]);
+  php_mrloop_read_free(request);
+  php_mrloop_cb_release(evloop, cb);
+
+  return;
+}
+static void php_mrloop_writev_cb(void *data, int res)
+{
+  php_mrloop_cb_t *cb = (php_mrloop_cb_t *)data;
+  php_mrloop_t *evloop = ((php_mrloop_write_t *)cb->data)->evloop;
+  zval args[1], result;
+
+  PHP_MRLOOP_STATS_ELAPSED(evloop, latency[PHP_MRLOOP_STATS_WRITE], (php_mrloop_write_t *)cb->data);
+  php_mrloop_write_free((php_mrloop_write_t *)cb->data);
+
+  if (res < 0)
+  {
+    PHP_MRLOOP_THROW(strerror(-res));
+    php_mrloop_cb_release(evloop, cb);
+
+    return;
+  }
+
+  ZVAL_LONG(&args[0], res);
+
+  cb->fci.retval = &result;
+  cb->fci.param_count = 1;
+  cb->fci.params = args;
+
+  php_mrloop_batch_begin(evloop);
+
+  if (php_mrloop_call(evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("There is an error in your callback");
+  }
+
+  php_mrloop_batch_end(evloop);
+
+  zval_ptr_dtor(&result);
+  php_mrloop_cb_release(evloop, cb);
+
+  return;
+}
+static void php_mrloop_writev_release_cb(void *data, int res)
+{
+  PHP_MRLOOP_STATS_ELAPSED(((php_mrloop_write_t *)data)->evloop, latency[PHP_MRLOOP_STATS_WRITE], (php_mrloop_write_t *)data);
+  php_mrloop_write_free((php_mrloop_write_t *)data);
+}
+
+static php_mrloop_conn_t *php_mrloop_tcp_client_init(int fd)
+{
+  php_mrloop_conn_t *conn;
+  php_sockaddr_storage_t addr;
+  socklen_t socklen;
+  char ip_str[INET6_ADDRSTRLEN];
+
+  // the event loop holds the initial reference; userspace callbacks share it for as long as they see fit
+  conn = php_mrloop_conn_from_obj(php_mrloop_conn_create_object(php_mrloop_conn_ce));
+  conn->fd = fd;
+  conn->closing = false;
+
+  socklen = sizeof(php_sockaddr_storage_t);
+  memset(&addr, 0, sizeof(addr));
+
+  if (getpeername(fd, (struct sockaddr *)&addr, &socklen) > -1)
+  {
+    switch (addr.ss_family)
+    {
+    case AF_INET:
+      inet_ntop(AF_INET, &((php_sockaddr_t *)&addr)->sin_addr, ip_str, INET6_ADDRSTRLEN);
+      conn->addr = estrdup(ip_str);
+      conn->port = (size_t)ntohs(((php_sockaddr_t *)&addr)->sin_port);
+      break;
+    case AF_INET6:
+      inet_ntop(AF_INET6, &((php_sockaddr_in6_t *)&addr)->sin6_addr, ip_str, INET6_ADDRSTRLEN);
+      conn->addr = estrdup(ip_str);
+      conn->port = (size_t)ntohs(((php_sockaddr_in6_t *)&addr)->sin6_port);
+      break;
+    case AF_UNIX:
+      // clients seldom bind their sockets, in which case the path is empty
+      conn->addr = estrndup(((php_sockaddr_un_t *)&addr)->sun_path, socklen > offsetof(php_sockaddr_un_t, sun_path) ? strnlen(((php_sockaddr_un_t *)&addr)->sun_path, socklen - offsetof(php_sockaddr_un_t, sun_path)) : 0);
+      break;
+    }
+  }
+
+  return conn;
+}
+static void php_mrloop_tcp_server_respond(php_mrloop_conn_t *client, char *buffer, size_t nbytes)
+{
+  php_mrloop_cb_t *cb = client->server->cb;
+  zval args[2], result;
+  ZVAL_STRINGL(&args[0], buffer, nbytes);
+  ZVAL_OBJ_COPY(&args[1], &client->std);
+
+  cb->fci.retval = &result;
+  cb->fci.param_count = 2;
+  cb->fci.params = args;
+
+  if (php_mrloop_call(client->evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("There is an error in your callback");
+    zval_ptr_dtor(&args[0]);
+    zval_ptr_dtor(&args[1]);
+    zval_ptr_dtor(&result);
+
+    return;
+  }
+
+  // the response is queued by reference and outlives the result until written
+  if (Z_TYPE(result) == IS_STRING)
+  {
+    php_mrloop_tcp_client_send(client, zend_string_copy(Z_STR(result)));
+  }
+
+  zval_ptr_dtor(&args[0]);
+  zval_ptr_dtor(&args[1]);
+  zval_ptr_dtor(&result);
+}
+static int php_mrloop_tcp_server_address(zend_string *address, zend_long port, php_sockaddr_storage_t *addr, socklen_t *addrlen)
+{
+  php_sockaddr_t *in;
+  php_sockaddr_in6_t *in6;
+  php_sockaddr_un_t *un;
+  char host[INET6_ADDRSTRLEN];
+  const char *spec, *sep;
+  size_t len, host_len;
+  zend_long lport;
+
+  memset(addr, 0, sizeof(php_sockaddr_storage_t));
+
+  // a bare port number binds to all IPv4 interfaces
+  if (address == NULL)
+  {
+    in = (php_sockaddr_t *)addr;
+    in->sin_family = AF_INET;
+    in->sin_addr.s_addr = htonl(INADDR_ANY);
+    in->sin_port = htons((uint16_t)port);
+    *addrlen = sizeof(php_sockaddr_t);
+
+    return port < 0 || port > 65535 ? FAILURE : SUCCESS;
+  }
+
+  spec = ZSTR_VAL(address);
+  len = ZSTR_LEN(address);
+
+  if (len > 7 && strncmp(spec, "unix://", 7) == 0)
+  {
+    un = (php_sockaddr_un_t *)addr;
+    if (len - 7 >= sizeof(un->sun_path))
+    {
+      return FAILURE;
+    }
+
+    un->sun_family = AF_UNIX;
+    memcpy(un->sun_path, spec + 7, len - 7);
+    *addrlen = (socklen_t)(offsetof(php_sockaddr_un_t, sun_path) + len - 7 + 1);
+
+    return SUCCESS;
+  }
+
+  if (len > 6 && strncmp(spec, "tcp://", 6) == 0)
+  {
+    spec += 6;
+    len -= 6;
+  }
+
+  if ((sep = zend_memrchr(spec, ':', len)) == NULL || sep == spec + len - 1)
+  {
+    return FAILURE;
+  }
+
+  lport = ZEND_STRTOL(sep + 1, NULL, 10);
+  if (lport < 0 || lport > 65535)
+  {
+    return FAILURE;
+  }
+
+  host_len = (size_t)(sep - spec);
+
+  // IPv6 addresses are bracketed so as not to confuse their colons with the port separator
+  if (host_len > 1 && spec[0] == '[' && spec[host_len - 1] == ']')
+  {
+    spec++;
+    host_len -= 2;
+  }
+
+  if (host_len == 0 || host_len >= INET6_ADDRSTRLEN)
+  {
+    return FAILURE;
+  }
+
+  memcpy(host, spec, host_len);
+  host[host_len] = '\0';
+
+  in = (php_sockaddr_t *)addr;
+  if (inet_pton(AF_INET, host, &in->sin_addr) == 1)
+  {
+    in->sin_family = AF_INET;
+    in->sin_port = htons((uint16_t)lport);
+    *addrlen = sizeof(php_sockaddr_t);
+
+    return SUCCESS;
+  }
+
+  in6 = (php_sockaddr_in6_t *)addr;
+  if (inet_pton(AF_INET6, host, &in6->sin6_addr) == 1)
+  {
+    in6->sin6_family = AF_INET6;
+    in6->sin6_port = htons((uint16_t)lport);
+    *addrlen = sizeof(php_sockaddr_in6_t);
+
+    return SUCCESS;
+  }
+
+  return FAILURE;
+}
+static int php_mrloop_tcp_server_bind(php_sockaddr_storage_t *addr, socklen_t addrlen, bool reuseport)
+{
+  php_stat_t st;
+  int fd, opt;
+
+  if ((fd = socket(addr->ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+  {
+    PHP_MRLOOP_THROW(strerror(errno));
+
+    return -1;
+  }
+
+  opt = 1;
+
+  if (addr->ss_family == AF_UNIX)
+  {
+    // a socket file left behind by a previous run would otherwise fail the bind
+    if (stat(((php_sockaddr_un_t *)addr)->sun_path, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+      unlink(((php_sockaddr_un_t *)addr)->sun_path);
+    }
+  }
+  else
+  {
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // each worker binds its own socket so that the kernel distributes connections among them
+    if (reuseport && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)
+    {
+      close(fd);
+      PHP_MRLOOP_THROW(strerror(errno));
+
+      return -1;
+    }
+  }
+
+  if (bind(fd, (struct sockaddr *)addr, addrlen) < 0 || listen(fd, SOMAXCONN) < 0)
+  {
+    close(fd);
+    PHP_MRLOOP_THROW(strerror(errno));
+
+    return -1;
+  }
+
+  return fd;
+}
+static php_mrloop_server_t *php_mrloop_tcp_server_init(php_mrloop_t *evloop, int fd, size_t max_conn, size_t buff_count, size_t buff_size)
+{
+  php_mrloop_server_t *server;
+
+  if (php_mrloop_uring(evloop) == NULL)
+  {
+    close(fd);
+
+    return NULL;
+  }
+
+  server = ecalloc(1, sizeof(php_mrloop_server_t));
+  server->evloop = evloop;
+  server->fd = fd;
+  server->max_conn = max_conn;
+  server->multishot = true;
+  server->buff_count = buff_count;
+  server->buff_size = buff_size;
+  server->bgid = -1;
+
+  if (buff_count > 0 && (server->bgid = php_mrloop_uring_buf_ring(evloop, buff_count, buff_size, &server->br, &server->buffers)) < 0)
+  {
+    close(fd);
+    efree(server);
+
+    return NULL;
+  }
+
+  server->accept_op.handler = php_mrloop_tcp_server_accept_cb;
+  server->accept_op.data = server;
+
+  server->next = evloop->servers;
+  evloop->servers = server;
+
+  return server;
+}
+static void php_mrloop_tcp_server_accept(php_mrloop_server_t *server)
+{
+  struct io_uring_sqe *sqe = php_mrloop_uring_sqe(server->evloop, &server->accept_op);
+
+  if (sqe == NULL)
+  {
+    PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+    return;
+  }
+
+  // a single multishot accept posts a completion for every incoming connection
+  if (server->multishot)
+  {
+    io_uring_prep_multishot_accept(sqe, server->fd, NULL, NULL, SOCK_CLOEXEC);
+  }
+  else
+  {
+    io_uring_prep_accept(sqe, server->fd, NULL, NULL, SOCK_CLOEXEC);
+  }
+
+  php_mrloop_uring_submit(server->evloop);
+}
+static void php_mrloop_tcp_server_accept_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_server_t *server = (php_mrloop_server_t *)op->data;
+  php_mrloop_conn_t *client;
+
+  if (cqe->res >= 0)
+  {
+    if (server->nconn >= server->max_conn)
+    {
+      close(cqe->res);
+    }
+    else
+    {
+      client = php_mrloop_tcp_client_init(cqe->res);
+      php_mrloop_conn_link(server->evloop, client);
+      client->server = server;
+      client->buff_size = server->buff_size;
+      client->recv_op.handler = php_mrloop_tcp_client_recv_cb;
+      client->recv_op.data = client;
+      client->write_op.handler = php_mrloop_tcp_client_send_cb;
+      client->write_op.data = client;
+
+      if (server->br == NULL)
+      {
+        client->buffer = emalloc(client->buff_size);
+      }
+
+      server->nconn++;
+      php_mrloop_tcp_client_recv(client);
+    }
+  }
+  else if (cqe->res == -EINVAL && server->multishot)
+  {
+    // kernel predates multishot accept; fall back to re-arming single-shot accepts
+    server->multishot = false;
+  }
+  else if (cqe->res == -EBADF || cqe->res == -EINVAL || cqe->res == -ECANCELED)
+  {
+    // listening socket is no longer usable
+    return;
+  }
+
+  if (!(cqe->flags & IORING_CQE_F_MORE))
+  {
+    php_mrloop_tcp_server_accept(server);
+  }
+}
+static void php_mrloop_tcp_client_recv(php_mrloop_conn_t *client)
+{
+  php_mrloop_server_t *server = client->server;
+  struct io_uring_sqe *sqe = php_mrloop_uring_sqe(client->evloop, &client->recv_op);
+
+  if (sqe == NULL)
+  {
+    php_mrloop_tcp_client_close(client);
+    return;
+  }
+
+  if (server && server->br)
+  {
+    // no buffer is pinned to the connection; one is selected from the group upon arrival of data
+    io_uring_prep_recv_multishot(sqe, client->fd, NULL, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = server->bgid;
+  }
+  else
+  {
+    io_uring_prep_recv(sqe, client->fd, client->buffer, client->buff_size, 0);
+  }
+
+  client->recv_armed = true;
+  php_mrloop_uring_submit(client->evloop);
+}
+static void php_mrloop_tcp_client_recv_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_conn_t *client = (php_mrloop_conn_t *)op->data;
+  php_mrloop_server_t *server = client->server;
+  unsigned short bid;
+  char *buffer;
+
+  bid = 0;
+  if (!(cqe->flags & IORING_CQE_F_MORE))
+  {
+    client->recv_armed = false;
+  }
+
+  // the callback may close the connection; the context must outlive the processing of this completion
+  GC_ADDREF(&client->std);
+
+  buffer = client->buffer;
+  if (cqe->flags & IORING_CQE_F_BUFFER)
+  {
+    bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    buffer = server->buffers + (bid * server->buff_size);
+  }
+
+  if (cqe->res > 0 && !client->closing)
+  {
+    // responses issued while processing are coalesced into a single write
+    client->dispatching = true;
+
+    if (server->protocol == PHP_MRLOOP_PROTOCOL_HTTP)
+    {
+      php_mrloop_http_recv(client, buffer, (size_t)cqe->res);
+    }
+    else
+    {
+      php_mrloop_tcp_server_respond(client, buffer, (size_t)cqe->res);
+    }
+
+    client->dispatching = false;
+    php_mrloop_tcp_client_flush(client);
+  }
+
+  if (cqe->flags & IORING_CQE_F_BUFFER)
+  {
+    // return buffer to the ring so that the kernel can reuse it
+    io_uring_buf_ring_add(server->br, buffer, (unsigned)server->buff_size, bid, io_uring_buf_ring_mask((unsigned)server->buff_count), 0);
+    io_uring_buf_ring_advance(server->br, 1);
+  }
+
+  if (client->closing)
+  {
+    php_mrloop_tcp_client_release(client);
+  }
+  // all buffers are in use (-ENOBUFS) is transient; anything else at or below zero ends the connection
+  else if (cqe->res <= 0 && cqe->res != -ENOBUFS)
+  {
+    php_mrloop_tcp_client_close(client);
+  }
+  else if (!client->recv_armed)
+  {
+    php_mrloop_tcp_client_recv(client);
+  }
+
+  OBJ_RELEASE(&client->std);
+}
+static void php_mrloop_tcp_client_send(php_mrloop_conn_t *client, zend_string *data)
+{
+  if (client->closing || client->fd < 0 || ZSTR_LEN(data) == 0)
+  {
+    zend_string_release(data);
+    return;
+  }
+
+  if (client->nqueue == client->queue_cap)
+  {
+    client->queue_cap = client->queue_cap == 0 ? PHP_MRLOOP_WRITE_QUEUE_SIZE : client->queue_cap * 2;
+    client->queue = erealloc(client->queue, client->queue_cap * sizeof(zend_string *));
+    client->iov = erealloc(client->iov, client->queue_cap * sizeof(php_iovec_t));
+  }
+
+  client->queue[client->nqueue++] = data;
+
+  if (!client->dispatching)
+  {
+    php_mrloop_tcp_client_flush(client);
+  }
+}
+static void php_mrloop_tcp_client_flush(php_mrloop_conn_t *client)
+{
+  struct io_uring_sqe *sqe;
+  size_t count;
+
+  // writes are issued one at a time so that queued data is delivered in order
+  if (client->write_armed || client->nqueue == 0 || client->fd < 0)
+  {
+    return;
+  }
+
+  count = client->nqueue < PHP_MRLOOP_WRITE_MAX_IOV ? client->nqueue : PHP_MRLOOP_WRITE_MAX_IOV;
+  for (size_t idx = 0; idx < count; idx++)
+  {
+    client->iov[idx].iov_base = ZSTR_VAL(client->queue[idx]);
+    client->iov[idx].iov_len = ZSTR_LEN(client->queue[idx]);
+  }
+  client->iov[0].iov_base = ZSTR_VAL(client->queue[0]) + client->queue_offset;
+  client->iov[0].iov_len -= client->queue_offset;
+
+  if ((sqe = php_mrloop_uring_sqe(client->evloop, &client->write_op)) == NULL)
+  {
+    php_mrloop_tcp_client_discard(client);
+    php_mrloop_tcp_client_close(client);
+
+    return;
+  }
+
+  memset(&client->msg, 0, sizeof(struct msghdr));
+  client->msg.msg_iov = client->iov;
+  client->msg.msg_iovlen = count;
+
+  io_uring_prep_sendmsg(sqe, client->fd, &client->msg, MSG_NOSIGNAL);
+  client->write_armed = true;
+
+  php_mrloop_uring_submit(client->evloop);
+}
+static void php_mrloop_tcp_client_send_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_conn_t *client = (php_mrloop_conn_t *)op->data;
+  size_t nbytes, remaining, idx;
+
+  client->write_armed = false;
+
+  if (cqe->res < 0)
+  {
+    php_mrloop_tcp_client_discard(client);
+    php_mrloop_tcp_client_close(client);
+
+    return;
+  }
+
+  // release fully written strings; a partially written one stays at the head of the queue
+  nbytes = (size_t)cqe->res;
+  for (idx = 0; idx < client->nqueue; idx++)
+  {
+    remaining = ZSTR_LEN(client->queue[idx]) - client->queue_offset;
+
+    if (nbytes < remaining)
+    {
+      client->queue_offset += nbytes;
+      break;
+    }
+
+    nbytes -= remaining;
+    client->queue_offset = 0;
+    zend_string_release(client->queue[idx]);
+  }
+
+  client->nqueue -= idx;
+  if (idx > 0 && client->nqueue > 0)
+  {
+    memmove(client->queue, client->queue + idx, client->nqueue * sizeof(zend_string *));
+  }
+
+  if (client->nqueue > 0)
+  {
+    php_mrloop_tcp_client_flush(client);
+  }
+  else if (client->closing)
+  {
+    php_mrloop_tcp_client_release(client);
+  }
+}
+static void php_mrloop_tcp_client_discard(php_mrloop_conn_t *client)
+{
+  for (size_t idx = 0; idx < client->nqueue; idx++)
+  {
+    zend_string_release(client->queue[idx]);
+  }
+
+  client->nqueue = 0;
+  client->queue_offset = 0;
+}
+static void php_mrloop_tcp_client_close(php_mrloop_conn_t *client)
+{
+  struct io_uring_sqe *sqe;
+
+  if (!client->closing && client->recv_armed)
+  {
+    // the pending receive references the client context; it must complete before the latter is released
+    if ((sqe = php_mrloop_uring_sqe(client->evloop, NULL)) != NULL)
+    {
+      io_uring_prep_cancel(sqe, &client->recv_op, 0);
+      php_mrloop_uring_submit(client->evloop);
+    }
+  }
+
+  client->closing = true;
+  php_mrloop_tcp_client_release(client);
+}
+static void php_mrloop_tcp_client_release(php_mrloop_conn_t *client)
+{
+  if (client->recv_armed || client->write_armed || client->nqueue > 0 || client->fd < 0)
+  {
+    return;
+  }
+
+  if (client->pooled)
+  {
+    php_mrloop_pool_remove(client);
+  }
+
+  php_mrloop_uring_release_file(client->evloop, client->fd);
+  close(client->fd);
+  client->fd = -1;
+
+  if (client->server)
+  {
+    client->server->nconn--;
+  }
+
+  // buffers are reclaimed along with the object once userspace drops its references to it
+  php_mrloop_conn_unlink(client);
+  OBJ_RELEASE(&client->std);
+}
+static void php_mrloop_conn_link(php_mrloop_t *evloop, php_mrloop_conn_t *conn)
+{
+  conn->evloop = evloop;
+
+  conn->sibling = evloop->conns;
+  if (conn->sibling)
+  {
+    conn->sibling->psibling = &conn->sibling;
+  }
+  conn->psibling = &evloop->conns;
+  evloop->conns = conn;
+}
+static void php_mrloop_conn_unlink(php_mrloop_conn_t *conn)
+{
+  *conn->psibling = conn->sibling;
+  if (conn->sibling)
+  {
+    conn->sibling->psibling = conn->psibling;
+  }
+
+  conn->sibling = NULL;
+  conn->psibling = NULL;
+}
+static void php_mrloop_conns_free(php_mrloop_t *evloop)
+{
+  php_mrloop_conn_t *conn;
+
+  while ((conn = evloop->conns) != NULL)
+  {
+    php_mrloop_conn_unlink(conn);
+
+    // operations in flight are abandoned along with the ring; their completions are never processed
+    php_mrloop_tcp_client_discard(conn);
+    if (conn->fd > -1)
+    {
+      close(conn->fd);
+      conn->fd = -1;
+    }
+    conn->recv_armed = false;
+    conn->write_armed = false;
+    conn->closing = true;
+    conn->evloop = NULL;
+    conn->server = NULL;
+
+    OBJ_RELEASE(&conn->std);
+  }
+}
+static void php_mrloop_conn_write(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zend_string *contents;
+  php_mrloop_conn_t *this;
+
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+  Z_PARAM_STR(contents)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_CONN_OBJ(getThis());
+
+  if (this->closing || this->evloop == NULL)
+  {
+    PHP_MRLOOP_THROW("Connection is closed");
+    return;
+  }
+
+  // the string is shared rather than copied; it is pinned until the write completes
+  php_mrloop_tcp_client_send(this, zend_string_copy(contents));
+}
+static void php_mrloop_conn_close(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_conn_t *this;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  this = PHP_MRLOOP_CONN_OBJ(getThis());
+
+  // connections outlive neither their event loops nor their servers
+  if (this->evloop == NULL)
+  {
+    PHP_MRLOOP_THROW("Connection is closed");
+    return;
+  }
+
+  if (!this->closing)
+  {
+    php_mrloop_tcp_client_close(this);
+  }
+}
+static void php_mrloop_conn_remote_address(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_conn_t *this;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  this = PHP_MRLOOP_CONN_OBJ(getThis());
+
+  RETURN_STRING(this->addr ? this->addr : "");
+}
+static void php_mrloop_conn_remote_port(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_conn_t *this;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  this = PHP_MRLOOP_CONN_OBJ(getThis());
+
+  RETURN_LONG((zend_long)this->port);
+}
+static void php_mrloop_conn_fd(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_conn_t *this;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  this = PHP_MRLOOP_CONN_OBJ(getThis());
+
+  RETURN_LONG(this->fd);
+}
+static void php_mrloop_tcp_server_free(php_mrloop_server_t *server)
+{
+  php_mrloop_uring_t *uring = server->evloop->uring;
+
+  if (uring && server->br)
+  {
+    io_uring_free_buf_ring(&uring->ring, server->br, (unsigned)server->buff_count, server->bgid);
+  }
+
+  close(server->fd);
+  if (server->path)
+  {
+    unlink(server->path);
+    efree(server->path);
+  }
+  if (server->buffers)
+  {
+    efree(server->buffers);
+  }
+  if (server->cb)
+  {
+    PHP_MRLOOP_CB_FREE(server->cb);
+  }
+  efree(server);
+}
+static void php_mrloop_worker_reset(php_mrloop_t *evloop)
+{
+  php_mrloop_server_t *server;
+  php_mrloop_udp_t *udp;
+
+  // the parent's rings are mapped into the worker; tearing them down here only drops the worker's references
+  if (evloop->loop)
+  {
+    mr_free(evloop->loop);
+  }
+
+  // listeners registered before the fork are shared with the parent (and the other workers); the kernel distributes
+  // their connections and datagrams among the processes accepting them. Buffer rings are registered with the parent's
+  // ring and are replaced below
+  for (server = evloop->servers; server != NULL; server = server->next)
+  {
+    server->br = NULL;
+    server->bgid = -1;
+    server->nconn = 0;
+    server->multishot = true;
+    if (server->buffers)
+    {
+      efree(server->buffers);
+      server->buffers = NULL;
+    }
+    // socket files are removed by the parent
+    if (server->path)
+    {
+      efree(server->path);
+      server->path = NULL;
+    }
+  }
+
+  for (udp = evloop->udp_servers; udp != NULL; udp = udp->next)
+  {
+    udp->br = NULL;
+    udp->recv_armed = false;
+    udp->dispatch_scheduled = false;
+    udp->count = 0;
+    efree(udp->buffers);
+    udp->buffers = NULL;
+    zval_ptr_dtor(&udp->datagrams);
+    zval_ptr_dtor(&udp->peers);
+    ZVAL_UNDEF(&udp->datagrams);
+    ZVAL_UNDEF(&udp->peers);
+  }
+
+  // the worker's copies of pooled and other live sockets are closed; the parent's remain usable
+  php_mrloop_pool_free(evloop);
+  php_mrloop_conns_free(evloop);
+  php_mrloop_lookups_free(evloop);
+
+  if (evloop->uring)
+  {
+    php_mrloop_uring_free(evloop->uring);
+    evloop->uring = NULL;
+  }
+
+  evloop->loop = mr_create_loop(php_mrloop_signal_handler);
+
+  if ((evloop->servers || evloop->udp_servers) && php_mrloop_uring(evloop) != NULL)
+  {
+    for (server = evloop->servers; server != NULL; server = server->next)
+    {
+      // a listener whose buffer ring cannot be replaced is left idle (the exception surfaces from tcpServer())
+      if (server->buff_count > 0 &&
+          (server->bgid = php_mrloop_uring_buf_ring(evloop, server->buff_count, server->buff_size, &server->br, &server->buffers)) < 0)
+      {
+        continue;
+      }
+
+      php_mrloop_tcp_server_accept(server);
+    }
+
+    for (udp = evloop->udp_servers; udp != NULL; udp = udp->next)
+    {
+      if ((udp->bgid = php_mrloop_uring_buf_ring(evloop, udp->buff_count, udp->buff_size, &udp->br, &udp->buffers)) < 0)
+      {
+        continue;
+      }
+
+      php_mrloop_udp_recv(udp);
+    }
+  }
+
+  // the signalfd read in flight in the parent's ring is lost with it
+  evloop->sig_armed = false;
+  if (evloop->sig_fd > -1 && php_mrloop_uring(evloop) != NULL)
+  {
+    php_mrloop_signal_arm(evloop);
+  }
+
+  // so is the timeout which drives the timing wheel
+  if (evloop->wheel)
+  {
+    evloop->wheel->armed = false;
+    if (php_mrloop_uring(evloop) != NULL)
+    {
+      php_mrloop_wheel_arm(evloop);
+    }
+  }
+
+  // a wake-up scheduled in the parent's loop is lost with it
+  evloop->tick_armed = false;
+  if (evloop->nticks > 0)
+  {
+    php_mrloop_tick_arm(evloop);
+  }
+}
+static bool php_mrloop_tcp_server_supervise(php_mrloop_t *evloop, size_t workers)
+{
+  sigset_t mask, omask;
+  siginfo_t info;
+  struct timespec timeout;
+  pid_t *pids, pid;
+  time_t *started, *respawn, now, wait;
+  size_t live, idx;
+  int status, ret;
+  bool shutdown;
+
+  // the supervisor serves nothing itself; tearing its ring down cancels the accepts armed in it, which would otherwise
+  // claim connections on listeners shared with the workers
+  if (evloop->uring)
+  {
+    php_mrloop_uring_free(evloop->uring);
+    evloop->uring = NULL;
+  }
+
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  sigaddset(&mask, SIGQUIT);
+  sigaddset(&mask, SIGHUP);
+  sigprocmask(SIG_BLOCK, &mask, &omask);
+
+  pids = ecalloc(workers, sizeof(pid_t));
+  started = ecalloc(workers, sizeof(time_t));
+  respawn = ecalloc(workers, sizeof(time_t));
+  live = 0;
+  shutdown = false;
+
+  for (;;)
+  {
+    now = time(NULL);
+    wait = -1;
+
+    // (re)spawn workers in vacant slots; those of workers that crashed on startup stay vacant until their delay lapses
+    for (idx = 0; idx < workers && !shutdown; idx++)
+    {
+      if (pids[idx] != 0)
+      {
+        continue;
+      }
+
+      if (respawn[idx] > now)
+      {
+        wait = wait < 0 || respawn[idx] - now < wait ? respawn[idx] - now : wait;
+        continue;
+      }
+
+      if ((pid = fork()) == 0)
+      {
+        sigprocmask(SIG_SETMASK, &omask, NULL);
+        efree(pids);
+        efree(started);
+        efree(respawn);
+        MRLOOP_G(worker) = true;
+        php_mrloop_worker_reset(evloop);
+
+        return true;
+      }
+
+      if (pid < 0)
+      {
+        PHP_MRLOOP_THROW(strerror(errno));
+        shutdown = true;
+        break;
+      }
+
+      pids[idx] = pid;
+      started[idx] = now;
+      respawn[idx] = 0;
+      live++;
+    }
+
+    if (live == 0 && (shutdown || wait < 0))
+    {
+      break;
+    }
+
+    // signals are awaited no longer than the earliest delayed respawn
+    if (shutdown || wait < 0)
+    {
+      ret = sigwaitinfo(&mask, &info);
+    }
+    else
+    {
+      timeout.tv_sec = wait;
+      timeout.tv_nsec = 0;
+      ret = sigtimedwait(&mask, &info, &timeout);
+    }
+
+    if (ret < 0)
+    {
+      continue;
+    }
 
-  fci = empty_fcall_info;
-  fci_cache = empty_fcall_info_cache;
-  obj = getThis();
+    if (info.si_signo != SIGCHLD)
+    {
+      // relay signal to workers; all but SIGHUP initiate shutdown
+      shutdown = shutdown || info.si_signo != SIGHUP;
+      for (idx = 0; idx < workers; idx++)
+      {
+        if (pids[idx] > 0)
+        {
+          kill(pids[idx], info.si_signo);
+        }
+      }
 
-  ZEND_PARSE_PARAMETERS_START(2, 2)
-  Z_PARAM_DOUBLE(interval)
-  Z_PARAM_FUNC(fci, fci_cache)
-  ZEND_PARSE_PARAMETERS_END();
+      continue;
+    }
 
-  this = PHP_MRLOOP_OBJ(obj);
-  cb = emalloc(sizeof(php_mrloop_cb_t));
-  PHP_CB_TO_MRLOOP_CB(cb, fci, fci_cache);
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+      for (idx = 0; idx < workers; idx++)
+      {
+        if (pids[idx] != pid)
+        {
+          continue;
+        }
+
+        live--;
+        pids[idx] = 0;
+
+        // workers that exit cleanly are not replaced
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        {
+          pids[idx] = -1;
+        }
+        else if (time(NULL) - started[idx] < PHP_MRLOOP_WORKER_RESPAWN_DELAY)
+        {
+          // throttle workers that crash on startup
+          respawn[idx] = started[idx] + PHP_MRLOOP_WORKER_RESPAWN_DELAY;
+        }
 
-  cb->signal = PHP_MRLOOP_PERIODIC_TIMER;
-  cb->data = this->loop;
+        break;
+      }
+    }
+  }
 
-  mr_add_timer(this->loop, interval, php_mrloop_timer_cb, cb);
+  sigprocmask(SIG_SETMASK, &omask, NULL);
+  efree(pids);
+  efree(started);
+  efree(respawn);
 
-  return;
+  return false;
 }
-static void php_mrloop_add_future_tick(INTERNAL_FUNCTION_PARAMETERS)
+static void php_mrloop_server_listen(INTERNAL_FUNCTION_PARAMETERS, int protocol)
 {
   zval *obj;
-  php_mrloop_cb_t *cb;
   php_mrloop_t *this;
+  php_mrloop_server_t *server;
   zend_fcall_info fci;
   zend_fcall_info_cache fci_cache;
+  zend_string *address;
+  zend_long port, max_conn, nbytes, workers;
+  bool max_conn_null, nbytes_null;
+  size_t nconn, fnbytes, buff_count, buff_size;
+  HashTable *options;
+  php_sockaddr_storage_t addr;
+  socklen_t addrlen;
+  int fd;
 
+  obj = getThis();
   fci = empty_fcall_info;
   fci_cache = empty_fcall_info_cache;
-  obj = getThis();
+  max_conn_null = true;
+  nbytes_null = true;
+  options = NULL;
 
-  ZEND_PARSE_PARAMETERS_START(1, 1)
+  ZEND_PARSE_PARAMETERS_START(4, 5)
+  Z_PARAM_STR_OR_LONG(address, port)
+  Z_PARAM_LONG_OR_NULL(max_conn, max_conn_null)
+  Z_PARAM_LONG_OR_NULL(nbytes, nbytes_null)
   Z_PARAM_FUNC(fci, fci_cache)
+  Z_PARAM_OPTIONAL
+  Z_PARAM_ARRAY_HT_OR_NULL(options)
   ZEND_PARSE_PARAMETERS_END();
 
   this = PHP_MRLOOP_OBJ(obj);
-  cb = emalloc(sizeof(php_mrloop_cb_t));
-  PHP_CB_TO_MRLOOP_CB(cb, fci, fci_cache);
 
-  cb->signal = PHP_MRLOOP_FUTURE_TICK;
-  cb->data = this->loop;
+  if (php_mrloop_tcp_server_address(address, port, &addr, &addrlen) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("Invalid server address");
+    return;
+  }
 
-  mr_call_soon(this->loop, php_mrloop_timer_cb, cb);
+  fnbytes = (size_t)(nbytes_null == true ? DEFAULT_CONN_BUFF_LEN : nbytes);
+  nconn = (size_t)(max_conn_null == true ? PHP_MRLOOP_MAX_TCP_CONNECTIONS : (max_conn == 0 ? PHP_MRLOOP_MAX_TCP_CONNECTIONS : max_conn));
+  workers = php_mrloop_option_long(options, "workers", 0);
+  buff_count = 0;
+  buff_size = fnbytes;
 
-  return;
-}
+  if (php_mrloop_option_bool(options, "buffer_ring", false))
+  {
+    buff_count = (size_t)php_mrloop_option_long(options, "buffer_count", PHP_MRLOOP_BUFFER_RING_COUNT);
+    buff_size = (size_t)php_mrloop_option_long(options, "buffer_size", (zend_long)fnbytes);
 
-static void php_mrloop_readv_cb(void *data, int res)
-{
-  if (res < 0)
+    if (buff_count < 1 || buff_count > PHP_MRLOOP_BUFFER_RING_MAX_COUNT || buff_size < 1)
+    {
+      PHP_MRLOOP_THROW("Invalid provided buffer ring dimensions");
+      return;
+    }
+
+    // provided buffer rings must have a power-of-two number of entries
+    size_t entries = 1;
+    while (entries < buff_count)
+    {
+      entries <<= 1;
+    }
+    buff_count = entries;
+  }
+
+  if (workers < 0)
   {
-    PHP_MRLOOP_THROW(strerror(-res));
+    PHP_MRLOOP_THROW("Invalid number of workers");
+    return;
   }
 
-  php_mrloop_cb_t *cb;
-  php_iovec_t *iov;
-  zval args[2], result;
+  // a worker which forked workers of its own would supervise them in place of serving; the processes would multiply
+  if (workers > 0 && MRLOOP_G(worker))
+  {
+    PHP_MRLOOP_THROW("Workers cannot fork workers of their own");
+    return;
+  }
 
-  cb = (php_mrloop_cb_t *)data;
-  iov = (php_iovec_t *)cb->data;
+  fd = -1;
 
-  char next[(size_t)iov->iov_len];
-  php_strncpy(next, iov->iov_base, iov->iov_len + 1);
+  if (workers > 0)
+  {
+    // surface binding errors in the parent rather than in a respawn loop
+    if ((fd = php_mrloop_tcp_server_bind(&addr, addrlen, true)) < 0)
+    {
+      return;
+    }
 
-  ZVAL_STRING(&args[0], next);
-  ZVAL_LONG(&args[1], res);
+    // Unix domain sockets cannot be bound more than once; workers share the parent's listener instead
+    if (addr.ss_family != AF_UNIX)
+    {
+      close(fd);
+      fd = -1;
+    }
 
-  cb->fci.retval = &result;
-  cb->fci.param_count = 2;
-  cb->fci.params = args;
+    if (!php_mrloop_tcp_server_supervise(this, (size_t)workers))
+    {
+      if (fd > -1)
+      {
+        close(fd);
+        unlink(((php_sockaddr_un_t *)&addr)->sun_path);
+      }
 
-  if (zend_call_function(&cb->fci, &cb->fci_cache) == FAILURE)
-  {
-    PHP_MRLOOP_THROW("There is an error in your callback");
-  }
+      if (!EG(exception))
+      {
+        EG(exit_status) = 0;
+        zend_throw_unwind_exit();
+      }
 
-  zval_ptr_dtor(&result);
-  efree(cb->data);
-  efree(cb);
+      return;
+    }
+  }
 
-  return;
-}
-static void php_mrloop_writev_cb(void *data, int res)
-{
-  if (res < 0)
+  if (fd < 0 && (fd = php_mrloop_tcp_server_bind(&addr, addrlen, workers > 0)) < 0)
   {
-    PHP_MRLOOP_THROW(strerror(-res));
+    return;
   }
 
-  php_mrloop_cb_t *cb = (php_mrloop_cb_t *)data;
-  zval args[1], result;
-  ZVAL_LONG(&args[0], res);
+  if ((server = php_mrloop_tcp_server_init(this, fd, nconn, buff_count, buff_size)) == NULL)
+  {
+    return;
+  }
 
-  cb->fci.retval = &result;
-  cb->fci.param_count = 1;
-  cb->fci.params = args;
+  server->protocol = protocol;
+  server->cb = emalloc(sizeof(php_mrloop_cb_t));
+  if (addr.ss_family == AF_UNIX && workers == 0)
+  {
+    server->path = estrdup(((php_sockaddr_un_t *)&addr)->sun_path);
+  }
+  PHP_CB_TO_MRLOOP_CB(server->cb, fci, fci_cache);
+  server->cb->data = server;
 
-  if (zend_call_function(&cb->fci, &cb->fci_cache) == FAILURE)
+  if (protocol == PHP_MRLOOP_PROTOCOL_HTTP)
   {
-    PHP_MRLOOP_THROW("There is an error in your callback");
+    server->max_request = (size_t)php_mrloop_option_long(options, "max_request_size", PHP_MRLOOP_HTTP_MAX_REQUEST);
   }
 
-  zval_ptr_dtor(&result);
-  efree(cb->data);
-  efree(cb);
+  php_mrloop_tcp_server_accept(server);
 
   return;
 }
-
-static void *php_mrloop_tcp_client_setup(int fd, char **buffer, int *bsize)
+static void php_mrloop_tcp_server_listen(INTERNAL_FUNCTION_PARAMETERS)
 {
-  php_mrloop_conn_t *conn;
-  php_sockaddr_t addr;
-  socklen_t socklen;
-  char ip_str[INET_ADDRSTRLEN];
+  php_mrloop_server_listen(INTERNAL_FUNCTION_PARAM_PASSTHRU, PHP_MRLOOP_PROTOCOL_RAW);
+}
 
-  conn = emalloc(sizeof(php_mrloop_conn_t));
-  conn->fd = fd;
-  conn->buffer = ecalloc(1, MRLOOP_G(tcp_buff_size));
-  *buffer = conn->buffer;
-  *bsize = MRLOOP_G(tcp_buff_size);
+static bool php_mrloop_signal_arm(php_mrloop_t *evloop)
+{
+  struct io_uring_sqe *sqe;
 
-  socklen = sizeof(php_sockaddr_t);
+  if (evloop->sig_armed || evloop->sig_fd < 0)
+  {
+    return true;
+  }
 
-  if (getpeername(fd, (struct sockaddr *)&addr, &socklen) > -1)
+  if ((sqe = php_mrloop_uring_sqe(evloop, &evloop->sig_op)) == NULL)
   {
-    inet_ntop(AF_INET, &addr.sin_addr, ip_str, INET_ADDRSTRLEN);
+    return false;
+  }
 
-    conn->addr = ecalloc(1, INET_ADDRSTRLEN);
-    php_strncpy(conn->addr, ip_str, INET_ADDRSTRLEN);
+  // the signalfd is blocking, so the ring polls it rather than failing the read with EAGAIN
+  io_uring_prep_read(sqe, evloop->sig_fd, &evloop->sig_info, sizeof(struct signalfd_siginfo), 0);
+  evloop->sig_armed = true;
 
-    conn->port = (size_t)addr.sin_port;
-  }
+  php_mrloop_uring_submit(evloop);
 
-  return (void *)conn;
+  return true;
 }
-static int php_mrloop_tcp_server_recv(void *conn, int fd, ssize_t nbytes, char *buffer)
+static void php_mrloop_signal_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
 {
-  php_mrloop_conn_t *client = (php_mrloop_conn_t *)conn;
-  mr_loop_t *loop = (mr_loop_t *)MRLOOP_G(tcp_cb)->data;
+  php_mrloop_t *evloop = (php_mrloop_t *)op->data;
+  php_mrloop_cb_t *cb;
+  zval args[1], result;
+  int sig;
 
-  if (nbytes == 0)
-  {
-    mr_close(loop, client->fd);
-    efree(client->addr);
-    efree(client->buffer);
-    efree(client);
+  evloop->sig_armed = false;
 
-    return 1;
+  if (cqe->res < 0 && cqe->res != -EINTR && cqe->res != -EAGAIN)
+  {
+    PHP_MRLOOP_THROW(strerror(-cqe->res));
+    return;
   }
 
-  zval args[2], result;
-  ZVAL_STRING(&args[0], buffer);
+  if (cqe->res == sizeof(struct signalfd_siginfo))
+  {
+    sig = (int)evloop->sig_info.ssi_signo;
+    ZVAL_LONG(&args[0], sig);
 
-  array_init(&args[1]);
-  add_assoc_string(&args[1], "client_addr", (char *)client->addr);
-  add_assoc_long(&args[1], "client_port", client->port);
-  add_assoc_long(&args[1], "client_fd", dup(client->fd));
+    // the callbacks registered for the signal run like any other completion; the loop runs on unless one stops it
+    for (size_t idx = 0; idx < evloop->sigc; idx++)
+    {
+      cb = evloop->sig_cb[idx];
 
-  MRLOOP_G(tcp_cb)->fci.retval = &result;
-  MRLOOP_G(tcp_cb)->fci.param_count = 2;
-  MRLOOP_G(tcp_cb)->fci.params = args;
+      if (cb->signal != sig)
+      {
+        continue;
+      }
 
-  if (zend_call_function(&MRLOOP_G(tcp_cb)->fci, &MRLOOP_G(tcp_cb)->fci_cache) == FAILURE)
-  {
-    PHP_MRLOOP_THROW("There is an error in your callback");
-    zval_ptr_dtor(&result);
+      cb->fci.retval = &result;
+      cb->fci.param_count = 1;
+      cb->fci.params = args;
 
-    return 1;
-  }
+      if (php_mrloop_call(evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+      {
+        PHP_MRLOOP_THROW("There is an error in your callback");
+        break;
+      }
 
-  if (Z_TYPE(result) == IS_STRING)
-  {
-    client->iov.iov_base = Z_STRVAL(result);
-    client->iov.iov_len = Z_STRLEN(result);
+      zval_ptr_dtor(&result);
 
-    mr_writev(loop, client->fd, &(client->iov), 1);
-    mr_flush(loop);
+      if (EG(exception))
+      {
+        break;
+      }
+    }
   }
 
-  zval_ptr_dtor(&result);
-
-  return 1;
+  php_mrloop_signal_arm(evloop);
 }
-static void php_mrloop_tcp_server_listen(INTERNAL_FUNCTION_PARAMETERS)
+static void php_mrloop_add_signal(INTERNAL_FUNCTION_PARAMETERS)
 {
   zval *obj;
   php_mrloop_t *this;
+  php_mrloop_cb_t *cb;
+  zend_long php_signal;
   zend_fcall_info fci;
   zend_fcall_info_cache fci_cache;
-  zend_long port, max_conn, nbytes;
-  bool max_conn_null, nbytes_null;
-  size_t nconn, fnbytes;
+  sigset_t set, prev;
+  int fd, sig;
 
   obj = getThis();
   fci = empty_fcall_info;
   fci_cache = empty_fcall_info_cache;
-  max_conn_null = true;
-  nbytes_null = true;
 
-  ZEND_PARSE_PARAMETERS_START(4, 4)
-  Z_PARAM_LONG(port)
-  Z_PARAM_LONG_OR_NULL(max_conn, max_conn_null)
-  Z_PARAM_LONG_OR_NULL(nbytes, nbytes_null)
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_LONG(php_signal)
   Z_PARAM_FUNC(fci, fci_cache)
   ZEND_PARSE_PARAMETERS_END();
 
   this = PHP_MRLOOP_OBJ(obj);
 
-  fnbytes = (size_t)(nbytes_null == true ? DEFAULT_CONN_BUFF_LEN : nbytes);
-  MRLOOP_G(tcp_buff_size) = fnbytes;
+  // SIGKILL and SIGSTOP can be neither caught nor blocked
+  if (php_signal < 1 || php_signal > SIGRTMAX || php_signal == SIGKILL || php_signal == SIGSTOP)
+  {
+    PHP_MRLOOP_THROW("Invalid signal");
+    return;
+  }
 
-  MRLOOP_G(tcp_cb) = emalloc(sizeof(php_mrloop_cb_t));
-  PHP_CB_TO_MRLOOP_CB(MRLOOP_G(tcp_cb), fci, fci_cache);
-  MRLOOP_G(tcp_cb)->data = this->loop;
+  sig = (int)php_signal;
 
-  nconn = (size_t)(max_conn_null == true ? PHP_MRLOOP_MAX_TCP_CONNECTIONS : (max_conn == 0 ? PHP_MRLOOP_MAX_TCP_CONNECTIONS : max_conn));
+  if (php_mrloop_uring(this) == NULL)
+  {
+    return;
+  }
 
-#ifdef MRLOOP_H
-  mr_tcp_server(this->loop, (int)port, nconn, php_mrloop_tcp_client_setup, php_mrloop_tcp_server_recv);
-#else
-  mr_tcp_server(this->loop, (int)port, php_mrloop_tcp_client_setup, php_mrloop_tcp_server_recv);
-#endif
+  if (!sigismember(&this->sig_mask, sig))
+  {
+    // the signal is blocked so that it is queued for the signalfd rather than delivered to a handler
+    sigemptyset(&set);
+    sigaddset(&set, sig);
+    sigprocmask(SIG_BLOCK, &set, &prev);
 
-  return;
-}
+    sigaddset(&this->sig_mask, sig);
+    if ((fd = signalfd(this->sig_fd, &this->sig_mask, SFD_CLOEXEC)) < 0)
+    {
+      sigdelset(&this->sig_mask, sig);
+      if (!sigismember(&prev, sig))
+      {
+        sigprocmask(SIG_UNBLOCK, &set, NULL);
+      }
 
-static void php_mrloop_signal_cb(int sig)
-{
-  for (size_t idx = 0; idx < MRLOOP_G(sigc); idx++)
-  {
-    if (MRLOOP_G(sig_cb)[idx] == NULL)
+      PHP_MRLOOP_THROW(strerror(errno));
+      return;
+    }
+
+    this->sig_fd = fd;
+    if (!sigismember(&prev, sig))
     {
-      break;
+      sigaddset(&this->sig_blocked, sig);
     }
+  }
 
-    php_mrloop_cb_t *cb = MRLOOP_G(sig_cb)[idx];
+  if (!php_mrloop_signal_arm(this))
+  {
+    PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+    return;
+  }
 
-    if (cb->signal == sig)
-    {
-      zval result;
+  // the loop is enlisted upon registration of its first signal callback
+  if (this->sigc == 0)
+  {
+    this->sig_next = MRLOOP_G(sig_loops);
+    MRLOOP_G(sig_loops) = this;
+  }
 
-      cb->fci.retval = &result;
-      cb->fci.param_count = 0;
-      cb->fci.params = NULL;
+  cb = emalloc(sizeof(php_mrloop_cb_t));
+  PHP_CB_TO_MRLOOP_CB(cb, fci, fci_cache);
+  cb->signal = sig;
+  cb->data = this;
 
-      if (zend_call_function(&cb->fci, &cb->fci_cache) == FAILURE)
-      {
-        PHP_MRLOOP_THROW("There is an error in your callback");
-      }
+  this->sig_cb = erealloc(this->sig_cb, (this->sigc + 1) * sizeof(php_mrloop_cb_t *));
+  this->sig_cb[this->sigc++] = cb;
 
-      zval_ptr_dtor(&result);
+  return;
+}
+static void php_mrloop_signal_free(php_mrloop_t *evloop)
+{
+  php_mrloop_t **next, *other;
+  sigset_t unblock;
+
+  if (evloop->sigc == 0)
+  {
+    return;
+  }
 
+  for (next = &MRLOOP_G(sig_loops); *next != NULL; next = &(*next)->sig_next)
+  {
+    if (*next == evloop)
+    {
+      *next = evloop->sig_next;
       break;
     }
   }
 
-  exit(EXIT_SUCCESS);
-}
-static void php_mrloop_add_signal(INTERNAL_FUNCTION_PARAMETERS)
-{
-  zend_long php_signal;
-  zend_fcall_info fci;
-  zend_fcall_info_cache fci_cache;
+  // signals blocked on behalf of the loop are unblocked unless another loop still reads them
+  sigemptyset(&unblock);
+  for (int sig = 1; sig <= SIGRTMAX; sig++)
+  {
+    if (!sigismember(&evloop->sig_blocked, sig))
+    {
+      continue;
+    }
 
-  ZEND_PARSE_PARAMETERS_START(2, 2)
-  Z_PARAM_LONG(php_signal)
-  Z_PARAM_FUNC(fci, fci_cache)
-  ZEND_PARSE_PARAMETERS_END();
+    for (other = MRLOOP_G(sig_loops); other != NULL && !sigismember(&other->sig_mask, sig); other = other->sig_next)
+      ;
 
-  MRLOOP_G(sigc)++;
-  size_t next = MRLOOP_G(sigc) - 1;
+    if (other)
+    {
+      sigaddset(&other->sig_blocked, sig);
+    }
+    else
+    {
+      sigaddset(&unblock, sig);
+    }
+  }
+  sigprocmask(SIG_UNBLOCK, &unblock, NULL);
 
-  MRLOOP_G(sig_cb)[next] = emalloc(sizeof(php_mrloop_cb_t));
-  PHP_CB_TO_MRLOOP_CB(MRLOOP_G(sig_cb)[next], fci, fci_cache);
-  MRLOOP_G(sig_cb)[next]->signal = (int)php_signal;
+  if (evloop->sig_fd > -1)
+  {
+    close(evloop->sig_fd);
+  }
 
-  signal(SIGINT, php_mrloop_signal_cb);
-  signal(SIGHUP, php_mrloop_signal_cb);
-  signal(SIGTERM, php_mrloop_signal_cb);
+  for (size_t idx = 0; idx < evloop->sigc; idx++)
+  {
+    PHP_MRLOOP_CB_FREE(evloop->sig_cb[idx]);
+  }
+  efree(evloop->sig_cb);
 
-  return;
+  evloop->sig_cb = NULL;
+  evloop->sigc = 0;
+  evloop->sig_fd = -1;
+  sigemptyset(&evloop->sig_mask);
+  sigemptyset(&evloop->sig_blocked);
 }
 
 static void php_mrloop_add_read_stream(INTERNAL_FUNCTION_PARAMETERS)
 {
-  zval *res, *obj;
+  zval *res, *obj, *nbytes;
   php_mrloop_t *this;
   php_mrloop_cb_t *cb;
-  php_iovec_t *iov;
+  php_mrloop_read_t *request;
   zend_fcall_info fci;
   zend_fcall_info_cache fci_cache;
-  zend_long nbytes, vcount, offset;
-  bool nbytes_null, vcount_null, offset_null;
+  zend_long vcount, offset;
+  bool vcount_null, offset_null;
   int fd; // php_socket_t fd;
   php_stream *stream;
-  size_t fnbytes, fvcount, foffset;
+  size_t fvcount, foffset;
 
   obj = getThis();
-  nbytes_null = true;
   vcount_null = true;
   offset_null = true;
   fci = empty_fcall_info;
@@ -451,7 +2158,7 @@ static void php_mrloop_add_read_stream(INTERNAL_FUNCTION_PARAMETERS)
 
   ZEND_PARSE_PARAMETERS_START(5, 5)
   Z_PARAM_RESOURCE(res)
-  Z_PARAM_LONG_OR_NULL(nbytes, nbytes_null)
+  Z_PARAM_ZVAL(nbytes)
   Z_PARAM_LONG_OR_NULL(vcount, vcount_null)
   Z_PARAM_LONG_OR_NULL(offset, offset_null)
   Z_PARAM_FUNC(fci, fci_cache)
@@ -462,21 +2169,29 @@ static void php_mrloop_add_read_stream(INTERNAL_FUNCTION_PARAMETERS)
   // convert resource to PHP stream
   PHP_STREAM_TO_FD(stream, res, fd);
 
-  fnbytes = (size_t)(nbytes_null == true ? DEFAULT_STREAM_BUFF_LEN : nbytes);
+  if (Z_TYPE_P(nbytes) != IS_NULL && Z_TYPE_P(nbytes) != IS_LONG && Z_TYPE_P(nbytes) != IS_ARRAY)
+  {
+    zend_argument_type_error(2, "must be of type array|int|null, %s given", zend_zval_type_name(nbytes));
+    return;
+  }
+
   fvcount = (size_t)(vcount_null == true ? DEFAULT_VECTOR_COUNT : vcount);
   foffset = (size_t)(offset_null == true ? DEFAULT_READV_OFFSET : offset);
 
-  iov = emalloc(sizeof(php_iovec_t));
-  iov->iov_base = ecalloc(1, fnbytes);
-  iov->iov_len = fnbytes;
-
-  cb = emalloc(sizeof(php_mrloop_cb_t));
-  PHP_CB_TO_MRLOOP_CB(cb, fci, fci_cache);
+  if ((request = php_mrloop_read_init(this, nbytes, fvcount)) == NULL)
+  {
+    return;
+  }
 
-  cb->data = iov;
+  cb = php_mrloop_cb_alloc(this, &fci, &fci_cache);
+  cb->data = request;
 
-  mr_readvcb(this->loop, fd, iov, fvcount, foffset, cb, php_mrloop_readv_cb);
-  mr_flush(this->loop);
+  // registered files are read via the extension-managed ring with fixed-file opcodes
+  if (!php_mrloop_uring_readv(this, fd, request->iov, request->iovcnt, (int64_t)foffset, cb, php_mrloop_readv_cb))
+  {
+    mr_readvcb(this->loop, fd, request->iov, (int)request->iovcnt, foffset, cb, php_mrloop_readv_cb);
+    php_mrloop_mr_submit(this);
+  }
 
   return;
 }
@@ -484,16 +2199,17 @@ static void php_mrloop_add_write_stream(INTERNAL_FUNCTION_PARAMETERS)
 {
   zval *res, *obj;
   zend_string *contents;
+  HashTable *chunks;
   php_mrloop_t *this;
   php_mrloop_cb_t *cb;
-  php_iovec_t *iov;
+  php_mrloop_write_t *request;
   zend_fcall_info fci;
   zend_fcall_info_cache fci_cache;
   zend_long vcount;
   bool vcount_null;
   int fd;
   php_stream *stream;
-  size_t nbytes, fvcount;
+  size_t fvcount;
 
   obj = getThis();
   fci = empty_fcall_info;
@@ -503,7 +2219,7 @@ static void php_mrloop_add_write_stream(INTERNAL_FUNCTION_PARAMETERS)
 
   ZEND_PARSE_PARAMETERS_START(4, 4)
   Z_PARAM_RESOURCE(res)
-  Z_PARAM_STR(contents)
+  Z_PARAM_ARRAY_HT_OR_STR(chunks, contents)
   Z_PARAM_LONG_OR_NULL(vcount, vcount_null)
   Z_PARAM_FUNC(fci, fci_cache)
   ZEND_PARSE_PARAMETERS_END();
@@ -512,32 +2228,32 @@ static void php_mrloop_add_write_stream(INTERNAL_FUNCTION_PARAMETERS)
 
   PHP_STREAM_TO_FD(stream, res, fd);
 
-  nbytes = ZSTR_LEN(contents);
-  iov = emalloc(sizeof(php_iovec_t));
-  iov->iov_base = ecalloc(1, nbytes);
-  iov->iov_len = nbytes;
-
-  php_strncpy(iov->iov_base, ZSTR_VAL(contents), nbytes + 1);
-
-  cb = emalloc(sizeof(php_mrloop_cb_t));
-  PHP_CB_TO_MRLOOP_CB(cb, fci, fci_cache);
+  fvcount = (size_t)(vcount_null == true ? DEFAULT_VECTOR_COUNT : vcount);
 
-  cb->data = iov;
+  // the strings are written in place; they are pinned until the write completes
+  if ((request = php_mrloop_write_init(this, chunks, contents, fvcount)) == NULL)
+  {
+    return;
+  }
 
-  fvcount = (size_t)(vcount_null == true ? DEFAULT_VECTOR_COUNT : vcount);
+  cb = php_mrloop_cb_alloc(this, &fci, &fci_cache);
+  cb->data = request;
 
-  mr_writevcb(this->loop, fd, iov, fvcount, cb, php_mrloop_writev_cb);
-  mr_flush(this->loop);
+  if (!php_mrloop_uring_writev(this, fd, request->iov, request->iovcnt, cb, php_mrloop_writev_cb))
+  {
+    mr_writevcb(this->loop, fd, request->iov, (int)request->iovcnt, cb, php_mrloop_writev_cb);
+    php_mrloop_mr_submit(this);
+  }
 
   return;
 }
 static void php_mrloop_writev(INTERNAL_FUNCTION_PARAMETERS)
 {
   zend_string *contents;
-  php_iovec_t iov;
+  HashTable *chunks;
   php_mrloop_t *this;
+  php_mrloop_write_t *request;
   zval *obj, *res;
-  size_t nbytes;
   php_stream *stream;
   int fd;
 
@@ -546,7 +2262,7 @@ static void php_mrloop_writev(INTERNAL_FUNCTION_PARAMETERS)
 
   ZEND_PARSE_PARAMETERS_START(2, 2)
   Z_PARAM_ZVAL(res)
-  Z_PARAM_STR(contents)
+  Z_PARAM_ARRAY_HT_OR_STR(chunks, contents)
   ZEND_PARSE_PARAMETERS_END();
 
   this = PHP_MRLOOP_OBJ(obj);
@@ -573,37 +2289,50 @@ static void php_mrloop_writev(INTERNAL_FUNCTION_PARAMETERS)
     RETURN_NULL();
   }
 
-  nbytes = ZSTR_LEN(contents);
-  iov.iov_base = ZSTR_VAL(contents);
-  iov.iov_len = nbytes;
+  if ((request = php_mrloop_write_init(this, chunks, contents, 1)) == NULL)
+  {
+    return;
+  }
 
-  mr_writev(this->loop, fd, &iov, 1);
-  mr_flush(this->loop);
+  // the strings must outlive the write; they are released once it completes
+  if (!php_mrloop_uring_writev(this, fd, request->iov, request->iovcnt, request, php_mrloop_writev_release_cb))
+  {
+    mr_writevcb(this->loop, fd, request->iov, (int)request->iovcnt, request, php_mrloop_writev_release_cb);
+    php_mrloop_mr_submit(this);
+  }
 }
 
-static size_t php_strncpy(char *dst, char *src, size_t nbytes)
+static zend_long php_mrloop_option_long(HashTable *options, const char *key, zend_long fallback)
 {
-  const char *osrc = src;
-  size_t nleft = nbytes;
+  zval *value;
 
-  // copy as many bytes as will fit
-  if (nleft != 0)
+  if (options == NULL || (value = zend_hash_str_find(options, key, strlen(key))) == NULL || Z_TYPE_P(value) != IS_LONG)
   {
-    while (--nleft != 0)
-    {
-      if ((*dst++ = *src++) == '\0')
-        break;
-    }
+    return fallback;
+  }
+
+  return Z_LVAL_P(value);
+}
+static bool php_mrloop_option_bool(HashTable *options, const char *key, bool fallback)
+{
+  zval *value;
+
+  if (options == NULL || (value = zend_hash_str_find(options, key, strlen(key))) == NULL)
+  {
+    return fallback;
   }
 
-  // not enough room in dst, add null byte and traverse rest of src
-  if (nleft == 0)
+  return zend_is_true(value);
+}
+static double php_mrloop_option_double(HashTable *options, const char *key, double fallback)
+{
+  zval *value;
+
+  if (options == NULL || (value = zend_hash_str_find(options, key, strlen(key))) == NULL ||
+      (Z_TYPE_P(value) != IS_LONG && Z_TYPE_P(value) != IS_DOUBLE))
   {
-    if (nbytes != 0)
-      *dst = '\0';
-    while (*src++)
-      ;
+    return fallback;
   }
 
-  return (src - osrc - 1);
+  return zval_get_double(value);
 }
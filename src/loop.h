@@ -11,9 +11,18 @@
 #include "php.h"
 #include "php_network.h"
 #include "php_streams.h"
+#include "pthread.h"
 #include "signal.h"
 #include "sys/file.h"
+#include "sys/signalfd.h"
+#include "sys/sysmacros.h"
+#include "sys/un.h"
+#include "sys/wait.h"
+#include "time.h"
 #include "zend_exceptions.h"
+#include "zend_fibers.h"
+#include "zend_interfaces.h"
+#include "zend_smart_str.h"
 
 /* for compatibility with older PHP versions */
 #ifndef ZEND_PARSE_PARAMETERS_NONE
@@ -27,46 +36,282 @@
 #define DEFAULT_HTTP_HEADER_LIMIT 100
 #define DEFAULT_VECTOR_COUNT 1
 #define DEFAULT_READV_OFFSET 0
-#define PHP_MRLOOP_TIMER 1
-#define PHP_MRLOOP_PERIODIC_TIMER 2
-#define PHP_MRLOOP_FUTURE_TICK 3
 #define PHP_MRLOOP_MAX_TCP_CONNECTIONS 1024
+#define PHP_MRLOOP_BUFFER_RING_COUNT 256
+#define PHP_MRLOOP_BUFFER_RING_MAX_COUNT 32768
+#define PHP_MRLOOP_WORKER_RESPAWN_DELAY 1
+#define PHP_MRLOOP_WRITE_QUEUE_SIZE 8
+#define PHP_MRLOOP_WRITE_MAX_IOV 1024
+#define PHP_MRLOOP_READ_MAX_IOV 1024
+#define PHP_MRLOOP_PROTOCOL_RAW 0
+#define PHP_MRLOOP_PROTOCOL_HTTP 1
+#define PHP_MRLOOP_TICK_QUEUE_SIZE 64
+#define PHP_MRLOOP_TICK_BUDGET 4096
 
 struct php_mrloop_t;
 struct php_mrloop_cb_t;
 struct php_mrloop_conn_t;
+struct php_mrloop_connect_t;
+struct php_mrloop_server_t;
+struct php_mrloop_udp_t;
+struct php_mrloop_read_t;
+struct php_mrloop_write_t;
+struct php_mrloop_wheel_t;
+struct php_mrloop_timer_t;
+struct php_mrloop_slab_t;
+struct php_mrloop_tick_t;
+struct php_mrloop_histogram_t;
+struct php_mrloop_stats_t;
 typedef struct php_mrloop_t php_mrloop_t;
 typedef struct php_mrloop_cb_t php_mrloop_cb_t;
 typedef struct php_mrloop_conn_t php_mrloop_conn_t;
+typedef struct php_mrloop_connect_t php_mrloop_connect_t;
+typedef struct php_mrloop_server_t php_mrloop_server_t;
+typedef struct php_mrloop_udp_t php_mrloop_udp_t;
+typedef struct php_mrloop_read_t php_mrloop_read_t;
+typedef struct php_mrloop_write_t php_mrloop_write_t;
+typedef struct php_mrloop_wheel_t php_mrloop_wheel_t;
+typedef struct php_mrloop_timer_t php_mrloop_timer_t;
+typedef struct php_mrloop_slab_t php_mrloop_slab_t;
+typedef struct php_mrloop_tick_t php_mrloop_tick_t;
+typedef struct php_mrloop_histogram_t php_mrloop_histogram_t;
+typedef struct php_mrloop_stats_t php_mrloop_stats_t;
 
 typedef struct iovec php_iovec_t;
 typedef struct addrinfo php_addrinfo_t;
 typedef struct sockaddr_in php_sockaddr_t;
+typedef struct sockaddr_in6 php_sockaddr_in6_t;
+typedef struct sockaddr_un php_sockaddr_un_t;
+typedef struct sockaddr_storage php_sockaddr_storage_t;
 typedef struct phr_header phr_header_t;
 typedef struct stat php_stat_t;
 
+#include "uring.h"
+#include "slab.h"
+#include "stats.h"
+
 /* userspace-bound event loop object */
 struct php_mrloop_t
 {
   /* event loop instance */
   mr_loop_t *loop;
+  /* extension-managed io_uring instance */
+  php_mrloop_uring_t *uring;
+  /* setup with which the extension-managed ring is created */
+  php_mrloop_uring_setup_t uring_setup;
+  /* TCP servers whose sockets are serviced via the extension-managed ring */
+  php_mrloop_server_t *servers;
+  /* UDP servers whose sockets are serviced via the extension-managed ring */
+  php_mrloop_udp_t *udp_servers;
+  /* idle outbound connections keyed by host and port */
+  HashTable *pool;
+  /* timing wheel through which timers are serviced */
+  php_mrloop_wheel_t *wheel;
+  /* timers created in the event loop (active or otherwise) */
+  php_mrloop_timer_t *timers;
+  /* connections to which the event loop holds a reference (those yet to be released) */
+  php_mrloop_conn_t *conns;
+  /* outbound connection attempts awaiting the resolution of a host name */
+  php_mrloop_connect_t *lookups;
+  /* depth of nested batches (submission is deferred until the outermost one ends) */
+  size_t batch;
+  /* whether operations queued in the mrloop ring await submission */
+  bool mr_pending;
+  /* slabs (indexed by size class) whence short-lived records are carved */
+  php_mrloop_slab_t slabs[PHP_MRLOOP_SLAB_CLASSES];
+  /* future ticks awaiting execution (a ring buffer whose capacity is a power of two) */
+  php_mrloop_tick_t *ticks;
+  /* index of the oldest queued future tick */
+  size_t tick_head;
+  /* number of queued future ticks */
+  size_t nticks;
+  /* capacity of the future tick ring buffer */
+  size_t tick_cap;
+  /* maximum number of future ticks run per drain (those in excess wait for pending completions) */
+  size_t tick_budget;
+  /* whether a wake-up through which queued future ticks are drained is scheduled */
+  bool tick_armed;
+  /* whether the event loop is running */
+  bool running;
+  /* signal callbacks (in order of registration) */
+  php_mrloop_cb_t **sig_cb;
+  /* signal callback count */
+  size_t sigc;
+  /* next event loop with signal callbacks */
+  php_mrloop_t *sig_next;
+  /* signalfd through which handled signals are read (-1 if no signal is handled) */
+  int sig_fd;
+  /* signals routed to the signalfd */
+  sigset_t sig_mask;
+  /* handled signals blocked on behalf of the event loop (rather than blocked beforehand) */
+  sigset_t sig_blocked;
+  /* signalfd read operation */
+  php_mrloop_op_t sig_op;
+  /* whether the signalfd read operation is in flight */
+  bool sig_armed;
+  /* information about the signal last read from the signalfd */
+  struct signalfd_siginfo sig_info;
+  /* counters and histograms reported by Mrloop::stats() */
+  php_mrloop_stats_t stats;
   /* PHP object */
   zend_object std;
 };
 
-/* TCP client connection object */
+/* userspace-bound TCP client connection object */
 struct php_mrloop_conn_t
 {
   /* client socket file descriptor */
   int fd;
-  /* client socket address */
+  /* client socket address (IP address or, for Unix domain sockets, path) */
   char *addr;
-  /* data sent over client socket */
+  /* data sent over client socket (absent in provided buffer ring mode) */
   char *buffer;
   /* client socket port */
   size_t port;
-  /* scatter-gather I/O primitives */
-  php_iovec_t iov;
+  /* event loop in which the connection is subsumed */
+  php_mrloop_t *evloop;
+  /* server to which the client is connected (absent for outbound connections) */
+  php_mrloop_server_t *server;
+  /* size of the receive buffer */
+  size_t buff_size;
+  /* callback awaiting the next chunk of data (outbound connections only) */
+  php_mrloop_cb_t *read_cb;
+  /* connection pool key (outbound connections only) */
+  zend_string *pool_key;
+  /* whether the connection idles in the connection pool */
+  bool pooled;
+  /* next idle connection sharing the pool key */
+  php_mrloop_conn_t *pool_next;
+  /* receive operation */
+  php_mrloop_op_t recv_op;
+  /* whether the receive operation is in flight */
+  bool recv_armed;
+  /* strings queued for delivery to the client (those being written included) */
+  zend_string **queue;
+  /* number of queued strings */
+  size_t nqueue;
+  /* capacity of the queue */
+  size_t queue_cap;
+  /* number of bytes of the string at the head of the queue already written */
+  size_t queue_offset;
+  /* scatter-gather vectors referencing queued strings */
+  php_iovec_t *iov;
+  /* message header through which queued strings are written */
+  struct msghdr msg;
+  /* write operation */
+  php_mrloop_op_t write_op;
+  /* whether the write operation is in flight */
+  bool write_armed;
+  /* whether data received from the client is being processed (writes are flushed thereafter) */
+  bool dispatching;
+  /* whether the connection is due for closure */
+  bool closing;
+  /* next connection to which the same event loop holds a reference */
+  php_mrloop_conn_t *sibling;
+  /* link that references the connection in the list of the event loop (NULL once released) */
+  php_mrloop_conn_t **psibling;
+  /* partially received request data (HTTP mode only) */
+  char *pending;
+  /* length of partially received request data */
+  size_t npending;
+  /* capacity of partially received request data buffer */
+  size_t pending_cap;
+  /* PHP object */
+  zend_object std;
+};
+
+/* future tick queued for execution */
+struct php_mrloop_tick_t
+{
+  /* PHP callback interface */
+  zend_fcall_info fci;
+  /* PHP callback cache */
+  zend_fcall_info_cache fci_cache;
+  /* arguments conveyed to the callback (carved from a slab) */
+  zval *args;
+  /* number of arguments */
+  uint32_t argc;
+};
+
+/* stream read whose data lands directly in the strings conveyed to userspace */
+struct php_mrloop_read_t
+{
+  /* read vectors (referencing the contents of the strings) */
+  php_iovec_t *iov;
+  /* number of read vectors */
+  size_t iovcnt;
+  /* number of read vectors for which space was allocated */
+  size_t iovcap;
+  /* strings into which data is read */
+  zend_string **buffers;
+  /* number of strings */
+  size_t nbuffers;
+  /* whether a list of buffer sizes was specified (the strings are conveyed as an array) */
+  bool list;
+  /* event loop in which the read is subsumed */
+  php_mrloop_t *evloop;
+#ifdef HAVE_MRLOOP_STATS
+  /* time at which the read was issued */
+  uint64_t stamp;
+#endif
+};
+
+/* stream write which pins the strings it references until it completes */
+struct php_mrloop_write_t
+{
+  /* write vectors (referencing the contents of the strings) */
+  php_iovec_t *iov;
+  /* number of write vectors */
+  size_t iovcnt;
+  /* number of write vectors for which space was allocated */
+  size_t iovcap;
+  /* strings referenced by the write vectors */
+  zend_string **chunks;
+  /* number of strings */
+  size_t nchunks;
+  /* event loop in which the write is subsumed */
+  php_mrloop_t *evloop;
+#ifdef HAVE_MRLOOP_STATS
+  /* time at which the write was issued */
+  uint64_t stamp;
+#endif
+};
+
+/* TCP server serviced via the extension-managed ring */
+struct php_mrloop_server_t
+{
+  /* event loop in which the server is subsumed */
+  php_mrloop_t *evloop;
+  /* listening socket file descriptor */
+  int fd;
+  /* path of listening Unix domain socket (removed along with the server) */
+  char *path;
+  /* application protocol spoken by the server */
+  int protocol;
+  /* server callback */
+  php_mrloop_cb_t *cb;
+  /* maximum size of a buffered request (HTTP mode only) */
+  size_t max_request;
+  /* maximum number of concurrent client connections */
+  size_t max_conn;
+  /* number of active client connections */
+  size_t nconn;
+  /* accept operation */
+  php_mrloop_op_t accept_op;
+  /* whether the accept operation is multishot */
+  bool multishot;
+  /* provided buffer ring from which the kernel picks receive buffers (if any) */
+  struct io_uring_buf_ring *br;
+  /* memory backing the provided buffers */
+  char *buffers;
+  /* number of provided buffers */
+  size_t buff_count;
+  /* size of each receive buffer */
+  size_t buff_size;
+  /* provided buffer group identifier */
+  int bgid;
+  /* next server in event loop */
+  php_mrloop_server_t *next;
 };
 
 /* mrloop callback object */
@@ -91,16 +336,21 @@ static inline php_mrloop_t *php_mrloop_from_obj(zend_object *obj)
 
 #define PHP_MRLOOP_OBJ(zv) php_mrloop_from_obj(Z_OBJ_P(zv));
 
+zend_object_handlers php_mrloop_conn_object_handlers;
+
+static inline php_mrloop_conn_t *php_mrloop_conn_from_obj(zend_object *obj)
+{
+  return (php_mrloop_conn_t *)((char *)obj - XtOffsetOf(php_mrloop_conn_t, std));
+}
+
+#define PHP_MRLOOP_CONN_OBJ(zv) php_mrloop_conn_from_obj(Z_OBJ_P(zv));
+
 /* {{{ ZEND_BEGIN_MODULE_GLOBALS */
 ZEND_BEGIN_MODULE_GLOBALS(mrloop)
-/* TCP server callback */
-php_mrloop_cb_t *tcp_cb;
-/* signal callback */
-php_mrloop_cb_t *sig_cb[3];
-/* signal callback count */
-size_t sigc;
-/* TCP buffer size */
-size_t tcp_buff_size;
+/* event loops with signal callbacks (signal dispositions are process-wide) */
+php_mrloop_t *sig_loops;
+/* whether the process is a worker forked by a server (which may not fork workers of its own) */
+bool worker;
 ZEND_END_MODULE_GLOBALS(mrloop)
 /* }}} */
 
@@ -115,48 +365,139 @@ ZEND_DECLARE_MODULE_GLOBALS(mrloop)
 
 static PHP_GINIT_FUNCTION(mrloop);
 
-/* safe rendition of native C strncpy (adapted from https://github.com/ariadnavigo/strlcpy) */
-static size_t php_strncpy(char *dst, char *src, size_t nbytes);
+/* extracts integer value of specified key from options array */
+static zend_long php_mrloop_option_long(HashTable *options, const char *key, zend_long fallback);
+/* extracts boolean value of specified key from options array */
+static bool php_mrloop_option_bool(HashTable *options, const char *key, bool fallback);
+/* extracts numeric value of specified key from options array */
+static double php_mrloop_option_double(HashTable *options, const char *key, double fallback);
 
 /* creates mrloop object in PHP userspace */
 static zend_object *php_mrloop_create_object(zend_class_entry *ce);
 /* frees PHP userspace-residing mrloop object */
 static void php_mrloop_free_object(zend_object *obj);
 
-/* callback specified during creation of event loop */
+/* creates connection object in PHP userspace */
+static zend_object *php_mrloop_conn_create_object(zend_class_entry *ce);
+/* frees PHP userspace-residing connection object */
+static void php_mrloop_conn_free_object(zend_object *obj);
+
+/* callback specified during creation of event loop; subjects signals without userspace handlers to their default disposition */
 static void php_mrloop_signal_handler(const int sig);
-/* creates Mrloop object in PHP userspace */
+/* creates Mrloop object (whose extension-managed ring is set up as specified) in PHP userspace */
 static void php_mrloop_create(INTERNAL_FUNCTION_PARAMETERS);
 /* explicitly stops event loop subsumed in Mrloop object */
 static void php_mrloop_stop(INTERNAL_FUNCTION_PARAMETERS);
 /* runs event loop subsumed in Mrloop object */
 static void php_mrloop_run(INTERNAL_FUNCTION_PARAMETERS);
+/* opens a batch; submissions are deferred until the outermost batch ends */
+static void php_mrloop_batch_begin(php_mrloop_t *evloop);
+/* closes a batch; if it is the outermost one, runs queued future ticks and submits deferred operations */
+static void php_mrloop_batch_end(php_mrloop_t *evloop);
+/* submits operations queued in the mrloop ring and the extension-managed ring */
+static void php_mrloop_flush_all(php_mrloop_t *evloop);
+/* submits operations queued in the mrloop ring unless a batch is open */
+static void php_mrloop_mr_submit(php_mrloop_t *evloop);
+/* invokes a callable in a batch, which coalesces the submissions it makes into one per ring */
+static void php_mrloop_batch(INTERNAL_FUNCTION_PARAMETERS);
+/* submits queued operations immediately */
+static void php_mrloop_flush(INTERNAL_FUNCTION_PARAMETERS);
 
-/* mrloop-bound callback specified during invocation of timer-related functions */
-static int php_mrloop_timer_cb(void *data);
-/* executes a specified action after a specified amount of time */
-static void php_mrloop_add_timer(INTERNAL_FUNCTION_PARAMETERS);
-/* executes a specified action in perpetuity with each successive execution occurring after a specified time interval */
-static void php_mrloop_add_periodic_timer(INTERNAL_FUNCTION_PARAMETERS);
-/* schedules the execution of a specified action for the next event loop tick */
+/* schedules a wake-up through which queued future ticks are drained (unless one is already scheduled) */
+static void php_mrloop_tick_arm(php_mrloop_t *evloop);
+/* mrloop-bound callback through which queued future ticks are drained once no completion batch does so */
+static int php_mrloop_tick_cb(void *data);
+/* runs queued future ticks (those queued in the process included) in FIFO order up to the tick budget */
+static void php_mrloop_tick_drain(php_mrloop_t *evloop);
+/* releases the callback and arguments of a future tick */
+static void php_mrloop_tick_release(php_mrloop_t *evloop, php_mrloop_tick_t *tick);
+/* releases the future ticks yet to run */
+static void php_mrloop_tick_free(php_mrloop_t *evloop);
+/* schedules the execution of a specified action (with the specified arguments) for the next event loop tick */
 static void php_mrloop_add_future_tick(INTERNAL_FUNCTION_PARAMETERS);
 
+/* splits a region of memory into (at most) the specified number of contiguous vectors; returns the number of vectors */
+static size_t php_mrloop_iov_slice(php_iovec_t *iov, char *base, size_t nbytes, size_t vcount);
+/* allocates read buffers of a specified size (split into vcount vectors) or list of sizes (one vector each) */
+static php_mrloop_read_t *php_mrloop_read_init(php_mrloop_t *evloop, zval *nbytes, size_t vcount);
+/* releases read buffers */
+static void php_mrloop_read_free(php_mrloop_read_t *request);
+/* pins a string (split into vcount vectors) or list of strings (one vector each) for writing */
+static php_mrloop_write_t *php_mrloop_write_init(php_mrloop_t *evloop, HashTable *chunks, zend_string *contents, size_t vcount);
+/* releases pinned strings */
+static void php_mrloop_write_free(php_mrloop_write_t *request);
 /* mrloop-bound callback specified during invocation of vectorized read function */
 static void php_mrloop_readv_cb(void *data, int res);
 /* mrloop-bound callback specified during invocation of vectorized write function */
 static void php_mrloop_writev_cb(void *data, int res);
+/* mrloop-bound callback which releases the strings pinned by a callback-less vectorized write */
+static void php_mrloop_writev_release_cb(void *data, int res);
 
-/* initializes client connection context for TCP server */
-static void *php_mrloop_tcp_client_setup(int fd, char **buffer, int *bsize);
-/* processes incoming TCP connections and issues responses to clients */
-static int php_mrloop_tcp_server_recv(void *conn, int fd, ssize_t nbytes, char *buffer);
+/* creates client connection object and populates it with peer information */
+static php_mrloop_conn_t *php_mrloop_tcp_client_init(int fd);
+/* conveys data received from a client to the TCP server callback and issues the ensuing response */
+static void php_mrloop_tcp_server_respond(php_mrloop_conn_t *client, char *buffer, size_t nbytes);
+/* resolves a port number, host:port, [host]:port, or unix:///path string to a socket address */
+static int php_mrloop_tcp_server_address(zend_string *address, zend_long port, php_sockaddr_storage_t *addr, socklen_t *addrlen);
+/* creates listening stream socket bound to specified address */
+static int php_mrloop_tcp_server_bind(php_sockaddr_storage_t *addr, socklen_t addrlen, bool reuseport);
+/* sets up TCP server (and its provided buffer ring, if requested) for a listening socket */
+static php_mrloop_server_t *php_mrloop_tcp_server_init(php_mrloop_t *evloop, int fd, size_t max_conn, size_t buff_count, size_t buff_size);
+/* submits accept operation for TCP server to extension-managed ring */
+static void php_mrloop_tcp_server_accept(php_mrloop_server_t *server);
+/* processes accepted TCP connections */
+static void php_mrloop_tcp_server_accept_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* submits multishot receive operation for client to extension-managed ring */
+static void php_mrloop_tcp_client_recv(php_mrloop_conn_t *client);
+/* processes data placed in provided buffers and returns said buffers to the ring */
+static void php_mrloop_tcp_client_recv_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* queues data for delivery to client; takes ownership of the string */
+static void php_mrloop_tcp_client_send(php_mrloop_conn_t *client, zend_string *data);
+/* writes all queued data to client with a single vectorized write */
+static void php_mrloop_tcp_client_flush(php_mrloop_conn_t *client);
+/* releases written strings from the queue and writes whatever remains */
+static void php_mrloop_tcp_client_send_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* releases data queued for delivery to client without writing it */
+static void php_mrloop_tcp_client_discard(php_mrloop_conn_t *client);
+/* initiates closure of client connection */
+static void php_mrloop_tcp_client_close(php_mrloop_conn_t *client);
+/* releases client context once no operations on it remain in flight and no data remains queued */
+static void php_mrloop_tcp_client_release(php_mrloop_conn_t *client);
+/* adds connection to the list of those to which the event loop holds a reference */
+static void php_mrloop_conn_link(php_mrloop_t *evloop, php_mrloop_conn_t *conn);
+/* removes connection from the list of its event loop */
+static void php_mrloop_conn_unlink(php_mrloop_conn_t *conn);
+/* closes the connections of an event loop whose ring is being torn down and drops its references to them */
+static void php_mrloop_conns_free(php_mrloop_t *evloop);
+/* queues data for delivery to the client on the other end of a connection */
+static void php_mrloop_conn_write(INTERNAL_FUNCTION_PARAMETERS);
+/* closes a connection once the data queued for delivery has been written */
+static void php_mrloop_conn_close(INTERNAL_FUNCTION_PARAMETERS);
+/* returns the IP address of the client on the other end of a connection */
+static void php_mrloop_conn_remote_address(INTERNAL_FUNCTION_PARAMETERS);
+/* returns the port of the client on the other end of a connection */
+static void php_mrloop_conn_remote_port(INTERNAL_FUNCTION_PARAMETERS);
+/* returns the socket file descriptor of a connection */
+static void php_mrloop_conn_fd(INTERNAL_FUNCTION_PARAMETERS);
+/* releases TCP server resources */
+static void php_mrloop_tcp_server_free(php_mrloop_server_t *server);
+/* replaces the event loop state inherited by a forked worker with a fresh instance */
+static void php_mrloop_worker_reset(php_mrloop_t *evloop);
+/* forks TCP server workers and respawns those that exit abnormally; returns true in a worker */
+static bool php_mrloop_tcp_server_supervise(php_mrloop_t *evloop, size_t workers);
+/* starts a server speaking the specified protocol */
+static void php_mrloop_server_listen(INTERNAL_FUNCTION_PARAMETERS, int protocol);
 /* starts a TCP server */
 static void php_mrloop_tcp_server_listen(INTERNAL_FUNCTION_PARAMETERS);
 
-/* mrloop-bound callback specified during invocation of signal handlers */
-static void php_mrloop_signal_cb(int sig);
+/* submits signalfd read operation to extension-managed ring (unless one is in flight); returns false if no submission queue entry is available */
+static bool php_mrloop_signal_arm(php_mrloop_t *evloop);
+/* conveys a signal read from the signalfd to the callbacks registered for it */
+static void php_mrloop_signal_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
 /* executes specified action in the event that a specified signal is detected */
 static void php_mrloop_add_signal(INTERNAL_FUNCTION_PARAMETERS);
+/* releases the signal callbacks and signalfd of an event loop (and unblocks the signals no other loop handles) */
+static void php_mrloop_signal_free(php_mrloop_t *evloop);
 
 /* funnels file descriptor in readable stream into event loop and thence executes a non-blocking read operation */
 static void php_mrloop_add_read_stream(INTERNAL_FUNCTION_PARAMETERS);
@@ -165,7 +506,7 @@ static void php_mrloop_add_write_stream(INTERNAL_FUNCTION_PARAMETERS);
 /* performs vectorized non-blocking write operation on a specified file descriptor */
 static void php_mrloop_writev(INTERNAL_FUNCTION_PARAMETERS);
 
-zend_class_entry *php_mrloop_ce, *php_mrloop_exception_ce;
+zend_class_entry *php_mrloop_ce, *php_mrloop_conn_ce, *php_mrloop_timer_ce, *php_mrloop_exception_ce;
 
 #define PHP_MRLOOP_THROW(message) zend_throw_exception(php_mrloop_exception_ce, message, 0);
 
@@ -179,6 +520,15 @@ zend_class_entry *php_mrloop_ce, *php_mrloop_exception_ce;
     GC_ADDREF(mrloop_cb->fci.object);                                           \
   }
 
+/* releases PHP function wrapped in mrloop callback-bound structure along with the structure itself */
+#define PHP_MRLOOP_CB_FREE(mrloop_cb)             \
+  zval_ptr_dtor(&mrloop_cb->fci.function_name);   \
+  if (mrloop_cb->fci.object)                      \
+  {                                               \
+    OBJ_RELEASE(mrloop_cb->fci.object);           \
+  }                                               \
+  efree(mrloop_cb);
+
 /* extract file descriptor from PHP stream */
 #define PHP_STREAM_TO_FD(fd_stream, fd_resource, fd)                 \
   if ((fd_stream = (php_stream *)zend_fetch_resource_ex(             \
@@ -201,4 +551,11 @@ zend_class_entry *php_mrloop_ce, *php_mrloop_exception_ce;
     mr_stop(this->loop);                                             \
   }
 
+#include "http.h"
+#include "udp.h"
+#include "client.h"
+#include "timer.h"
+#include "file.h"
+#include "fiber.h"
+
 #endif
@@ -0,0 +1,111 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#include "loop.h"
+
+static int php_mrloop_slab_class(size_t size)
+{
+  int idx = 0;
+
+  if (size > PHP_MRLOOP_SLAB_MAX_SIZE)
+  {
+    return -1;
+  }
+
+  while (((size_t)1 << (PHP_MRLOOP_SLAB_MIN_SHIFT + idx)) < size)
+  {
+    idx++;
+  }
+
+  return idx;
+}
+static void *php_mrloop_slab_alloc(php_mrloop_t *evloop, size_t size)
+{
+  php_mrloop_slab_t *slab;
+  size_t record_size;
+  void *record;
+  int idx;
+
+  if ((idx = php_mrloop_slab_class(size)) < 0)
+  {
+    return emalloc(size);
+  }
+
+  slab = &evloop->slabs[idx];
+
+  if (slab->free != NULL)
+  {
+    record = slab->free;
+    slab->free = *(void **)record;
+
+    return record;
+  }
+
+  record_size = (size_t)1 << (PHP_MRLOOP_SLAB_MIN_SHIFT + idx);
+
+  if (slab->cursor == NULL || slab->cursor + record_size > slab->end)
+  {
+    // the first word of a chunk links it to the one before it; records are carved from the remainder
+    record = emalloc(PHP_MRLOOP_SLAB_CHUNK_SIZE);
+    *(void **)record = slab->chunks;
+    slab->chunks = record;
+    slab->cursor = (char *)record + ZEND_MM_ALIGNED_SIZE(sizeof(void *));
+    slab->end = (char *)record + PHP_MRLOOP_SLAB_CHUNK_SIZE;
+  }
+
+  record = slab->cursor;
+  slab->cursor += record_size;
+
+  return record;
+}
+static void php_mrloop_slab_release(php_mrloop_t *evloop, void *record, size_t size)
+{
+  php_mrloop_slab_t *slab;
+  int idx;
+
+  if ((idx = php_mrloop_slab_class(size)) < 0)
+  {
+    efree(record);
+    return;
+  }
+
+  slab = &evloop->slabs[idx];
+  *(void **)record = slab->free;
+  slab->free = record;
+}
+static void php_mrloop_slab_free(php_mrloop_t *evloop)
+{
+  php_mrloop_slab_t *slab;
+  void *chunk, *next;
+
+  for (size_t idx = 0; idx < PHP_MRLOOP_SLAB_CLASSES; idx++)
+  {
+    slab = &evloop->slabs[idx];
+
+    for (chunk = slab->chunks; chunk != NULL; chunk = next)
+    {
+      next = *(void **)chunk;
+      efree(chunk);
+    }
+
+    memset(slab, 0, sizeof(php_mrloop_slab_t));
+  }
+}
+static php_mrloop_cb_t *php_mrloop_cb_alloc(php_mrloop_t *evloop, zend_fcall_info *fci, zend_fcall_info_cache *fci_cache)
+{
+  php_mrloop_cb_t *cb = php_mrloop_slab_alloc(evloop, sizeof(php_mrloop_cb_t));
+  PHP_CB_TO_MRLOOP_CB(cb, (*fci), (*fci_cache));
+
+  cb->data = NULL;
+  cb->signal = 0;
+
+  return cb;
+}
+static void php_mrloop_cb_release(php_mrloop_t *evloop, php_mrloop_cb_t *cb)
+{
+  zval_ptr_dtor(&cb->fci.function_name);
+  if (cb->fci.object)
+  {
+    OBJ_RELEASE(cb->fci.object);
+  }
+
+  php_mrloop_slab_release(evloop, cb, sizeof(php_mrloop_cb_t));
+}
@@ -0,0 +1,50 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#define PHP_MRLOOP_SLAB_CLASSES 6
+#define PHP_MRLOOP_SLAB_MIN_SHIFT 5
+#define PHP_MRLOOP_SLAB_MAX_SIZE (1 << (PHP_MRLOOP_SLAB_MIN_SHIFT + PHP_MRLOOP_SLAB_CLASSES - 1))
+#define PHP_MRLOOP_SLAB_CHUNK_SIZE 16384
+
+/*
+ * per-loop slab of records of a single size class
+ *
+ * Records whose lifetime is bounded by a single operation - the callbacks of
+ * future ticks, reads, writes and file system operations, the request
+ * records of said operations, their vectors and the like - are carved from
+ * chunks owned by the event loop that issues them. The completion handler
+ * that consumes a record returns it to the slab whence it came, where it is
+ * reused by the next operation; chunks are released along with the loop.
+ *
+ * Records that may outlive the operation that creates them (those of
+ * servers, connections, timers and signal handlers) are allocated from the
+ * heap and released by their owners. Requests larger than the largest size
+ * class (1024 bytes) are also allocated from the heap.
+ */
+struct php_mrloop_slab_t
+{
+  /* released records available for reuse (each links to the next through its first word) */
+  void *free;
+  /* chunks from which records are carved (each links to the one before it through its first word) */
+  void *chunks;
+  /* next uncarved record in the newest chunk */
+  char *cursor;
+  /* end of the newest chunk */
+  char *end;
+};
+
+/* returns the size class of a record of the specified size (or -1 if it is too large for the slabs) */
+static int php_mrloop_slab_class(size_t size);
+/* carves a record of (at least) the specified size from a slab of an event loop */
+static void *php_mrloop_slab_alloc(php_mrloop_t *evloop, size_t size);
+/* returns a record of the specified size to the slab of an event loop whence it came */
+static void php_mrloop_slab_release(php_mrloop_t *evloop, void *record, size_t size);
+/* releases the chunks of all the slabs of an event loop */
+static void php_mrloop_slab_free(php_mrloop_t *evloop);
+/* wraps PHP function in a callback-bound structure carved from a slab of an event loop */
+static php_mrloop_cb_t *php_mrloop_cb_alloc(php_mrloop_t *evloop, zend_fcall_info *fci, zend_fcall_info_cache *fci_cache);
+/* releases PHP function wrapped in a slab-bound callback structure and returns the structure to its slab */
+static void php_mrloop_cb_release(php_mrloop_t *evloop, php_mrloop_cb_t *cb);
+
+#endif
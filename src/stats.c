@@ -0,0 +1,255 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#include "loop.h"
+
+#ifdef HAVE_MRLOOP_STATS
+static uint64_t php_mrloop_stats_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+static uint64_t php_mrloop_stats_since(uint64_t stamp)
+{
+  uint64_t now = php_mrloop_stats_now();
+
+  return now > stamp ? now - stamp : 0;
+}
+static void php_mrloop_histogram_add(php_mrloop_histogram_t *histogram, uint64_t sample)
+{
+  // bucket n holds samples n bits wide; the last one also holds any wider
+  size_t idx = sample == 0 ? 0 : (size_t)(64 - __builtin_clzll(sample));
+
+  histogram->count++;
+  histogram->sum += sample;
+  if (sample > histogram->max)
+  {
+    histogram->max = sample;
+  }
+  histogram->buckets[idx < PHP_MRLOOP_HISTOGRAM_BUCKETS ? idx : PHP_MRLOOP_HISTOGRAM_BUCKETS - 1]++;
+}
+static uint64_t php_mrloop_histogram_percentile(php_mrloop_histogram_t *histogram, double percentile)
+{
+  uint64_t rank, seen, bound;
+
+  if (histogram->count == 0)
+  {
+    return 0;
+  }
+
+  rank = (uint64_t)(percentile * (double)(histogram->count - 1)) + 1;
+  seen = 0;
+
+  for (size_t idx = 0; idx < PHP_MRLOOP_HISTOGRAM_BUCKETS; idx++)
+  {
+    seen += histogram->buckets[idx];
+
+    if (seen >= rank)
+    {
+      bound = ((uint64_t)1 << idx) - 1;
+
+      return bound < histogram->max && idx < PHP_MRLOOP_HISTOGRAM_BUCKETS - 1 ? bound : histogram->max;
+    }
+  }
+
+  return histogram->max;
+}
+static void php_mrloop_histogram_to_array(php_mrloop_histogram_t *histogram, zval *result)
+{
+  zval buckets;
+  uint64_t bound;
+
+  array_init(result);
+  add_assoc_long(result, "count", (zend_long)histogram->count);
+  add_assoc_double(result, "mean", histogram->count ? (double)histogram->sum / (double)histogram->count : 0.0);
+  add_assoc_long(result, "max", (zend_long)histogram->max);
+  add_assoc_long(result, "p50", (zend_long)php_mrloop_histogram_percentile(histogram, 0.5));
+  add_assoc_long(result, "p90", (zend_long)php_mrloop_histogram_percentile(histogram, 0.9));
+  add_assoc_long(result, "p99", (zend_long)php_mrloop_histogram_percentile(histogram, 0.99));
+
+  array_init(&buckets);
+  for (size_t idx = 0; idx < PHP_MRLOOP_HISTOGRAM_BUCKETS; idx++)
+  {
+    if (histogram->buckets[idx] == 0)
+    {
+      continue;
+    }
+
+    bound = idx < PHP_MRLOOP_HISTOGRAM_BUCKETS - 1 ? ((uint64_t)1 << idx) - 1 : histogram->max;
+    add_index_long(&buckets, (zend_ulong)bound, (zend_long)histogram->buckets[idx]);
+  }
+  add_assoc_zval(result, "buckets", &buckets);
+}
+static void php_mrloop_stats_complete(php_mrloop_t *evloop, php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_op_handler handler = op->handler;
+  int type;
+
+  // vectorized reads and writes on registered files are timed from their requests by the callbacks they report to
+  if (handler == php_mrloop_uring_io_cb)
+  {
+    return;
+  }
+
+  if (handler == php_mrloop_tcp_client_recv_cb || handler == php_mrloop_client_read_cb || handler == php_mrloop_udp_recv_cb ||
+      handler == php_mrloop_stream_read_cb || handler == php_mrloop_splice_in_cb)
+  {
+    type = PHP_MRLOOP_STATS_READ;
+  }
+  else if (handler == php_mrloop_tcp_client_send_cb || handler == php_mrloop_udp_send_cb || handler == php_mrloop_splice_out_cb)
+  {
+    type = PHP_MRLOOP_STATS_WRITE;
+  }
+  else if (handler == php_mrloop_tcp_server_accept_cb)
+  {
+    type = PHP_MRLOOP_STATS_ACCEPT;
+  }
+  else if (handler == php_mrloop_wheel_cb)
+  {
+    type = PHP_MRLOOP_STATS_TIMER;
+  }
+  else if (handler == php_mrloop_await_cb)
+  {
+    // indexed by the PHP_MRLOOP_AWAIT_* type of the operation
+    static const int await_types[] = {PHP_MRLOOP_STATS_READ, PHP_MRLOOP_STATS_WRITE, PHP_MRLOOP_STATS_TIMER, PHP_MRLOOP_STATS_ACCEPT};
+
+    type = await_types[((php_mrloop_await_t *)op->data)->type];
+  }
+  else
+  {
+    type = PHP_MRLOOP_STATS_OTHER;
+  }
+
+  php_mrloop_histogram_add(&evloop->stats.latency[type], php_mrloop_stats_since(op->stamp));
+
+  // multishot operations remain armed; each completion is timed from the one before it
+  if (cqe->flags & IORING_CQE_F_MORE)
+  {
+    op->stamp = php_mrloop_stats_now();
+  }
+}
+static void php_mrloop_stats_reset(php_mrloop_t *evloop)
+{
+  php_mrloop_stats_t *stats = &evloop->stats;
+  bool enabled = stats->enabled;
+
+  memset(stats, 0, sizeof(php_mrloop_stats_t));
+  stats->enabled = enabled;
+  stats->since = php_mrloop_stats_now();
+}
+#endif
+static int php_mrloop_call(php_mrloop_t *evloop, zend_fcall_info *fci, zend_fcall_info_cache *fci_cache)
+{
+#ifdef HAVE_MRLOOP_STATS
+  uint64_t start;
+  int ret;
+
+  if (PHP_MRLOOP_STATS_ENABLED(evloop))
+  {
+    start = php_mrloop_stats_now();
+    ret = zend_call_function(fci, fci_cache);
+    php_mrloop_histogram_add(&evloop->stats.callbacks, php_mrloop_stats_since(start));
+
+    return ret;
+  }
+#endif
+
+  return zend_call_function(fci, fci_cache);
+}
+static void php_mrloop_stats(INTERNAL_FUNCTION_PARAMETERS)
+{
+  bool reset;
+#ifdef HAVE_MRLOOP_STATS
+  zval *obj;
+  php_mrloop_t *this;
+  static const char *ops[PHP_MRLOOP_STATS_OPS] = {"read", "write", "accept", "timer", "other"};
+  php_mrloop_stats_t *stats;
+  php_mrloop_server_t *server;
+  php_mrloop_udp_t *udp;
+  zval histogram, latency, memory;
+  size_t connections, receive, fixed, slabs;
+  void *chunk;
+#endif
+
+  reset = false;
+
+  ZEND_PARSE_PARAMETERS_START(0, 1)
+  Z_PARAM_OPTIONAL
+  Z_PARAM_BOOL(reset)
+  ZEND_PARSE_PARAMETERS_END();
+
+#ifdef HAVE_MRLOOP_STATS
+  obj = getThis();
+  this = PHP_MRLOOP_OBJ(obj);
+  stats = &this->stats;
+
+  // gauges are computed on demand rather than maintained along the paths they describe
+  connections = 0;
+  receive = 0;
+  for (server = this->servers; server != NULL; server = server->next)
+  {
+    connections += server->nconn;
+    // connections own their receive buffers unless the kernel picks them from a provided buffer ring
+    receive += server->br ? server->buff_count * server->buff_size : server->nconn * server->buff_size;
+  }
+  for (udp = this->udp_servers; udp != NULL; udp = udp->next)
+  {
+    receive += udp->buff_count * udp->buff_size;
+  }
+
+  fixed = this->uring ? this->uring->buff_count * this->uring->buff_size : 0;
+
+  slabs = 0;
+  for (size_t idx = 0; idx < PHP_MRLOOP_SLAB_CLASSES; idx++)
+  {
+    for (chunk = this->slabs[idx].chunks; chunk != NULL; chunk = *(void **)chunk)
+    {
+      slabs += PHP_MRLOOP_SLAB_CHUNK_SIZE;
+    }
+  }
+
+  array_init(return_value);
+  add_assoc_bool(return_value, "enabled", stats->enabled);
+  add_assoc_double(return_value, "uptime", stats->enabled ? (double)php_mrloop_stats_since(stats->since) / 1e6 : 0.0);
+  add_assoc_long(return_value, "submissions", (zend_long)stats->submissions);
+  add_assoc_long(return_value, "enters", (zend_long)stats->enters);
+  add_assoc_long(return_value, "mr_flushes", (zend_long)stats->mr_flushes);
+  add_assoc_long(return_value, "completions", (zend_long)stats->completions);
+  add_assoc_long(return_value, "ticks", (zend_long)stats->ticks);
+
+  php_mrloop_histogram_to_array(&stats->batch, &histogram);
+  add_assoc_zval(return_value, "batch", &histogram);
+
+  array_init(&latency);
+  for (size_t idx = 0; idx < PHP_MRLOOP_STATS_OPS; idx++)
+  {
+    php_mrloop_histogram_to_array(&stats->latency[idx], &histogram);
+    add_assoc_zval(&latency, ops[idx], &histogram);
+  }
+  add_assoc_zval(return_value, "latency", &latency);
+
+  php_mrloop_histogram_to_array(&stats->callbacks, &histogram);
+  add_assoc_zval(return_value, "callbacks", &histogram);
+  php_mrloop_histogram_to_array(&stats->lag, &histogram);
+  add_assoc_zval(return_value, "lag", &histogram);
+
+  add_assoc_long(return_value, "connections", (zend_long)connections);
+
+  array_init(&memory);
+  add_assoc_long(&memory, "receive_buffers", (zend_long)receive);
+  add_assoc_long(&memory, "fixed_buffers", (zend_long)fixed);
+  add_assoc_long(&memory, "slabs", (zend_long)slabs);
+  add_assoc_zval(return_value, "memory", &memory);
+
+  add_assoc_long(return_value, "ring_flags", this->uring ? (zend_long)this->uring->flags : 0);
+
+  if (reset && stats->enabled)
+  {
+    php_mrloop_stats_reset(this);
+  }
+#else
+  ZEND_IGNORE_VALUE(reset);
+  PHP_MRLOOP_THROW("Statistics are unavailable (the extension was built with --disable-mrloop-stats)");
+#endif
+}
@@ -0,0 +1,168 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#define PHP_MRLOOP_HISTOGRAM_BUCKETS 32
+#define PHP_MRLOOP_STATS_READ 0
+#define PHP_MRLOOP_STATS_WRITE 1
+#define PHP_MRLOOP_STATS_ACCEPT 2
+#define PHP_MRLOOP_STATS_TIMER 3
+#define PHP_MRLOOP_STATS_OTHER 4
+#define PHP_MRLOOP_STATS_OPS 5
+
+/* histogram of non-negative integer samples in power-of-two buckets */
+struct php_mrloop_histogram_t
+{
+  /* number of samples */
+  uint64_t count;
+  /* sum of samples */
+  uint64_t sum;
+  /* largest sample */
+  uint64_t max;
+  /* sample counts (bucket n holds samples no smaller than 2^(n - 1) and smaller than 2^n) */
+  uint64_t buckets[PHP_MRLOOP_HISTOGRAM_BUCKETS];
+};
+
+/*
+ * event loop statistics
+ *
+ * Counters and histograms are compiled in unless the extension is built with
+ * --disable-mrloop-stats, in which case the macros below expand to nothing.
+ * Even then, they are only updated in loops created with the stats option,
+ * so the cost to other loops is one predictable branch per collection point.
+ * Durations are measured in microseconds on the monotonic clock.
+ */
+struct php_mrloop_stats_t
+{
+  /* whether statistics are collected */
+  bool enabled;
+  /* time at which collection started (or the statistics were last reset) */
+  uint64_t since;
+  /* submission queue entries submitted to the extension-managed ring */
+  uint64_t submissions;
+  /* submissions to the extension-managed ring (io_uring_submit calls which submitted entries) */
+  uint64_t enters;
+  /* flushes of the mrloop ring */
+  uint64_t mr_flushes;
+  /* completions reaped from the extension-managed ring */
+  uint64_t completions;
+  /* future ticks run */
+  uint64_t ticks;
+  /* completions reaped per relay pass */
+  php_mrloop_histogram_t batch;
+  /* time from submission to completion (indexed by operation type) */
+  php_mrloop_histogram_t latency[PHP_MRLOOP_STATS_OPS];
+  /* time spent in PHP callbacks */
+  php_mrloop_histogram_t callbacks;
+  /* time by which timers fire later than scheduled */
+  php_mrloop_histogram_t lag;
+};
+
+#ifdef HAVE_MRLOOP_STATS
+/* whether an event loop collects statistics */
+#define PHP_MRLOOP_STATS_ENABLED(evloop) UNEXPECTED((evloop)->stats.enabled)
+/* adds to a statistics counter */
+#define PHP_MRLOOP_STATS_COUNT(evloop, counter, n) \
+  do                                               \
+  {                                                \
+    if (PHP_MRLOOP_STATS_ENABLED(evloop))          \
+    {                                              \
+      (evloop)->stats.counter += (n);              \
+    }                                              \
+  } while (0)
+/* adds a sample to a statistics histogram */
+#define PHP_MRLOOP_STATS_RECORD(evloop, histogram, sample)                      \
+  do                                                                            \
+  {                                                                             \
+    if (PHP_MRLOOP_STATS_ENABLED(evloop))                                       \
+    {                                                                           \
+      php_mrloop_histogram_add(&(evloop)->stats.histogram, (uint64_t)(sample)); \
+    }                                                                           \
+  } while (0)
+/* records the time at which an operation (or request) was issued */
+#define PHP_MRLOOP_STATS_STAMP(evloop, record)  \
+  do                                            \
+  {                                             \
+    if (PHP_MRLOOP_STATS_ENABLED(evloop))       \
+    {                                           \
+      (record)->stamp = php_mrloop_stats_now(); \
+    }                                           \
+  } while (0)
+/* adds the time elapsed since an operation (or request) was issued to a statistics histogram */
+#define PHP_MRLOOP_STATS_ELAPSED(evloop, histogram, record)                                          \
+  do                                                                                                 \
+  {                                                                                                  \
+    if (PHP_MRLOOP_STATS_ENABLED(evloop))                                                            \
+    {                                                                                                \
+      php_mrloop_histogram_add(&(evloop)->stats.histogram, php_mrloop_stats_since((record)->stamp)); \
+    }                                                                                                \
+  } while (0)
+/* records the submission of entries to the extension-managed ring */
+#define PHP_MRLOOP_STATS_SUBMIT(evloop, nsubmitted)           \
+  do                                                          \
+  {                                                           \
+    if (PHP_MRLOOP_STATS_ENABLED(evloop) && (nsubmitted) > 0) \
+    {                                                         \
+      (evloop)->stats.submissions += (uint64_t)(nsubmitted);  \
+      (evloop)->stats.enters++;                               \
+    }                                                         \
+  } while (0)
+/* records the latency of an operation completed in the extension-managed ring */
+#define PHP_MRLOOP_STATS_COMPLETE(evloop, op, cqe) \
+  do                                               \
+  {                                                \
+    if (PHP_MRLOOP_STATS_ENABLED(evloop))          \
+    {                                              \
+      php_mrloop_stats_complete(evloop, op, cqe);  \
+    }                                              \
+  } while (0)
+#else
+#define PHP_MRLOOP_STATS_ENABLED(evloop) 0
+#define PHP_MRLOOP_STATS_COUNT(evloop, counter, n) \
+  do                                               \
+  {                                                \
+  } while (0)
+#define PHP_MRLOOP_STATS_RECORD(evloop, histogram, sample) \
+  do                                                       \
+  {                                                        \
+  } while (0)
+#define PHP_MRLOOP_STATS_STAMP(evloop, record) \
+  do                                           \
+  {                                            \
+  } while (0)
+#define PHP_MRLOOP_STATS_ELAPSED(evloop, histogram, record) \
+  do                                                        \
+  {                                                         \
+  } while (0)
+#define PHP_MRLOOP_STATS_SUBMIT(evloop, nsubmitted) \
+  do                                                \
+  {                                                 \
+  } while (0)
+#define PHP_MRLOOP_STATS_COMPLETE(evloop, op, cqe) \
+  do                                               \
+  {                                                \
+  } while (0)
+#endif
+
+#ifdef HAVE_MRLOOP_STATS
+/* returns the current time (in microseconds) on the monotonic clock */
+static uint64_t php_mrloop_stats_now(void);
+/* returns the time elapsed (in microseconds) since the specified time on the monotonic clock (0 if it is yet to come) */
+static uint64_t php_mrloop_stats_since(uint64_t stamp);
+/* adds a sample to a histogram */
+static void php_mrloop_histogram_add(php_mrloop_histogram_t *histogram, uint64_t sample);
+/* returns an estimate of the specified percentile of a histogram (the inclusive upper bound of the bucket in which it falls) */
+static uint64_t php_mrloop_histogram_percentile(php_mrloop_histogram_t *histogram, double percentile);
+/* converts a histogram to an array of its count, mean, maximum, percentiles and non-empty buckets (keyed by upper bound) */
+static void php_mrloop_histogram_to_array(php_mrloop_histogram_t *histogram, zval *result);
+/* records the latency of an operation completed in the extension-managed ring by operation type */
+static void php_mrloop_stats_complete(php_mrloop_t *evloop, php_mrloop_op_t *op, php_cqe_t *cqe);
+/* clears the counters and histograms of an event loop */
+static void php_mrloop_stats_reset(php_mrloop_t *evloop);
+#endif
+/* invokes a PHP callback (and records the time spent therein) */
+static int php_mrloop_call(php_mrloop_t *evloop, zend_fcall_info *fci, zend_fcall_info_cache *fci_cache);
+/* returns the statistics of an event loop and, optionally, resets them */
+static void php_mrloop_stats(INTERNAL_FUNCTION_PARAMETERS);
+
+#endif
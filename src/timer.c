@@ -0,0 +1,499 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#include "timer.h"
+
+static zend_object *php_mrloop_timer_create_object(zend_class_entry *ce)
+{
+  php_mrloop_timer_t *timer = zend_object_alloc(sizeof(php_mrloop_timer_t), ce);
+  zend_object_std_init(&timer->std, ce);
+
+  timer->std.handlers = &php_mrloop_timer_object_handlers;
+  timer->evloop = NULL;
+  timer->cb = NULL;
+  timer->next = NULL;
+  timer->pprev = NULL;
+  timer->sibling = NULL;
+  timer->psibling = NULL;
+
+  return &timer->std;
+}
+static void php_mrloop_timer_free_object(zend_object *obj)
+{
+  php_mrloop_timer_t *timer = php_mrloop_timer_from_obj(obj);
+
+  // active timers are referenced by the wheel; they are only ever released here during shutdown
+  if (timer->pprev)
+  {
+    php_mrloop_wheel_unlink(timer);
+    timer->evloop->wheel->count--;
+  }
+
+  if (timer->psibling)
+  {
+    *timer->psibling = timer->sibling;
+    if (timer->sibling)
+    {
+      timer->sibling->psibling = timer->psibling;
+    }
+  }
+
+  if (timer->cb)
+  {
+    PHP_MRLOOP_CB_FREE(timer->cb);
+  }
+
+  zend_object_std_dtor(obj);
+}
+static uint64_t php_mrloop_wheel_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+static php_mrloop_wheel_t *php_mrloop_wheel(php_mrloop_t *evloop)
+{
+  php_mrloop_wheel_t *wheel;
+
+  if (evloop->wheel)
+  {
+    return evloop->wheel;
+  }
+
+  if (php_mrloop_uring(evloop) == NULL)
+  {
+    return NULL;
+  }
+
+  wheel = ecalloc(1, sizeof(php_mrloop_wheel_t));
+  wheel->op.handler = php_mrloop_wheel_cb;
+  wheel->op.data = evloop;
+  wheel->now = php_mrloop_wheel_clock();
+
+  evloop->wheel = wheel;
+
+  return wheel;
+}
+static void php_mrloop_wheel_link(php_mrloop_wheel_t *wheel, php_mrloop_timer_t *timer)
+{
+  php_mrloop_timer_t **slot;
+  uint64_t delta, expiry;
+  int level;
+
+  expiry = timer->expiry;
+  delta = expiry - wheel->now;
+
+  for (level = 0; level < PHP_MRLOOP_WHEEL_LEVELS - 1; level++)
+  {
+    if (delta < (UINT64_C(1) << (PHP_MRLOOP_WHEEL_BITS * (level + 1))))
+    {
+      break;
+    }
+  }
+
+  // timers beyond the reach of the top level wait in its farthest slot and are re-hashed upon cascading from it
+  if (delta >= (UINT64_C(1) << (PHP_MRLOOP_WHEEL_BITS * PHP_MRLOOP_WHEEL_LEVELS)))
+  {
+    expiry = wheel->now + (UINT64_C(1) << (PHP_MRLOOP_WHEEL_BITS * PHP_MRLOOP_WHEEL_LEVELS)) - 1;
+  }
+
+  slot = &wheel->slots[level][(expiry >> (PHP_MRLOOP_WHEEL_BITS * level)) & PHP_MRLOOP_WHEEL_MASK];
+
+  timer->next = *slot;
+  if (timer->next)
+  {
+    timer->next->pprev = &timer->next;
+  }
+  timer->pprev = slot;
+  *slot = timer;
+}
+static void php_mrloop_wheel_unlink(php_mrloop_timer_t *timer)
+{
+  *timer->pprev = timer->next;
+  if (timer->next)
+  {
+    timer->next->pprev = timer->pprev;
+  }
+
+  timer->next = NULL;
+  timer->pprev = NULL;
+}
+static uint64_t php_mrloop_wheel_next(php_mrloop_wheel_t *wheel)
+{
+  uint64_t next, due;
+  size_t current, idx;
+  int shift;
+
+  next = 0;
+
+  if (wheel->count == 0)
+  {
+    return 0;
+  }
+
+  for (int level = 0; level < PHP_MRLOOP_WHEEL_LEVELS; level++)
+  {
+    shift = PHP_MRLOOP_WHEEL_BITS * level;
+    current = (size_t)(wheel->now >> shift) & PHP_MRLOOP_WHEEL_MASK;
+
+    // the first occupied slot past the current one is due when the level's hand reaches it
+    for (size_t distance = 1; distance <= PHP_MRLOOP_WHEEL_SLOTS; distance++)
+    {
+      idx = (current + distance) & PHP_MRLOOP_WHEEL_MASK;
+
+      if (wheel->slots[level][idx])
+      {
+        due = ((wheel->now >> shift) + distance) << shift;
+        if (next == 0 || due < next)
+        {
+          next = due;
+        }
+        break;
+      }
+    }
+  }
+
+  return next;
+}
+static void php_mrloop_wheel_arm(php_mrloop_t *evloop)
+{
+  php_mrloop_wheel_t *wheel = evloop->wheel;
+  struct io_uring_sqe *sqe;
+  uint64_t next, now, delay;
+
+  if (wheel == NULL || (next = php_mrloop_wheel_next(wheel)) == 0)
+  {
+    return;
+  }
+
+  // a timeout armed for an earlier (or the same) time wakes the wheel soon enough
+  if (wheel->armed && wheel->deadline <= next)
+  {
+    return;
+  }
+
+  now = php_mrloop_wheel_clock();
+  delay = next > now ? next - now : 0;
+
+  wheel->ts.tv_sec = (long long)(delay / 1000);
+  wheel->ts.tv_nsec = (long long)(delay % 1000) * 1000000;
+
+  if (wheel->armed)
+  {
+    if ((sqe = php_mrloop_uring_sqe(evloop, NULL)) == NULL)
+    {
+      PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+      return;
+    }
+
+    io_uring_prep_timeout_update(sqe, &wheel->ts, (__u64)(uintptr_t)&wheel->op, 0);
+  }
+  else
+  {
+    if ((sqe = php_mrloop_uring_sqe(evloop, &wheel->op)) == NULL)
+    {
+      PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+      return;
+    }
+
+    io_uring_prep_timeout(sqe, &wheel->ts, 0, 0);
+    wheel->armed = true;
+  }
+
+  wheel->deadline = next;
+  php_mrloop_uring_submit(evloop);
+}
+static void php_mrloop_wheel_cascade(php_mrloop_wheel_t *wheel, int level)
+{
+  php_mrloop_timer_t *list, *timer;
+  size_t idx;
+
+  idx = (size_t)(wheel->now >> (PHP_MRLOOP_WHEEL_BITS * level)) & PHP_MRLOOP_WHEEL_MASK;
+
+  list = wheel->slots[level][idx];
+  wheel->slots[level][idx] = NULL;
+  if (list)
+  {
+    list->pprev = &list;
+  }
+
+  while ((timer = list) != NULL)
+  {
+    php_mrloop_wheel_unlink(timer);
+    php_mrloop_wheel_link(wheel, timer);
+  }
+}
+static void php_mrloop_wheel_expire(php_mrloop_t *evloop)
+{
+  php_mrloop_wheel_t *wheel = evloop->wheel;
+  php_mrloop_timer_t *list, *timer;
+  php_mrloop_cb_t *cb;
+  zval result;
+  size_t idx;
+  int ret;
+
+  // the slot is detached so that timers re-armed by their callbacks are not run again in this pass
+  idx = (size_t)wheel->now & PHP_MRLOOP_WHEEL_MASK;
+  list = wheel->slots[0][idx];
+  wheel->slots[0][idx] = NULL;
+  if (list)
+  {
+    list->pprev = &list;
+  }
+
+  while ((timer = list) != NULL)
+  {
+    // the timer must survive its callback, which may cancel it or drop the last userspace reference to it
+    GC_ADDREF(&timer->std);
+    PHP_MRLOOP_STATS_RECORD(evloop, lag, php_mrloop_stats_since(timer->expiry * 1000));
+
+    if (timer->periodic)
+    {
+      php_mrloop_wheel_unlink(timer);
+      php_mrloop_timer_schedule(wheel, timer);
+    }
+    else
+    {
+      php_mrloop_timer_stop(timer);
+    }
+
+    cb = timer->cb;
+    cb->fci.retval = &result;
+    cb->fci.param_count = 0;
+    cb->fci.params = NULL;
+
+    ret = php_mrloop_call(evloop, &cb->fci, &cb->fci_cache);
+
+    if (ret == FAILURE)
+    {
+      php_mrloop_timer_stop(timer);
+      OBJ_RELEASE(&timer->std);
+
+      // timers yet to run are moved from the detached list (which lives on this stack frame) to the next slot, the
+      // current one having been processed already
+      while ((timer = list) != NULL)
+      {
+        php_mrloop_wheel_unlink(timer);
+        timer->expiry = wheel->now + 1;
+        php_mrloop_wheel_link(wheel, timer);
+      }
+
+      PHP_MRLOOP_THROW("There is an error in your callback");
+      mr_stop(evloop->loop);
+
+      return;
+    }
+
+    // periodic timers whose callbacks return 0 are cancelled
+    if (timer->periodic && Z_TYPE(result) == IS_LONG && Z_LVAL(result) == 0)
+    {
+      php_mrloop_timer_stop(timer);
+    }
+
+    zval_ptr_dtor(&result);
+    OBJ_RELEASE(&timer->std);
+  }
+}
+static void php_mrloop_wheel_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_t *evloop = (php_mrloop_t *)op->data;
+  php_mrloop_wheel_t *wheel = evloop->wheel;
+  uint64_t target, next;
+
+  wheel->armed = false;
+  target = php_mrloop_wheel_clock();
+
+  // slots are visited in order of time; empty stretches of the wheel are skipped entirely (and the rest are left for
+  // the next run once a callback fails)
+  while (!EG(exception) && (next = php_mrloop_wheel_next(wheel)) != 0 && next <= target)
+  {
+    wheel->now = next;
+
+    for (int level = PHP_MRLOOP_WHEEL_LEVELS - 1; level > 0; level--)
+    {
+      if ((next & ((UINT64_C(1) << (PHP_MRLOOP_WHEEL_BITS * level)) - 1)) == 0)
+      {
+        php_mrloop_wheel_cascade(wheel, level);
+      }
+    }
+
+    php_mrloop_wheel_expire(evloop);
+  }
+
+  if (target > wheel->now)
+  {
+    wheel->now = target;
+  }
+
+  php_mrloop_wheel_arm(evloop);
+}
+static void php_mrloop_wheel_free(php_mrloop_t *evloop)
+{
+  php_mrloop_timer_t *timer, *sibling;
+
+  for (timer = evloop->timers; timer != NULL; timer = sibling)
+  {
+    sibling = timer->sibling;
+
+    timer->evloop = NULL;
+    timer->sibling = NULL;
+    timer->psibling = NULL;
+
+    if (timer->pprev)
+    {
+      php_mrloop_wheel_unlink(timer);
+
+      // during shutdown, the timer may have been released already
+      if (!(OBJ_FLAGS(&timer->std) & IS_OBJ_FREE_CALLED))
+      {
+        OBJ_RELEASE(&timer->std);
+      }
+    }
+  }
+
+  evloop->timers = NULL;
+
+  if (evloop->wheel)
+  {
+    efree(evloop->wheel);
+    evloop->wheel = NULL;
+  }
+}
+static void php_mrloop_timer_schedule(php_mrloop_wheel_t *wheel, php_mrloop_timer_t *timer)
+{
+  timer->expiry = php_mrloop_wheel_clock() + timer->interval;
+
+  // the slot for the time being processed has been detached already
+  if (timer->expiry <= wheel->now)
+  {
+    timer->expiry = wheel->now + 1;
+  }
+
+  php_mrloop_wheel_link(wheel, timer);
+}
+static int php_mrloop_timer_start(php_mrloop_timer_t *timer)
+{
+  php_mrloop_wheel_t *wheel;
+
+  if ((wheel = php_mrloop_wheel(timer->evloop)) == NULL)
+  {
+    return FAILURE;
+  }
+
+  if (timer->pprev)
+  {
+    php_mrloop_wheel_unlink(timer);
+  }
+  else
+  {
+    // the wheel keeps active timers alive whether or not userspace retains their handles
+    GC_ADDREF(&timer->std);
+    wheel->count++;
+  }
+
+  php_mrloop_timer_schedule(wheel, timer);
+
+  // the slot of a timer never comes due after its expiry; later timers need not touch the armed timeout
+  if (!wheel->armed || timer->expiry < wheel->deadline)
+  {
+    php_mrloop_wheel_arm(timer->evloop);
+  }
+
+  return SUCCESS;
+}
+static void php_mrloop_timer_stop(php_mrloop_timer_t *timer)
+{
+  if (timer->pprev == NULL)
+  {
+    return;
+  }
+
+  php_mrloop_wheel_unlink(timer);
+  timer->evloop->wheel->count--;
+
+  // the timeout armed for the timer (if any) fires without effect
+  OBJ_RELEASE(&timer->std);
+}
+static void php_mrloop_timer_add(INTERNAL_FUNCTION_PARAMETERS, bool periodic)
+{
+  zval *obj;
+  double interval;
+  php_mrloop_t *this;
+  php_mrloop_timer_t *timer;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+  obj = getThis();
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_DOUBLE(interval)
+  Z_PARAM_FUNC(fci, fci_cache)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  object_init_ex(return_value, php_mrloop_timer_ce);
+  timer = php_mrloop_timer_from_obj(Z_OBJ_P(return_value));
+
+  timer->evloop = this;
+  timer->interval = interval > 0 ? (uint64_t)(interval * 1000) : 0;
+  timer->periodic = periodic;
+
+  timer->cb = emalloc(sizeof(php_mrloop_cb_t));
+  PHP_CB_TO_MRLOOP_CB(timer->cb, fci, fci_cache);
+
+  timer->sibling = this->timers;
+  if (timer->sibling)
+  {
+    timer->sibling->psibling = &timer->sibling;
+  }
+  timer->psibling = &this->timers;
+  this->timers = timer;
+
+  if (php_mrloop_timer_start(timer) == FAILURE)
+  {
+    zval_ptr_dtor(return_value);
+    ZVAL_NULL(return_value);
+  }
+}
+static void php_mrloop_timer_cancel(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_timer_t *timer;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  timer = php_mrloop_timer_from_obj(Z_OBJ_P(getThis()));
+
+  if (timer->evloop)
+  {
+    php_mrloop_timer_stop(timer);
+  }
+}
+static void php_mrloop_timer_reset(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_timer_t *timer;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  timer = php_mrloop_timer_from_obj(Z_OBJ_P(getThis()));
+
+  if (timer->evloop == NULL)
+  {
+    PHP_MRLOOP_THROW("Timer is not bound to an event loop");
+    return;
+  }
+
+  php_mrloop_timer_start(timer);
+}
+static void php_mrloop_timer_is_active(INTERNAL_FUNCTION_PARAMETERS)
+{
+  php_mrloop_timer_t *timer;
+
+  ZEND_PARSE_PARAMETERS_NONE();
+
+  timer = php_mrloop_timer_from_obj(Z_OBJ_P(getThis()));
+
+  RETURN_BOOL(timer->pprev != NULL);
+}
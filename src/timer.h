@@ -0,0 +1,109 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#define PHP_MRLOOP_WHEEL_LEVELS 4
+#define PHP_MRLOOP_WHEEL_BITS 8
+#define PHP_MRLOOP_WHEEL_SLOTS (1 << PHP_MRLOOP_WHEEL_BITS)
+#define PHP_MRLOOP_WHEEL_MASK (PHP_MRLOOP_WHEEL_SLOTS - 1)
+
+/*
+ * hierarchical timing wheel
+ *
+ * Timers are hashed into one of four wheels of 256 one-millisecond (level 0),
+ * 256-millisecond (level 1), ~65-second (level 2) and ~4.6-hour (level 3)
+ * slots according to how far in the future they expire, which makes arming
+ * and cancelling a timer O(1). Timers in higher levels cascade into lower
+ * ones as their slots come due. The whole wheel is driven by a single
+ * io_uring timeout armed for the earliest slot that requires attention.
+ */
+struct php_mrloop_wheel_t
+{
+  /* timeout operation */
+  php_mrloop_op_t op;
+  /* timer lists (indexed by level and slot) */
+  php_mrloop_timer_t *slots[PHP_MRLOOP_WHEEL_LEVELS][PHP_MRLOOP_WHEEL_SLOTS];
+  /* time (in milliseconds on the monotonic clock) up to which the wheel has been processed */
+  uint64_t now;
+  /* number of active timers */
+  size_t count;
+  /* whether the timeout operation is in flight */
+  bool armed;
+  /* time (in milliseconds on the monotonic clock) at which the timeout operation expires */
+  uint64_t deadline;
+  /* duration of the timeout operation */
+  struct __kernel_timespec ts;
+};
+
+/* userspace-bound timer object */
+struct php_mrloop_timer_t
+{
+  /* event loop in which the timer is subsumed (absent once the loop has been released) */
+  php_mrloop_t *evloop;
+  /* callback invoked upon expiry of the timer */
+  php_mrloop_cb_t *cb;
+  /* interval (in milliseconds) after which the timer expires */
+  uint64_t interval;
+  /* time (in milliseconds on the monotonic clock) at which the timer expires */
+  uint64_t expiry;
+  /* next timer in the same slot */
+  php_mrloop_timer_t *next;
+  /* link that references the timer (slot head or next field of the preceding timer; NULL if inactive) */
+  php_mrloop_timer_t **pprev;
+  /* next timer created in the same event loop */
+  php_mrloop_timer_t *sibling;
+  /* link that references the timer in the list of timers created in the event loop */
+  php_mrloop_timer_t **psibling;
+  /* whether the timer is re-armed upon expiry */
+  bool periodic;
+  /* PHP object */
+  zend_object std;
+};
+
+zend_object_handlers php_mrloop_timer_object_handlers;
+
+static inline php_mrloop_timer_t *php_mrloop_timer_from_obj(zend_object *obj)
+{
+  return (php_mrloop_timer_t *)((char *)obj - XtOffsetOf(php_mrloop_timer_t, std));
+}
+
+/* creates Timer object */
+static zend_object *php_mrloop_timer_create_object(zend_class_entry *ce);
+/* unlinks Timer object from the timing wheel and releases its callback */
+static void php_mrloop_timer_free_object(zend_object *obj);
+/* returns current time on the monotonic clock (in milliseconds) */
+static uint64_t php_mrloop_wheel_clock(void);
+/* allocates the timing wheel of an event loop; returns NULL (after throwing) upon failure */
+static php_mrloop_wheel_t *php_mrloop_wheel(php_mrloop_t *evloop);
+/* links timer into the slot appropriate to its expiry */
+static void php_mrloop_wheel_link(php_mrloop_wheel_t *wheel, php_mrloop_timer_t *timer);
+/* unlinks timer from its slot */
+static void php_mrloop_wheel_unlink(php_mrloop_timer_t *timer);
+/* returns the earliest time at which a slot requires attention (0 if the wheel is empty) */
+static uint64_t php_mrloop_wheel_next(php_mrloop_wheel_t *wheel);
+/* arms (or brings forward) the timeout operation for the earliest slot that requires attention */
+static void php_mrloop_wheel_arm(php_mrloop_t *evloop);
+/* re-hashes the timers in a slot of a higher level into lower levels */
+static void php_mrloop_wheel_cascade(php_mrloop_wheel_t *wheel, int level);
+/* runs callbacks of timers in the level 0 slot for the current time */
+static void php_mrloop_wheel_expire(php_mrloop_t *evloop);
+/* processes the wheel up to the current time upon expiry of the timeout operation */
+static void php_mrloop_wheel_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* releases the timing wheel along with the references it holds to active timers */
+static void php_mrloop_wheel_free(php_mrloop_t *evloop);
+/* links timer into the slot for the current time plus its interval */
+static void php_mrloop_timer_schedule(php_mrloop_wheel_t *wheel, php_mrloop_timer_t *timer);
+/* (re-)arms timer to expire after its interval; returns FAILURE (after throwing) if the wheel cannot be allocated */
+static int php_mrloop_timer_start(php_mrloop_timer_t *timer);
+/* disarms timer and releases the reference held by the wheel */
+static void php_mrloop_timer_stop(php_mrloop_timer_t *timer);
+/* creates timer which expires once or periodically after a specified interval and conveys its handle */
+static void php_mrloop_timer_add(INTERNAL_FUNCTION_PARAMETERS, bool periodic);
+/* cancels timer */
+static void php_mrloop_timer_cancel(INTERNAL_FUNCTION_PARAMETERS);
+/* restarts timer countdown from the current time */
+static void php_mrloop_timer_reset(INTERNAL_FUNCTION_PARAMETERS);
+/* checks whether timer is armed */
+static void php_mrloop_timer_is_active(INTERNAL_FUNCTION_PARAMETERS);
+
+#endif
@@ -0,0 +1,352 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#include "udp.h"
+
+static void php_mrloop_udp_recv(php_mrloop_udp_t *server)
+{
+  struct io_uring_sqe *sqe = php_mrloop_uring_sqe(server->evloop, &server->recv_op);
+
+  if (sqe == NULL)
+  {
+    PHP_MRLOOP_THROW("Could not acquire submission queue entry");
+    return;
+  }
+
+  // a single multishot receive posts a completion for every datagram, each placed in a provided buffer
+  io_uring_prep_recvmsg_multishot(sqe, server->fd, &server->msg, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = server->bgid;
+
+  server->recv_armed = true;
+  php_mrloop_uring_submit(server->evloop);
+}
+static void php_mrloop_udp_recv_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_udp_t *server = (php_mrloop_udp_t *)op->data;
+  struct io_uring_recvmsg_out *out;
+  php_sockaddr_storage_t *addr;
+  unsigned short bid;
+  char *buffer, *payload;
+  size_t length;
+
+  if (!(cqe->flags & IORING_CQE_F_MORE))
+  {
+    server->recv_armed = false;
+  }
+
+  if (cqe->flags & IORING_CQE_F_BUFFER)
+  {
+    bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    buffer = server->buffers + (bid * server->buff_size);
+
+    // truncated datagrams (those larger than a buffer) are dropped
+    if (cqe->res >= 0 &&
+        (out = io_uring_recvmsg_validate(buffer, cqe->res, &server->msg)) != NULL &&
+        !(out->flags & MSG_TRUNC))
+    {
+      payload = (char *)io_uring_recvmsg_payload(out, &server->msg);
+      length = io_uring_recvmsg_payload_length(out, cqe->res, &server->msg);
+
+      if (server->count == 0)
+      {
+        if (server->batch > 1)
+        {
+          array_init_size(&server->datagrams, (uint32_t)server->batch);
+          array_init_size(&server->peers, (uint32_t)server->batch);
+        }
+      }
+
+      addr = &server->addrs[server->count];
+      memset(addr, 0, sizeof(php_sockaddr_storage_t));
+      memcpy(addr, io_uring_recvmsg_name(out), out->namelen < sizeof(php_sockaddr_storage_t) ? out->namelen : sizeof(php_sockaddr_storage_t));
+
+      if (server->batch > 1)
+      {
+        add_next_index_stringl(&server->datagrams, payload, length);
+        add_next_index_str(&server->peers, php_mrloop_udp_peer(addr));
+      }
+      else
+      {
+        ZVAL_STRINGL(&server->datagrams, payload, length);
+        ZVAL_STR(&server->peers, php_mrloop_udp_peer(addr));
+      }
+
+      server->count++;
+    }
+
+    // the payload has been copied; the buffer can be reused straightaway
+    io_uring_buf_ring_add(server->br, buffer, (unsigned)server->buff_size, bid, io_uring_buf_ring_mask((unsigned)server->buff_count), 0);
+    io_uring_buf_ring_advance(server->br, 1);
+
+    if (server->count == server->batch)
+    {
+      php_mrloop_udp_dispatch(server);
+    }
+    else if (server->count > 0 && !server->dispatch_scheduled)
+    {
+      // deliver whatever has been received once this batch of completions is exhausted
+      server->dispatch_scheduled = true;
+      php_mrloop_uring_defer(server->evloop, &server->dispatch_op);
+    }
+  }
+
+  if (cqe->res == -EBADF || cqe->res == -ECANCELED)
+  {
+    return;
+  }
+
+  // all buffers are in use (-ENOBUFS) is transient; anything else (e.g. lack of kernel support) is not
+  if (cqe->res < 0 && cqe->res != -ENOBUFS)
+  {
+    PHP_MRLOOP_THROW(strerror(-cqe->res));
+    return;
+  }
+
+  if (!server->recv_armed)
+  {
+    php_mrloop_udp_recv(server);
+  }
+}
+static void php_mrloop_udp_dispatch_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_udp_t *server = (php_mrloop_udp_t *)op->data;
+
+  server->dispatch_scheduled = false;
+  php_mrloop_udp_dispatch(server);
+}
+static void php_mrloop_udp_dispatch(php_mrloop_udp_t *server)
+{
+  php_mrloop_cb_t *cb = server->cb;
+  zval args[2], result, *reply;
+  zend_ulong idx;
+
+  if (server->count == 0)
+  {
+    return;
+  }
+
+  ZVAL_COPY_VALUE(&args[0], &server->datagrams);
+  ZVAL_COPY_VALUE(&args[1], &server->peers);
+
+  cb->fci.retval = &result;
+  cb->fci.param_count = 2;
+  cb->fci.params = args;
+
+  if (php_mrloop_call(server->evloop, &cb->fci, &cb->fci_cache) == FAILURE)
+  {
+    PHP_MRLOOP_THROW("There is an error in your callback");
+  }
+  else if (Z_TYPE(result) == IS_STRING && server->batch == 1)
+  {
+    php_mrloop_udp_send(server, &server->addrs[0], zend_string_copy(Z_STR(result)));
+  }
+  else if (Z_TYPE(result) == IS_ARRAY && server->batch > 1)
+  {
+    // replies are keyed by the index of the datagram to whose sender they are addressed
+    ZEND_HASH_FOREACH_NUM_KEY_VAL(Z_ARRVAL(result), idx, reply)
+    {
+      if (idx < server->count && Z_TYPE_P(reply) == IS_STRING)
+      {
+        php_mrloop_udp_send(server, &server->addrs[idx], zend_string_copy(Z_STR_P(reply)));
+      }
+    }
+    ZEND_HASH_FOREACH_END();
+  }
+
+  zval_ptr_dtor(&result);
+  zval_ptr_dtor(&server->datagrams);
+  zval_ptr_dtor(&server->peers);
+
+  ZVAL_UNDEF(&server->datagrams);
+  ZVAL_UNDEF(&server->peers);
+  server->count = 0;
+}
+static zend_string *php_mrloop_udp_peer(php_sockaddr_storage_t *addr)
+{
+  char ip_str[INET6_ADDRSTRLEN];
+
+  if (addr->ss_family == AF_INET6)
+  {
+    inet_ntop(AF_INET6, &((php_sockaddr_in6_t *)addr)->sin6_addr, ip_str, INET6_ADDRSTRLEN);
+    return zend_strpprintf(0, "[%s]:%d", ip_str, ntohs(((php_sockaddr_in6_t *)addr)->sin6_port));
+  }
+
+  inet_ntop(AF_INET, &((php_sockaddr_t *)addr)->sin_addr, ip_str, INET6_ADDRSTRLEN);
+  return zend_strpprintf(0, "%s:%d", ip_str, ntohs(((php_sockaddr_t *)addr)->sin_port));
+}
+static void php_mrloop_udp_send(php_mrloop_udp_t *server, php_sockaddr_storage_t *addr, zend_string *data)
+{
+  php_mrloop_dgram_t *dgram;
+  struct io_uring_sqe *sqe;
+
+  dgram = php_mrloop_slab_alloc(server->evloop, sizeof(php_mrloop_dgram_t));
+  dgram->op.handler = php_mrloop_udp_send_cb;
+  dgram->op.data = dgram;
+  dgram->evloop = server->evloop;
+  dgram->data = data;
+  memcpy(&dgram->addr, addr, sizeof(php_sockaddr_storage_t));
+
+  dgram->iov.iov_base = ZSTR_VAL(data);
+  dgram->iov.iov_len = ZSTR_LEN(data);
+
+  memset(&dgram->msg, 0, sizeof(struct msghdr));
+  dgram->msg.msg_name = &dgram->addr;
+  dgram->msg.msg_namelen = addr->ss_family == AF_INET6 ? sizeof(php_sockaddr_in6_t) : sizeof(php_sockaddr_t);
+  dgram->msg.msg_iov = &dgram->iov;
+  dgram->msg.msg_iovlen = 1;
+
+  if ((sqe = php_mrloop_uring_sqe(server->evloop, &dgram->op)) == NULL)
+  {
+    zend_string_release(data);
+    php_mrloop_slab_release(server->evloop, dgram, sizeof(php_mrloop_dgram_t));
+
+    return;
+  }
+
+  // replies are dispatched from within the completion relay, which submits them all at once thereafter
+  io_uring_prep_sendmsg(sqe, server->fd, &dgram->msg, 0);
+}
+static void php_mrloop_udp_send_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_dgram_t *dgram = (php_mrloop_dgram_t *)op->data;
+
+  zend_string_release(dgram->data);
+  php_mrloop_slab_release(dgram->evloop, dgram, sizeof(php_mrloop_dgram_t));
+}
+static void php_mrloop_udp_server_free(php_mrloop_udp_t *server)
+{
+  php_mrloop_uring_t *uring = server->evloop->uring;
+
+  if (uring && server->br)
+  {
+    io_uring_free_buf_ring(&uring->ring, server->br, (unsigned)server->buff_count, server->bgid);
+  }
+
+  close(server->fd);
+  if (server->buffers)
+  {
+    efree(server->buffers);
+  }
+  efree(server->addrs);
+
+  zval_ptr_dtor(&server->datagrams);
+  zval_ptr_dtor(&server->peers);
+
+  PHP_MRLOOP_CB_FREE(server->cb);
+  efree(server);
+}
+static void php_mrloop_udp_server_listen(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+  php_mrloop_udp_t *server;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fci_cache;
+  zend_string *address;
+  zend_long port, batch, buff_count, buff_size;
+  HashTable *options;
+  php_sockaddr_storage_t addr;
+  socklen_t addrlen;
+  size_t entries;
+  int fd, opt;
+
+  obj = getThis();
+  fci = empty_fcall_info;
+  fci_cache = empty_fcall_info_cache;
+  options = NULL;
+
+  ZEND_PARSE_PARAMETERS_START(2, 3)
+  Z_PARAM_STR_OR_LONG(address, port)
+  Z_PARAM_FUNC(fci, fci_cache)
+  Z_PARAM_OPTIONAL
+  Z_PARAM_ARRAY_HT_OR_NULL(options)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if (php_mrloop_tcp_server_address(address, port, &addr, &addrlen) == FAILURE || addr.ss_family == AF_UNIX)
+  {
+    PHP_MRLOOP_THROW("Invalid server address");
+    return;
+  }
+
+  batch = php_mrloop_option_long(options, "batch", 1);
+  buff_count = php_mrloop_option_long(options, "buffer_count", PHP_MRLOOP_UDP_BUFFER_COUNT);
+  buff_size = php_mrloop_option_long(options, "buffer_size", PHP_MRLOOP_UDP_BUFFER_SIZE);
+
+  if (batch < 1 || batch > PHP_MRLOOP_UDP_MAX_BATCH)
+  {
+    PHP_MRLOOP_THROW("Invalid batch size");
+    return;
+  }
+
+  // each buffer also holds the header and source address that precede the payload
+  if (buff_count < 1 || buff_count > PHP_MRLOOP_BUFFER_RING_MAX_COUNT ||
+      buff_size <= (zend_long)(sizeof(struct io_uring_recvmsg_out) + sizeof(php_sockaddr_storage_t)))
+  {
+    PHP_MRLOOP_THROW("Invalid provided buffer ring dimensions");
+    return;
+  }
+
+  // provided buffer rings must have a power-of-two number of entries
+  for (entries = 1; entries < (size_t)buff_count; entries <<= 1)
+    ;
+
+  if (php_mrloop_uring(this) == NULL)
+  {
+    return;
+  }
+
+  if ((fd = socket(addr.ss_family, SOCK_DGRAM | SOCK_CLOEXEC, 0)) < 0)
+  {
+    PHP_MRLOOP_THROW(strerror(errno));
+    return;
+  }
+
+  opt = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+  if (bind(fd, (struct sockaddr *)&addr, addrlen) < 0)
+  {
+    close(fd);
+    PHP_MRLOOP_THROW(strerror(errno));
+
+    return;
+  }
+
+  server = ecalloc(1, sizeof(php_mrloop_udp_t));
+  server->evloop = this;
+  server->fd = fd;
+  server->batch = (size_t)batch;
+  server->buff_count = entries;
+  server->buff_size = (size_t)buff_size;
+  server->addrs = emalloc(server->batch * sizeof(php_sockaddr_storage_t));
+
+  ZVAL_UNDEF(&server->datagrams);
+  ZVAL_UNDEF(&server->peers);
+
+  if ((server->bgid = php_mrloop_uring_buf_ring(this, server->buff_count, server->buff_size, &server->br, &server->buffers)) < 0)
+  {
+    close(fd);
+    efree(server->addrs);
+    efree(server);
+
+    return;
+  }
+
+  server->cb = emalloc(sizeof(php_mrloop_cb_t));
+  PHP_CB_TO_MRLOOP_CB(server->cb, fci, fci_cache);
+  server->cb->data = server;
+
+  // only the source address is of interest; no control messages are requested
+  server->msg.msg_namelen = sizeof(php_sockaddr_storage_t);
+
+  server->recv_op.handler = php_mrloop_udp_recv_cb;
+  server->recv_op.data = server;
+  server->dispatch_op.handler = php_mrloop_udp_dispatch_cb;
+  server->dispatch_op.data = server;
+
+  server->next = this->udp_servers;
+  this->udp_servers = server;
+
+  php_mrloop_udp_recv(server);
+}
@@ -0,0 +1,91 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#ifndef __UDP_H__
+#define __UDP_H__
+
+#define PHP_MRLOOP_UDP_BUFFER_COUNT 256
+#define PHP_MRLOOP_UDP_BUFFER_SIZE 2048
+#define PHP_MRLOOP_UDP_MAX_BATCH 4096
+
+struct php_mrloop_dgram_t;
+typedef struct php_mrloop_dgram_t php_mrloop_dgram_t;
+
+/* UDP server serviced via the extension-managed ring */
+struct php_mrloop_udp_t
+{
+  /* event loop in which the server is subsumed */
+  php_mrloop_t *evloop;
+  /* datagram socket file descriptor */
+  int fd;
+  /* server callback */
+  php_mrloop_cb_t *cb;
+  /* maximum number of datagrams conveyed to each callback invocation (1 conveys them one at a time) */
+  size_t batch;
+  /* datagrams received since the last callback invocation (batch mode only) */
+  zval datagrams;
+  /* textual peer addresses of received datagrams (batch mode only) */
+  zval peers;
+  /* socket addresses of the peers of received datagrams (batch mode only) */
+  php_sockaddr_storage_t *addrs;
+  /* number of datagrams received since the last callback invocation */
+  size_t count;
+  /* receive operation */
+  php_mrloop_op_t recv_op;
+  /* whether the receive operation is in flight */
+  bool recv_armed;
+  /* deferred callback invocation through which partial batches are delivered */
+  php_mrloop_op_t dispatch_op;
+  /* whether the deferred callback invocation is scheduled */
+  bool dispatch_scheduled;
+  /* message header describing the layout of received datagrams */
+  struct msghdr msg;
+  /* provided buffer ring from which the kernel picks receive buffers */
+  struct io_uring_buf_ring *br;
+  /* memory backing the provided buffers */
+  char *buffers;
+  /* number of provided buffers */
+  size_t buff_count;
+  /* size of each receive buffer */
+  size_t buff_size;
+  /* provided buffer group identifier */
+  int bgid;
+  /* next UDP server in event loop */
+  php_mrloop_udp_t *next;
+};
+
+/* reply datagram which retains its payload and destination until the send completes */
+struct php_mrloop_dgram_t
+{
+  /* send operation */
+  php_mrloop_op_t op;
+  /* event loop in which the send is subsumed */
+  php_mrloop_t *evloop;
+  /* payload */
+  zend_string *data;
+  /* destination address */
+  php_sockaddr_storage_t addr;
+  /* message header */
+  struct msghdr msg;
+  /* payload vector */
+  php_iovec_t iov;
+};
+
+/* submits multishot receive operation for UDP server to extension-managed ring */
+static void php_mrloop_udp_recv(php_mrloop_udp_t *server);
+/* processes received datagrams and returns their buffers to the ring */
+static void php_mrloop_udp_recv_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* delivers a partial batch once the current batch of completions has been processed */
+static void php_mrloop_udp_dispatch_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* conveys batched datagrams to the UDP server callback and sends the ensuing replies */
+static void php_mrloop_udp_dispatch(php_mrloop_udp_t *server);
+/* renders a socket address as an address:port string */
+static zend_string *php_mrloop_udp_peer(php_sockaddr_storage_t *addr);
+/* queues a reply datagram (submitted along with the rest of the current batch); takes ownership of the string */
+static void php_mrloop_udp_send(php_mrloop_udp_t *server, php_sockaddr_storage_t *addr, zend_string *data);
+/* releases reply datagram once sent */
+static void php_mrloop_udp_send_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* releases UDP server resources */
+static void php_mrloop_udp_server_free(php_mrloop_udp_t *server);
+/* starts a UDP server */
+static void php_mrloop_udp_server_listen(INTERNAL_FUNCTION_PARAMETERS);
+
+#endif
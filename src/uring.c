@@ -0,0 +1,667 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#include "uring.h"
+
+static int php_mrloop_uring_configure(php_mrloop_uring_setup_t *setup, HashTable *options)
+{
+  zval *sqpoll;
+  zend_long entries, cq_entries, idle, cpu;
+
+  entries = php_mrloop_option_long(options, "entries", PHP_MRLOOP_URING_ENTRIES);
+  cq_entries = php_mrloop_option_long(options, "cq_entries", 0);
+
+  if (entries < 1 || entries > PHP_MRLOOP_URING_MAX_ENTRIES || (cq_entries != 0 && (cq_entries < entries || cq_entries > 2 * PHP_MRLOOP_URING_MAX_ENTRIES)))
+  {
+    PHP_MRLOOP_THROW("Queue depths must be between 1 and 32768 (65536 for a completion queue no shallower than the submission queue)");
+    return FAILURE;
+  }
+
+  setup->entries = (unsigned)entries;
+  setup->cq_entries = (unsigned)cq_entries;
+  setup->flags = cq_entries > 0 ? IORING_SETUP_CQSIZE : 0;
+
+  // SQPOLL is either enabled outright or configured with an idle time and a CPU to pin the polling thread to
+  if ((sqpoll = zend_hash_str_find(options, "sqpoll", sizeof("sqpoll") - 1)) != NULL && (Z_TYPE_P(sqpoll) == IS_ARRAY || zend_is_true(sqpoll)))
+  {
+    idle = php_mrloop_option_long(Z_TYPE_P(sqpoll) == IS_ARRAY ? Z_ARRVAL_P(sqpoll) : NULL, "idle", PHP_MRLOOP_URING_SQ_THREAD_IDLE);
+    cpu = php_mrloop_option_long(Z_TYPE_P(sqpoll) == IS_ARRAY ? Z_ARRVAL_P(sqpoll) : NULL, "cpu", -1);
+
+    if (idle < 0 || idle > UINT_MAX || cpu < -1 || cpu > INT_MAX)
+    {
+      PHP_MRLOOP_THROW("SQPOLL idle time and CPU must be non-negative");
+      return FAILURE;
+    }
+
+    setup->flags |= IORING_SETUP_SQPOLL;
+    setup->sq_thread_idle = (unsigned)idle;
+
+    if (cpu > -1)
+    {
+      setup->flags |= IORING_SETUP_SQ_AFF;
+      setup->sq_thread_cpu = (unsigned)cpu;
+    }
+  }
+
+  if (php_mrloop_option_bool(options, "single_issuer", false))
+  {
+    setup->flags |= IORING_SETUP_SINGLE_ISSUER;
+  }
+
+  // DEFER_TASKRUN posts completions only when the ring itself is waited on, which the eventfd relay never does
+  if (php_mrloop_option_bool(options, "coop_taskrun", false) || php_mrloop_option_bool(options, "defer_taskrun", false))
+  {
+    setup->flags |= IORING_SETUP_COOP_TASKRUN;
+  }
+
+  return SUCCESS;
+}
+static int php_mrloop_uring_init(php_mrloop_uring_t *uring, php_mrloop_uring_setup_t *setup)
+{
+  // flags are shed, newest first, until the kernel accepts those that remain
+  static const unsigned shed[] = {IORING_SETUP_SINGLE_ISSUER, IORING_SETUP_COOP_TASKRUN, IORING_SETUP_SQ_AFF, IORING_SETUP_SQPOLL, IORING_SETUP_CQSIZE};
+  struct io_uring_params params;
+  unsigned flags;
+  size_t idx;
+  int ret;
+
+  flags = setup->flags;
+  idx = 0;
+
+  for (;;)
+  {
+    memset(&params, 0, sizeof(struct io_uring_params));
+    params.flags = flags;
+    params.cq_entries = setup->cq_entries;
+    params.sq_thread_idle = setup->sq_thread_idle;
+    params.sq_thread_cpu = setup->sq_thread_cpu;
+
+    // older kernels reject unknown flags with EINVAL and unprivileged SQPOLL with EPERM
+    if ((ret = io_uring_queue_init_params(setup->entries, &uring->ring, &params)) != -EINVAL && ret != -EPERM)
+    {
+      break;
+    }
+
+    while (idx < sizeof(shed) / sizeof(shed[0]) && (flags & shed[idx]) == 0)
+    {
+      idx++;
+    }
+
+    if (idx == sizeof(shed) / sizeof(shed[0]))
+    {
+      break;
+    }
+
+    flags &= ~shed[idx];
+  }
+
+  uring->flags = ret == 0 ? flags : 0;
+
+  return ret;
+}
+static void php_mrloop_uring_arm(php_mrloop_t *evloop)
+{
+  php_mrloop_uring_t *uring = evloop->uring;
+
+  uring->iov.iov_base = &uring->counter;
+  uring->iov.iov_len = sizeof(uint64_t);
+
+  mr_readvcb(evloop->loop, uring->efd, &uring->iov, 1, 0, evloop, php_mrloop_uring_eventfd_cb);
+  php_mrloop_mr_submit(evloop);
+}
+static php_mrloop_uring_t *php_mrloop_uring(php_mrloop_t *evloop)
+{
+  php_mrloop_uring_t *uring;
+  int ret;
+
+  if (evloop->uring)
+  {
+    return evloop->uring;
+  }
+
+  uring = ecalloc(1, sizeof(php_mrloop_uring_t));
+
+  if ((ret = php_mrloop_uring_init(uring, &evloop->uring_setup)) < 0)
+  {
+    efree(uring);
+    PHP_MRLOOP_THROW(strerror(-ret));
+
+    return NULL;
+  }
+
+  // the eventfd must remain blocking so that io_uring arms a poll for the relay read
+  if ((uring->efd = eventfd(0, EFD_CLOEXEC)) < 0)
+  {
+    io_uring_queue_exit(&uring->ring);
+    efree(uring);
+    PHP_MRLOOP_THROW(strerror(errno));
+
+    return NULL;
+  }
+
+  if ((ret = io_uring_register_eventfd(&uring->ring, uring->efd)) < 0)
+  {
+    close(uring->efd);
+    io_uring_queue_exit(&uring->ring);
+    efree(uring);
+    PHP_MRLOOP_THROW(strerror(-ret));
+
+    return NULL;
+  }
+
+  evloop->uring = uring;
+  php_mrloop_uring_arm(evloop);
+
+  return uring;
+}
+static struct io_uring_sqe *php_mrloop_uring_sqe(php_mrloop_t *evloop, php_mrloop_op_t *op)
+{
+  struct io_uring_sqe *sqe;
+
+  if ((sqe = io_uring_get_sqe(&evloop->uring->ring)) == NULL)
+  {
+    // submission queue is full; flush it and try again
+    PHP_MRLOOP_STATS_SUBMIT(evloop, io_uring_submit(&evloop->uring->ring));
+    sqe = io_uring_get_sqe(&evloop->uring->ring);
+  }
+
+  if (sqe)
+  {
+    io_uring_sqe_set_data(sqe, op);
+  }
+
+  if (sqe && op)
+  {
+    PHP_MRLOOP_STATS_STAMP(evloop, op);
+  }
+
+  return sqe;
+}
+static int php_mrloop_uring_buf_ring(php_mrloop_t *evloop, size_t count, size_t size, struct io_uring_buf_ring **br, char **buffers)
+{
+  php_mrloop_uring_t *uring = evloop->uring;
+  int bgid, ret, mask;
+
+  bgid = uring->bgid++;
+
+  // the kernel picks buffers from this ring only when data arrives on a socket
+  if ((*br = io_uring_setup_buf_ring(&uring->ring, (unsigned)count, bgid, 0, &ret)) == NULL)
+  {
+    PHP_MRLOOP_THROW(strerror(-ret));
+
+    return -1;
+  }
+
+  *buffers = emalloc(count * size);
+  mask = io_uring_buf_ring_mask((unsigned)count);
+
+  for (size_t idx = 0; idx < count; idx++)
+  {
+    io_uring_buf_ring_add(*br, *buffers + (idx * size), (unsigned)size, (unsigned short)idx, mask, (int)idx);
+  }
+  io_uring_buf_ring_advance(*br, (int)count);
+
+  return bgid;
+}
+static void php_mrloop_uring_defer(php_mrloop_t *evloop, php_mrloop_op_t *op)
+{
+  php_mrloop_uring_t *uring = evloop->uring;
+
+  if (uring->ndeferred == uring->deferred_cap)
+  {
+    uring->deferred_cap = uring->deferred_cap == 0 ? 8 : uring->deferred_cap * 2;
+    uring->deferred = erealloc(uring->deferred, uring->deferred_cap * sizeof(php_mrloop_op_t *));
+  }
+
+  uring->deferred[uring->ndeferred++] = op;
+}
+static void php_mrloop_uring_submit(php_mrloop_t *evloop)
+{
+  // entries queued in a batch are submitted together once the batch ends
+  if (evloop->batch == 0 && evloop->uring && io_uring_sq_ready(&evloop->uring->ring) > 0)
+  {
+    PHP_MRLOOP_STATS_SUBMIT(evloop, io_uring_submit(&evloop->uring->ring));
+  }
+}
+static void php_mrloop_uring_eventfd_cb(void *data, int res)
+{
+  php_mrloop_t *evloop = (php_mrloop_t *)data;
+  php_mrloop_uring_t *uring = evloop->uring;
+  struct io_uring_cqe *cqe;
+  php_mrloop_op_t *op;
+  php_cqe_t next;
+  size_t reaped = 0;
+
+  if (uring == NULL)
+  {
+    return;
+  }
+
+  // operations issued by handlers are submitted once the whole batch of completions has been processed
+  php_mrloop_batch_begin(evloop);
+
+  while (io_uring_peek_cqe(&uring->ring, &cqe) == 0)
+  {
+    // copy the entry so that handlers are free to submit (and reap) further operations
+    memcpy(&next, cqe, sizeof(php_cqe_t));
+    io_uring_cqe_seen(&uring->ring, cqe);
+
+    op = (php_mrloop_op_t *)io_uring_cqe_get_data(&next);
+
+    if (op && op->handler)
+    {
+      PHP_MRLOOP_STATS_COMPLETE(evloop, op, &next);
+      op->handler(op, &next);
+    }
+    reaped++;
+  }
+
+  PHP_MRLOOP_STATS_COUNT(evloop, completions, reaped);
+  PHP_MRLOOP_STATS_RECORD(evloop, batch, reaped);
+
+  // handlers may defer further operations; those run in this pass as well
+  for (size_t idx = 0; idx < uring->ndeferred; idx++)
+  {
+    op = uring->deferred[idx];
+    op->handler(op, NULL);
+  }
+  uring->ndeferred = 0;
+
+  php_mrloop_batch_end(evloop);
+  php_mrloop_uring_arm(evloop);
+}
+static int php_mrloop_uring_fixed_file(php_mrloop_t *evloop, int fd)
+{
+  php_mrloop_uring_t *uring = evloop->uring;
+  int slot;
+
+  if (uring == NULL || fd < 0 || (size_t)fd >= uring->nslots || (slot = uring->slots[fd]) < 0)
+  {
+    return -1;
+  }
+
+  // a reference keeps registered streams open, but fclose() closes a stream regardless; its descriptor may since have
+  // been reused
+  if (uring->files[slot].res != NULL && uring->files[slot].res->type < 0)
+  {
+    php_mrloop_uring_release_file(evloop, fd);
+    return -1;
+  }
+
+  return slot;
+}
+static int php_mrloop_uring_release_file(php_mrloop_t *evloop, int fd)
+{
+  php_mrloop_uring_t *uring = evloop->uring;
+  php_mrloop_uring_file_t *file;
+  int slot, empty = -1;
+
+  if (uring == NULL || fd < 0 || (size_t)fd >= uring->nslots || (slot = uring->slots[fd]) < 0)
+  {
+    return SUCCESS;
+  }
+
+  // the descriptor no longer maps to the slot either way; should the kernel not clear the latter, it stays bound to the
+  // old file (and the stream referenced) until the set is next replaced
+  uring->slots[fd] = -1;
+  if (io_uring_register_files_update(&uring->ring, (unsigned)slot, &empty, 1) < 0)
+  {
+    return FAILURE;
+  }
+
+  file = &uring->files[slot];
+  file->fd = -1;
+  if (file->res)
+  {
+    zend_list_delete(file->res);
+    file->res = NULL;
+  }
+
+  return SUCCESS;
+}
+static bool php_mrloop_uring_readv(php_mrloop_t *evloop, int fd, php_iovec_t *iov, size_t iovcnt, int64_t offset, void *data, void (*cb)(void *data, int res))
+{
+  php_mrloop_io_t *io;
+  struct io_uring_sqe *sqe;
+  int slot;
+
+  if ((slot = php_mrloop_uring_fixed_file(evloop, fd)) < 0)
+  {
+    return false;
+  }
+
+  io = php_mrloop_slab_alloc(evloop, sizeof(php_mrloop_io_t));
+  io->op.handler = php_mrloop_uring_io_cb;
+  io->op.data = io;
+  io->evloop = evloop;
+  io->cb = cb;
+  io->data = data;
+  io->buf_index = -1;
+
+  if ((sqe = php_mrloop_uring_sqe(evloop, &io->op)) == NULL)
+  {
+    php_mrloop_slab_release(evloop, io, sizeof(php_mrloop_io_t));
+    cb(data, -EBUSY);
+
+    return true;
+  }
+
+  // reads land directly in the strings conveyed to userspace; only the descriptor lookup is saved
+  io_uring_prep_readv(sqe, slot, iov, (unsigned)iovcnt, (__u64)offset);
+  sqe->flags |= IOSQE_FIXED_FILE;
+
+  php_mrloop_uring_submit(evloop);
+
+  return true;
+}
+static bool php_mrloop_uring_writev(php_mrloop_t *evloop, int fd, php_iovec_t *iov, size_t iovcnt, void *data, void (*cb)(void *data, int res))
+{
+  php_mrloop_uring_t *uring = evloop->uring;
+  php_mrloop_io_t *io;
+  struct io_uring_sqe *sqe;
+  size_t nbytes;
+  char *buffer;
+  int slot;
+
+  if ((slot = php_mrloop_uring_fixed_file(evloop, fd)) < 0)
+  {
+    return false;
+  }
+
+  io = php_mrloop_slab_alloc(evloop, sizeof(php_mrloop_io_t));
+  io->op.handler = php_mrloop_uring_io_cb;
+  io->op.data = io;
+  io->evloop = evloop;
+  io->cb = cb;
+  io->data = data;
+  io->buf_index = -1;
+
+  if ((sqe = php_mrloop_uring_sqe(evloop, &io->op)) == NULL)
+  {
+    php_mrloop_slab_release(evloop, io, sizeof(php_mrloop_io_t));
+    cb(data, -EBUSY);
+
+    return true;
+  }
+
+  nbytes = 0;
+  for (size_t idx = 0; idx < iovcnt; idx++)
+  {
+    nbytes += iov[idx].iov_len;
+  }
+
+  // small writes are gathered into a fixed buffer, whose pages the kernel need not pin anew
+  if (uring->nidle > 0 && nbytes <= uring->buff_size)
+  {
+    io->buf_index = uring->idle[--uring->nidle];
+    buffer = uring->buffers + ((size_t)io->buf_index * uring->buff_size);
+
+    nbytes = 0;
+    for (size_t idx = 0; idx < iovcnt; idx++)
+    {
+      memcpy(buffer + nbytes, iov[idx].iov_base, iov[idx].iov_len);
+      nbytes += iov[idx].iov_len;
+    }
+
+    io_uring_prep_write_fixed(sqe, slot, buffer, (unsigned)nbytes, (__u64)-1, io->buf_index);
+  }
+  else
+  {
+    io_uring_prep_writev(sqe, slot, iov, (unsigned)iovcnt, (__u64)-1);
+  }
+  sqe->flags |= IOSQE_FIXED_FILE;
+
+  php_mrloop_uring_submit(evloop);
+
+  return true;
+}
+static void php_mrloop_uring_io_cb(php_mrloop_op_t *op, php_cqe_t *cqe)
+{
+  php_mrloop_io_t *io = (php_mrloop_io_t *)op->data;
+  php_mrloop_uring_t *uring = io->evloop->uring;
+
+  if (io->buf_index > -1 && uring && (size_t)io->buf_index < uring->buff_count)
+  {
+    uring->idle[uring->nidle++] = io->buf_index;
+  }
+
+  io->cb(io->data, cqe->res);
+  php_mrloop_slab_release(io->evloop, io, sizeof(php_mrloop_io_t));
+}
+static void php_mrloop_register_files(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj, *file;
+  php_mrloop_t *this;
+  php_mrloop_uring_t *uring;
+  HashTable *files;
+  php_stream *stream;
+  php_mrloop_uring_file_t *entries;
+  zend_resource *res;
+  int *fds, fd, ret;
+  size_t count, idx, nslots;
+
+  obj = getThis();
+
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+  Z_PARAM_ARRAY_HT(files)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if ((uring = php_mrloop_uring(this)) == NULL)
+  {
+    return;
+  }
+
+  count = zend_hash_num_elements(files);
+  if (count > PHP_MRLOOP_URING_MAX_FILES)
+  {
+    PHP_MRLOOP_THROW("At most 1024 files may be registered");
+    return;
+  }
+
+  fds = count > 0 ? emalloc(count * sizeof(int)) : NULL;
+  entries = count > 0 ? emalloc(count * sizeof(php_mrloop_uring_file_t)) : NULL;
+  nslots = 0;
+  idx = 0;
+
+  ZEND_HASH_FOREACH_VAL(files, file)
+  {
+    fd = -1;
+    res = NULL;
+
+    if (Z_TYPE_P(file) == IS_LONG)
+    {
+      fd = (int)Z_LVAL_P(file);
+    }
+    else if (Z_TYPE_P(file) == IS_RESOURCE &&
+             (stream = (php_stream *)zend_fetch_resource_ex(file, NULL, php_file_le_stream())) != NULL &&
+             php_stream_cast(stream, PHP_STREAM_AS_FD | PHP_STREAM_CAST_INTERNAL, (void *)&fd, 1) == FAILURE)
+    {
+      fd = -1;
+    }
+    else if (Z_TYPE_P(file) == IS_RESOURCE)
+    {
+      res = Z_RES_P(file);
+    }
+
+    if (fd < 0 || fcntl(fd, F_GETFD) < 0)
+    {
+      if (fds)
+      {
+        efree(fds);
+        efree(entries);
+      }
+      PHP_MRLOOP_THROW("Detected invalid file descriptor");
+
+      return;
+    }
+
+    entries[idx].fd = fd;
+    entries[idx].res = res;
+    fds[idx++] = fd;
+
+    if ((size_t)fd >= nslots)
+    {
+      nslots = (size_t)fd + 1;
+    }
+  }
+  ZEND_HASH_FOREACH_END();
+
+  // the set is replaced wholesale; operations in flight retain references to the files they target
+  if (uring->nfiles > 0)
+  {
+    io_uring_unregister_files(&uring->ring);
+    php_mrloop_uring_files_free(uring);
+  }
+
+  if (count == 0)
+  {
+    return;
+  }
+
+  ret = io_uring_register_files(&uring->ring, fds, (unsigned)count);
+  efree(fds);
+
+  if (ret < 0)
+  {
+    efree(entries);
+    PHP_MRLOOP_THROW(strerror(-ret));
+
+    return;
+  }
+
+  // descriptors are looked up on every read and write; a table indexed by descriptor spares a scan
+  uring->slots = emalloc(nslots * sizeof(int));
+  memset(uring->slots, -1, nslots * sizeof(int));
+  for (idx = 0; idx < count; idx++)
+  {
+    uring->slots[entries[idx].fd] = (int)idx;
+    // registered streams are kept open (save for an explicit fclose()) so their descriptors are not reused
+    if (entries[idx].res)
+    {
+      GC_ADDREF(entries[idx].res);
+    }
+  }
+
+  uring->files = entries;
+  uring->nfiles = count;
+  uring->nslots = nslots;
+}
+static void php_mrloop_register_buffers(INTERNAL_FUNCTION_PARAMETERS)
+{
+  zval *obj;
+  php_mrloop_t *this;
+  php_mrloop_uring_t *uring;
+  php_iovec_t *iov;
+  zend_long count, size;
+  int ret;
+
+  obj = getThis();
+
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+  Z_PARAM_LONG(count)
+  Z_PARAM_LONG(size)
+  ZEND_PARSE_PARAMETERS_END();
+
+  this = PHP_MRLOOP_OBJ(obj);
+
+  if ((uring = php_mrloop_uring(this)) == NULL)
+  {
+    return;
+  }
+
+  if (count < 0 || count > PHP_MRLOOP_URING_MAX_BUFFERS || size < 1 || size > 1073741824)
+  {
+    PHP_MRLOOP_THROW("Buffer count must be between 0 and 1024 and buffer size between 1 byte and 1GB");
+    return;
+  }
+
+  // buffers still in use by writes in flight prevent their replacement
+  if (uring->nidle < uring->buff_count)
+  {
+    PHP_MRLOOP_THROW("Fixed buffers are in use");
+    return;
+  }
+
+  if (uring->buff_count > 0)
+  {
+    io_uring_unregister_buffers(&uring->ring);
+    efree(uring->buffers);
+    efree(uring->idle);
+    uring->buffers = NULL;
+    uring->idle = NULL;
+    uring->buff_count = 0;
+    uring->nidle = 0;
+  }
+
+  if (count == 0)
+  {
+    return;
+  }
+
+  uring->buffers = emalloc((size_t)count * (size_t)size);
+  uring->idle = emalloc((size_t)count * sizeof(int));
+  iov = emalloc((size_t)count * sizeof(php_iovec_t));
+
+  for (zend_long idx = 0; idx < count; idx++)
+  {
+    iov[idx].iov_base = uring->buffers + (idx * size);
+    iov[idx].iov_len = (size_t)size;
+    uring->idle[idx] = (int)(count - idx - 1);
+  }
+
+  ret = io_uring_register_buffers(&uring->ring, iov, (unsigned)count);
+  efree(iov);
+
+  if (ret < 0)
+  {
+    efree(uring->buffers);
+    efree(uring->idle);
+    uring->buffers = NULL;
+    uring->idle = NULL;
+    PHP_MRLOOP_THROW(strerror(-ret));
+
+    return;
+  }
+
+  uring->buff_count = (size_t)count;
+  uring->buff_size = (size_t)size;
+  uring->nidle = (size_t)count;
+}
+static void php_mrloop_uring_files_free(php_mrloop_uring_t *uring)
+{
+  if (uring->files == NULL)
+  {
+    return;
+  }
+
+  for (size_t idx = 0; idx < uring->nfiles; idx++)
+  {
+    if (uring->files[idx].res)
+    {
+      zend_list_delete(uring->files[idx].res);
+    }
+  }
+
+  efree(uring->files);
+  efree(uring->slots);
+  uring->files = NULL;
+  uring->slots = NULL;
+  uring->nfiles = 0;
+  uring->nslots = 0;
+}
+static void php_mrloop_uring_free(php_mrloop_uring_t *uring)
+{
+  io_uring_queue_exit(&uring->ring);
+  close(uring->efd);
+  if (uring->deferred)
+  {
+    efree(uring->deferred);
+  }
+  php_mrloop_uring_files_free(uring);
+  if (uring->buffers)
+  {
+    efree(uring->buffers);
+    efree(uring->idle);
+  }
+  efree(uring);
+}
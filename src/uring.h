@@ -0,0 +1,175 @@
+/* mrloop extension for PHP (c) 2024 Lochemem Bruno Michael */
+#ifndef __URING_H__
+#define __URING_H__
+
+#include "sys/eventfd.h"
+
+#define PHP_MRLOOP_URING_ENTRIES 4096
+#define PHP_MRLOOP_URING_MAX_ENTRIES 32768
+#define PHP_MRLOOP_URING_SQ_THREAD_IDLE 1000
+
+#define PHP_MRLOOP_URING_MAX_FILES 1024
+#define PHP_MRLOOP_URING_MAX_BUFFERS 1024
+
+/* setup flags unknown to older liburing versions are never requested */
+#ifndef IORING_SETUP_COOP_TASKRUN
+#define IORING_SETUP_COOP_TASKRUN 0
+#endif
+#ifndef IORING_SETUP_SINGLE_ISSUER
+#define IORING_SETUP_SINGLE_ISSUER 0
+#endif
+
+struct php_mrloop_uring_t;
+struct php_mrloop_uring_setup_t;
+struct php_mrloop_op_t;
+struct php_mrloop_io_t;
+struct php_mrloop_uring_file_t;
+typedef struct php_mrloop_uring_t php_mrloop_uring_t;
+typedef struct php_mrloop_uring_setup_t php_mrloop_uring_setup_t;
+typedef struct php_mrloop_op_t php_mrloop_op_t;
+typedef struct php_mrloop_io_t php_mrloop_io_t;
+typedef struct php_mrloop_uring_file_t php_mrloop_uring_file_t;
+
+typedef struct io_uring_cqe php_cqe_t;
+
+/* handler invoked upon completion of an operation submitted to the extension-managed ring */
+typedef void (*php_mrloop_op_handler)(php_mrloop_op_t *op, php_cqe_t *cqe);
+
+/*
+ * extension-managed io_uring instance
+ *
+ * mrloop does not expose its ring. Operations that require features the
+ * library does not wrap (provided buffers, multishot requests and the like)
+ * are therefore submitted to this ring, whose completions are relayed to the
+ * mrloop ring via a registered eventfd.
+ */
+struct php_mrloop_uring_t
+{
+  /* io_uring instance */
+  struct io_uring ring;
+  /* setup flags with which the ring was created (those the kernel rejected excluded) */
+  unsigned flags;
+  /* eventfd signalled by the kernel upon posting of completions */
+  int efd;
+  /* eventfd counter */
+  uint64_t counter;
+  /* eventfd read vector */
+  php_iovec_t iov;
+  /* next available provided buffer group identifier */
+  int bgid;
+  /* operations whose handlers run once the current batch of completions has been processed */
+  php_mrloop_op_t **deferred;
+  /* number of deferred operations */
+  size_t ndeferred;
+  /* capacity of deferred operation list */
+  size_t deferred_cap;
+  /* registered files (indexed by fixed file slot) */
+  php_mrloop_uring_file_t *files;
+  /* number of registered files */
+  size_t nfiles;
+  /* fixed file slots (indexed by file descriptor, -1 if the descriptor is not registered) */
+  int *slots;
+  /* number of entries in fixed file slot table (highest registered descriptor plus one) */
+  size_t nslots;
+  /* memory backing the registered (fixed) buffers */
+  char *buffers;
+  /* number of fixed buffers */
+  size_t buff_count;
+  /* size of each fixed buffer */
+  size_t buff_size;
+  /* indices of idle fixed buffers */
+  int *idle;
+  /* number of idle fixed buffers */
+  size_t nidle;
+};
+
+/* file registered with the extension-managed ring */
+struct php_mrloop_uring_file_t
+{
+  /* file descriptor (-1 once its slot is cleared) */
+  int fd;
+  /* stream to which the descriptor belongs (NULL if it was registered by number) */
+  zend_resource *res;
+};
+
+/* setup of the extension-managed ring (as requested via Mrloop::init()) */
+struct php_mrloop_uring_setup_t
+{
+  /* submission queue depth */
+  unsigned entries;
+  /* completion queue depth (0 for twice the submission queue depth) */
+  unsigned cq_entries;
+  /* requested setup flags (IORING_SETUP_*) */
+  unsigned flags;
+  /* milliseconds for which the kernel polling thread idles before it sleeps (SQPOLL only) */
+  unsigned sq_thread_idle;
+  /* CPU to which the kernel polling thread is pinned (SQPOLL with SQ_AFF only) */
+  unsigned sq_thread_cpu;
+};
+
+/* operation submitted to the extension-managed ring */
+struct php_mrloop_op_t
+{
+  /* completion handler */
+  php_mrloop_op_handler handler;
+  /* arbitrary data relevant to operation */
+  void *data;
+#ifdef HAVE_MRLOOP_STATS
+  /* time at which the operation was submitted (or last completed, if it is multishot) */
+  uint64_t stamp;
+#endif
+};
+
+/* vectorized read or write on a registered file which reports its result to an mrloop-style callback */
+struct php_mrloop_io_t
+{
+  /* read or write operation */
+  php_mrloop_op_t op;
+  /* event loop in which the operation is subsumed */
+  php_mrloop_t *evloop;
+  /* mrloop-style completion callback */
+  void (*cb)(void *data, int res);
+  /* data conveyed to completion callback */
+  void *data;
+  /* fixed buffer in use (-1 if none) */
+  int buf_index;
+};
+
+/* validates ring setup options; returns FAILURE (after throwing) if one is invalid */
+static int php_mrloop_uring_configure(php_mrloop_uring_setup_t *setup, HashTable *options);
+/* creates io_uring instance with the requested setup, shedding flags the kernel rejects; returns a negated errno upon failure */
+static int php_mrloop_uring_init(php_mrloop_uring_t *uring, php_mrloop_uring_setup_t *setup);
+/* arms eventfd read through which extension-managed ring completions are relayed to mrloop */
+static void php_mrloop_uring_arm(php_mrloop_t *evloop);
+/* returns the extension-managed ring of an event loop (initializing it if necessary) */
+static php_mrloop_uring_t *php_mrloop_uring(php_mrloop_t *evloop);
+/* retrieves submission queue entry bound to specified operation from extension-managed ring */
+static struct io_uring_sqe *php_mrloop_uring_sqe(php_mrloop_t *evloop, php_mrloop_op_t *op);
+/* registers a provided buffer ring of the specified dimensions; returns its group identifier (or -1 upon failure) */
+static int php_mrloop_uring_buf_ring(php_mrloop_t *evloop, size_t count, size_t size, struct io_uring_buf_ring **br, char **buffers);
+/* schedules handler of an operation to run (sans completion) once the current batch of completions has been processed */
+static void php_mrloop_uring_defer(php_mrloop_t *evloop, php_mrloop_op_t *op);
+/* submits queued submission queue entries in extension-managed ring (unless a batch is open) */
+static void php_mrloop_uring_submit(php_mrloop_t *evloop);
+/* mrloop-bound callback through which extension-managed ring completions are processed */
+static void php_mrloop_uring_eventfd_cb(void *data, int res);
+/* returns the fixed file slot of a registered file descriptor (or -1 if the descriptor is not registered or its stream has been closed) */
+static int php_mrloop_uring_fixed_file(php_mrloop_t *evloop, int fd);
+/* drops the registration of a file descriptor which is about to be closed; returns FAILURE if its slot could not be cleared */
+static int php_mrloop_uring_release_file(php_mrloop_t *evloop, int fd);
+/* issues a vectorized read on a registered file via the extension-managed ring; returns false if the descriptor is not registered */
+static bool php_mrloop_uring_readv(php_mrloop_t *evloop, int fd, php_iovec_t *iov, size_t iovcnt, int64_t offset, void *data, void (*cb)(void *data, int res));
+/* issues a vectorized write on a registered file (from a fixed buffer, if one fits) via the extension-managed ring; returns false if the descriptor is not registered */
+static bool php_mrloop_uring_writev(php_mrloop_t *evloop, int fd, php_iovec_t *iov, size_t iovcnt, void *data, void (*cb)(void *data, int res));
+/* conveys the result of a read or write on a registered file to its callback */
+static void php_mrloop_uring_io_cb(php_mrloop_op_t *op, php_cqe_t *cqe);
+/* registers a set of file descriptors with the extension-managed ring (replacing those registered before) */
+static void php_mrloop_register_files(INTERNAL_FUNCTION_PARAMETERS);
+/* registers a pool of fixed buffers with the extension-managed ring (replacing that registered before) */
+static void php_mrloop_register_buffers(INTERNAL_FUNCTION_PARAMETERS);
+/* releases registered files along with the references held to their streams */
+static void php_mrloop_uring_files_free(php_mrloop_uring_t *uring);
+/* releases extension-managed ring */
+static void php_mrloop_uring_free(php_mrloop_uring_t *uring);
+
+#endif
@@ -34,8 +34,9 @@ $loop->addTimer(
 
 $loop->addSignal(
   (\defined('SIGINT') ? SIGINT : 2),
-  function () {
+  function () use ($loop) {
     echo "Terminated with SIGINT\n";
+    $loop->stop();
   },
 );
 
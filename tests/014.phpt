@@ -0,0 +1,55 @@
+--TEST--
+tcpServer() reads client data into a shared provided buffer ring
+--SKIPIF--
+<?php
+
+if (\version_compare(\php_uname('r'), '6.0', '<')) {
+  echo 'skip';
+}
+
+?>
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->tcpServer(
+  8521,
+  null,
+  null,
+  function (string $message, Connection $conn) {
+    return \strtoupper($message);
+  },
+  [
+    'buffer_ring'  => true,
+    'buffer_count' => 4,
+    'buffer_size'  => 64,
+  ],
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8521');
+    \fwrite($client, 'hello');
+
+    $loop->addTimer(
+      0.5,
+      function () use ($client, $loop) {
+        var_dump(\fread($client, 64));
+
+        \fclose($client);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+string(5) "HELLO"
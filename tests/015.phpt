@@ -0,0 +1,42 @@
+--TEST--
+tcpServer() issues callback-defined responses to clients
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->tcpServer(
+  8522,
+  null,
+  null,
+  function (string $message, Connection $conn) {
+    return \sprintf("%s:%s", $conn->remoteAddress(), \strrev($message));
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8522');
+    \fwrite($client, 'foo');
+
+    $loop->addTimer(
+      0.5,
+      function () use ($client, $loop) {
+        var_dump(\fread($client, 64));
+
+        \fclose($client);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+string(13) "127.0.0.1:oof"
@@ -0,0 +1,62 @@
+--TEST--
+httpServer() parses pipelined requests natively and serializes callback-defined responses
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->httpServer(
+  8523,
+  null,
+  null,
+  function (array $request) {
+    if ($request['path'] === '/json') {
+      return [
+        'status'  => 201,
+        'headers' => ['Content-Type' => 'application/json'],
+        'body'    => \json_encode([$request['method'], $request['headers']['x-foo'], $request['body']]),
+      ];
+    }
+
+    return \sprintf('%s %s', $request['method'], $request['path']);
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8523');
+    \fwrite(
+      $client,
+      "GET /foo HTTP/1.1\r\nHost: localhost\r\n\r\n" .
+      "POST /json HTTP/1.1\r\nHost: localhost\r\nX-Foo: bar\r\nContent-Length: 3\r\nConnection: close\r\n\r\nbaz",
+    );
+
+    $loop->addTimer(
+      0.5,
+      function () use ($client, $loop) {
+        echo \stream_get_contents($client);
+
+        \fclose($client);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+HTTP/1.1 200 OK
+Content-Type: text/html; charset=UTF-8
+Content-Length: 8
+
+GET /fooHTTP/1.1 201 Created
+Content-Type: application/json
+Content-Length: 20
+Connection: close
+
+["POST","bar","baz"]
@@ -0,0 +1,63 @@
+--TEST--
+tcpServer() conveys the same Connection object to every callback invocation on a connection
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$ids = [];
+$peer = null;
+
+$loop->tcpServer(
+  8524,
+  null,
+  null,
+  function (string $message, Connection $conn) use (&$ids, &$peer) {
+    $ids[] = \spl_object_id($conn);
+    $peer = \sprintf("%s:%d", $conn->remoteAddress(), $conn->remotePort());
+
+    $conn->write(\strtoupper($message));
+
+    if ($message === 'bye') {
+      $conn->close();
+    }
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop, &$ids, &$peer) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8524');
+    \fwrite($client, 'foo');
+
+    $loop->addTimer(
+      0.2,
+      function () use ($client, $loop, &$ids, &$peer) {
+        \fwrite($client, 'bye');
+
+        $loop->addTimer(
+          0.3,
+          function () use ($client, $loop, &$ids, &$peer) {
+            var_dump(\stream_get_contents($client));
+            var_dump(\count($ids), \count(\array_unique($ids)));
+            var_dump($peer === \stream_socket_get_name($client, false));
+
+            \fclose($client);
+            $loop->stop();
+          },
+        );
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+string(6) "FOOBYE"
+int(2)
+int(1)
+bool(true)
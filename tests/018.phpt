@@ -0,0 +1,54 @@
+--TEST--
+tcpServer() delivers queued writes in order before closing a connection
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->tcpServer(
+  8525,
+  null,
+  null,
+  function (string $message, Connection $conn) {
+    $conn->write(\str_repeat('a', 524288));
+    $conn->write(\str_repeat('b', 524288));
+    $conn->write($message);
+    $conn->close();
+
+    return 'ignored';
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8525');
+    \fwrite($client, 'end');
+
+    $loop->addTimer(
+      0.5,
+      function () use ($client, $loop) {
+        $response = \stream_get_contents($client);
+
+        var_dump(\strlen($response));
+        var_dump(\count_chars($response, 3));
+        var_dump(\substr($response, 524286, 4), \substr($response, -5));
+
+        \fclose($client);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+int(1048579)
+string(5) "abden"
+string(4) "aabb"
+string(5) "bbend"
@@ -0,0 +1,57 @@
+--TEST--
+tcpServer() runs several independent servers in one event loop
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->tcpServer(
+  8526,
+  null,
+  null,
+  function (string $message, Connection $conn) {
+    return \sprintf("api:%s", $message);
+  },
+);
+
+$loop->tcpServer(
+  8527,
+  null,
+  4,
+  function (string $message, Connection $conn) {
+    return \sprintf("admin:%s", $message);
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop) {
+    $api = \stream_socket_client('tcp://127.0.0.1:8526');
+    $admin = \stream_socket_client('tcp://127.0.0.1:8527');
+
+    \fwrite($api, 'foo');
+    \fwrite($admin, 'bar');
+
+    $loop->addTimer(
+      0.5,
+      function () use ($api, $admin, $loop) {
+        var_dump(\fread($api, 64));
+        var_dump(\fread($admin, 64));
+
+        \fclose($api);
+        \fclose($admin);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+string(7) "api:foo"
+string(9) "admin:bar"
@@ -0,0 +1,65 @@
+--TEST--
+tcpServer() listens on Unix domain sockets and explicit IPv4 addresses
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \sprintf("%s/mrloop-%d.sock", \sys_get_temp_dir(), \getmypid());
+
+$loop->tcpServer(
+  \sprintf("unix://%s", $path),
+  null,
+  null,
+  function (string $message, Connection $conn) {
+    return \sprintf("unix:%s:%d:%s", $conn->remoteAddress(), $conn->remotePort(), $message);
+  },
+);
+
+$loop->tcpServer(
+  '127.0.0.1:8528',
+  null,
+  null,
+  function (string $message, Connection $conn) {
+    return \sprintf("tcp:%s:%s", $conn->remoteAddress(), $message);
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop, $path) {
+    $uds = \stream_socket_client(\sprintf("unix://%s", $path));
+    $tcp = \stream_socket_client('tcp://127.0.0.1:8528');
+
+    \fwrite($uds, 'foo');
+    \fwrite($tcp, 'bar');
+
+    $loop->addTimer(
+      0.5,
+      function () use ($uds, $tcp, $loop) {
+        var_dump(\fread($uds, 64));
+        var_dump(\fread($tcp, 64));
+
+        \fclose($uds);
+        \fclose($tcp);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+try {
+  $loop->tcpServer('localhost', null, null, fn () => null);
+} catch (\MrloopException $err) {
+  echo $err->getMessage(), PHP_EOL;
+}
+
+?>
+--EXPECT--
+string(11) "unix::0:foo"
+string(17) "tcp:127.0.0.1:bar"
+Invalid server address
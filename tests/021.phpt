@@ -0,0 +1,77 @@
+--TEST--
+udpServer() conveys datagrams (singly and in batches) to callbacks and sends replies
+--SKIPIF--
+<?php
+
+if (\version_compare(\php_uname('r'), '6.0', '<')) {
+  echo 'skip';
+}
+
+?>
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$batched = [];
+
+$loop->udpServer(
+  '127.0.0.1:8529',
+  function (string $datagram, string $peer) {
+    return \strrev($datagram);
+  },
+);
+
+$loop->udpServer(
+  '127.0.0.1:8530',
+  function (array $datagrams, array $peers) use (&$batched) {
+    \array_push($batched, ...$datagrams);
+
+    return \array_map('strtoupper', $datagrams);
+  },
+  ['batch' => 16],
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop, &$batched) {
+    $single = \stream_socket_client('udp://127.0.0.1:8529');
+    $batch = \stream_socket_client('udp://127.0.0.1:8530');
+
+    \fwrite($single, 'foo');
+    foreach (['a', 'b', 'c'] as $datagram) {
+      \fwrite($batch, $datagram);
+    }
+
+    $loop->addTimer(
+      0.5,
+      function () use ($single, $batch, $loop, &$batched) {
+        var_dump(\fread($single, 64));
+        var_dump($batched);
+        var_dump(\fread($batch, 64), \fread($batch, 64), \fread($batch, 64));
+
+        \fclose($single);
+        \fclose($batch);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+string(3) "oof"
+array(3) {
+  [0]=>
+  string(1) "a"
+  [1]=>
+  string(1) "b"
+  [2]=>
+  string(1) "c"
+}
+string(1) "A"
+string(1) "B"
+string(1) "C"
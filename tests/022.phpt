@@ -0,0 +1,76 @@
+--TEST--
+connect() establishes outbound connections and reuses released ones
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->tcpServer(
+  8531,
+  null,
+  null,
+  fn (string $message, Connection $conn) => \strtoupper($message),
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop) {
+    $loop->connect(
+      '127.0.0.1',
+      8531,
+      function (?Connection $conn, ?string $error) use ($loop) {
+        var_dump($error, $conn->remoteAddress(), $conn->remotePort());
+        $id = \spl_object_id($conn);
+
+        $conn->write('ping');
+        $conn->read(
+          function (string $reply) use ($conn, $id, $loop) {
+            var_dump($reply);
+            $conn->release();
+
+            $loop->connect(
+              '127.0.0.1',
+              8531,
+              function (?Connection $conn, ?string $error) use ($id, $loop) {
+                var_dump(\spl_object_id($conn) === $id);
+
+                $conn->write('pong');
+                $conn->read(
+                  function (string $reply) use ($conn, $loop) {
+                    var_dump($reply);
+                    $conn->close();
+
+                    $loop->connect(
+                      '127.0.0.1',
+                      8532,
+                      function (?Connection $conn, ?string $error) use ($loop) {
+                        var_dump($conn, \is_string($error));
+                        $loop->stop();
+                      },
+                    );
+                  },
+                );
+              },
+            );
+          },
+        );
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+NULL
+string(9) "127.0.0.1"
+int(8531)
+string(4) "PING"
+bool(true)
+string(4) "PONG"
+NULL
+bool(true)
@@ -0,0 +1,71 @@
+--TEST--
+sendFile() transfers whole files and byte ranges to a connection
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$contents = \str_repeat(\implode('', \range('a', 'z')), 40000);
+
+\file_put_contents($path, $contents);
+$file = \fopen($path, 'r');
+
+$loop->tcpServer(
+  8533,
+  null,
+  null,
+  function (string $message, Connection $conn) use ($file, $loop) {
+    [$offset, $length] = \explode(':', $message);
+
+    $loop->sendFile(
+      $file,
+      $conn,
+      (int) $offset,
+      $length === '' ? null : (int) $length,
+      function (int $sent, ?string $error) use ($conn) {
+        var_dump($sent, $error);
+        $conn->close();
+      },
+    );
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($contents, $loop) {
+    $range = \stream_socket_client('tcp://127.0.0.1:8533');
+    $full = \stream_socket_client('tcp://127.0.0.1:8533');
+
+    \fwrite($range, '1000:5000');
+    \fwrite($full, '0:');
+
+    $loop->addTimer(
+      0.5,
+      function () use ($contents, $full, $loop, $range) {
+        var_dump(\stream_get_contents($range) === \substr($contents, 1000, 5000));
+        var_dump(\stream_get_contents($full) === $contents);
+
+        \fclose($range);
+        \fclose($full);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+\fclose($file);
+\unlink($path);
+
+?>
+--EXPECT--
+int(5000)
+NULL
+int(1040000)
+NULL
+bool(true)
+bool(true)
@@ -0,0 +1,35 @@
+--TEST--
+addReadStream() conveys binary data (NUL bytes included) intact
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$contents = "\x00\x01\x02PNG\r\n\x1a\n\x00\x00\x00\x0dIHDR" . \implode('', \array_map('chr', \range(0, 255)));
+
+\file_put_contents($path, $contents);
+
+$loop->addReadStream(
+  $fd = \fopen($path, 'r'),
+  4096,
+  null,
+  null,
+  function (string $data, int $nbytes) use ($contents, $fd, $loop, $path) {
+    var_dump($nbytes, \strlen($data), $data === $contents);
+
+    \fclose($fd);
+    \unlink($path);
+
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+int(274)
+int(274)
+bool(true)
@@ -0,0 +1,35 @@
+--TEST--
+addReadStream() performs reads several megabytes in size
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$contents = \random_bytes(1048576) . \str_repeat("\x00", 2097152) . \random_bytes(1048576);
+
+\file_put_contents($path, $contents);
+
+$loop->addReadStream(
+  $fd = \fopen($path, 'r'),
+  8388608,
+  null,
+  1048576,
+  function (string $data, int $nbytes) use ($contents, $fd, $loop, $path) {
+    var_dump($nbytes, \strlen($data), $data === \substr($contents, 1048576));
+
+    \fclose($fd);
+    \unlink($path);
+
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+int(3145728)
+int(3145728)
+bool(true)
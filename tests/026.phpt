@@ -0,0 +1,49 @@
+--TEST--
+addWriteStream() and writev() write lists of strings with one vector per string
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$chunks = ["HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\n", "he\x00lo", "\r\n"];
+
+$loop->addWriteStream(
+  $fd = \fopen($path, 'w'),
+  $chunks,
+  null,
+  function (int $nbytes) use ($chunks, $fd, $loop, $path) {
+    var_dump($nbytes, \file_get_contents($path) === \implode('', $chunks));
+    \fclose($fd);
+
+    $fd = \fopen($path, 'a');
+    $loop->writev($fd, ['foo', '', 'bar']);
+
+    $loop->addTimer(
+      0.1,
+      function () use ($fd, $loop, $path) {
+        var_dump(\substr(\file_get_contents($path), -6));
+
+        \fclose($fd);
+        \unlink($path);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+try {
+  $loop->writev(\STDOUT, [1, 2]);
+} catch (\Throwable $err) {
+  var_dump($err->getMessage());
+}
+
+$loop->run();
+
+?>
+--EXPECT--
+string(22) "Chunks must be strings"
+int(45)
+bool(true)
+string(6) "foobar"
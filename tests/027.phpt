@@ -0,0 +1,53 @@
+--TEST--
+addReadStream() reads into a list of buffers and splits single buffers across several vectors
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \tempnam(\sys_get_temp_dir(), 'mrloop');
+
+\file_put_contents($path, "HEADER--body contents");
+
+$loop->addReadStream(
+  $fd = \fopen($path, 'r'),
+  [6, 2, 4, 64],
+  null,
+  null,
+  function (array $chunks, int $nbytes) use ($fd, $loop, $path) {
+    var_dump($chunks, $nbytes);
+
+    $loop->addReadStream(
+      $fd,
+      21,
+      4,
+      null,
+      function (string $contents, int $nbytes) use ($fd, $loop, $path) {
+        var_dump($contents === \file_get_contents($path), $nbytes);
+
+        \fclose($fd);
+        \unlink($path);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+array(4) {
+  [0]=>
+  string(6) "HEADER"
+  [1]=>
+  string(2) "--"
+  [2]=>
+  string(4) "body"
+  [3]=>
+  string(9) " contents"
+}
+int(21)
+bool(true)
+int(21)
@@ -0,0 +1,76 @@
+--TEST--
+readStream() conveys a file chunk by chunk, in order, until end-of-file or until the callback returns false
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$contents = \random_bytes(300000);
+
+\file_put_contents($path, $contents);
+
+$sizes = [];
+$loop->readStream(
+  $fd = \fopen($path, 'r'),
+  65536,
+  1000,
+  function (string $chunk, int $nbytes) use (&$sizes) {
+    $sizes[] = $nbytes;
+  },
+);
+
+$data = '';
+$loop->readStream(
+  $fd,
+  65536,
+  null,
+  function (string $chunk) use (&$data) {
+    $data .= $chunk;
+  },
+);
+
+$count = 0;
+$loop->readStream(
+  $fd,
+  1024,
+  null,
+  function (string $chunk) use (&$count) {
+    return ++$count < 3;
+  },
+);
+
+$lines = '';
+$loop->readStream(
+  $pipe = \popen('seq 1 5', 'r'),
+  null,
+  null,
+  function (string $chunk) use (&$lines) {
+    $lines .= $chunk;
+  },
+);
+
+$loop->addTimer(
+  0.5,
+  function () use (&$count, &$data, &$lines, &$sizes, $contents, $fd, $loop, $path, $pipe) {
+    var_dump(\implode(',', $sizes));
+    var_dump($data === $contents);
+    var_dump($count);
+    var_dump(\str_replace("\n", ' ', \trim($lines)));
+
+    \fclose($fd);
+    \pclose($pipe);
+    \unlink($path);
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+string(31) "65536,65536,65536,65536,36856,0"
+bool(true)
+int(3)
+string(9) "1 2 3 4 5"
@@ -0,0 +1,66 @@
+--TEST--
+registerFiles() and registerBuffers() route reads and writes through fixed files and buffers
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$fd = \fopen($path, 'w+');
+
+$loop->registerFiles([$fd]);
+$loop->registerBuffers(4, 64);
+
+$loop->addWriteStream(
+  $fd,
+  ['small', " write\n"],
+  null,
+  function (int $nbytes) use ($fd, $loop, $path) {
+    var_dump($nbytes);
+
+    $loop->addWriteStream(
+      $fd,
+      \str_repeat('x', 100) . "\n",
+      null,
+      function (int $nbytes) use ($fd, $loop, $path) {
+        var_dump($nbytes);
+
+        $loop->addReadStream(
+          $fd,
+          4096,
+          null,
+          0,
+          function (string $contents, int $nbytes) use ($fd, $loop, $path) {
+            var_dump($nbytes, \substr($contents, 0, 12), \file_get_contents($path) === $contents);
+
+            $loop->registerFiles([]);
+            $loop->registerBuffers(0, 64);
+
+            \fclose($fd);
+            \unlink($path);
+            $loop->stop();
+          },
+        );
+      },
+    );
+  },
+);
+
+try {
+  $loop->registerFiles([-1]);
+} catch (\Throwable $err) {
+  var_dump($err->getMessage());
+}
+
+$loop->run();
+
+?>
+--EXPECT--
+string(32) "Detected invalid file descriptor"
+int(12)
+int(101)
+int(113)
+string(12) "small write
+"
+bool(true)
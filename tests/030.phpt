@@ -0,0 +1,96 @@
+--TEST--
+openFile(), stat(), fsync(), fdatasync(), close(), rename() and unlink() complete through callbacks
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \sys_get_temp_dir() . '/mrloop-030-' . \getmypid();
+$dest = $path . '.renamed';
+
+$loop->openFile(
+  $path,
+  'w+',
+  function ($stream, ?string $error) use ($dest, $loop, $path) {
+    var_dump(\is_resource($stream), $error);
+    \fwrite($stream, 'mrloop');
+
+    $loop->fsync(
+      $stream,
+      function (?string $error) use ($dest, $loop, $path, $stream) {
+        var_dump($error);
+
+        $loop->fdatasync(
+          (int) $stream,
+          function (?string $error) use ($dest, $loop, $path, $stream) {
+            var_dump($error);
+
+            $loop->stat(
+              $path,
+              function (?array $stat, ?string $error) use ($dest, $loop, $path, $stream) {
+                var_dump($stat['size'], $error);
+
+                $loop->rename(
+                  $path,
+                  $dest,
+                  function (?string $error) use ($dest, $loop, $stream) {
+                    var_dump($error, \file_get_contents($dest));
+
+                    $loop->close(
+                      $stream,
+                      function (?string $error) use ($dest, $loop, $stream) {
+                        var_dump($error, \is_resource($stream));
+
+                        $loop->unlink(
+                          $dest,
+                          function (?string $error) use ($dest, $loop) {
+                            var_dump($error, \file_exists($dest));
+
+                            $loop->stat(
+                              $dest,
+                              function (?array $stat, ?string $error) use ($loop) {
+                                var_dump($stat, $error);
+                                $loop->stop();
+                              },
+                            );
+                          },
+                        );
+                      },
+                    );
+                  },
+                );
+              },
+            );
+          },
+        );
+      },
+    );
+  },
+);
+
+try {
+  $loop->openFile($path, 'z', fn () => null);
+} catch (\Throwable $err) {
+  var_dump($err->getMessage());
+}
+
+$loop->run();
+
+?>
+--EXPECT--
+string(17) "Invalid file mode"
+bool(true)
+NULL
+NULL
+NULL
+int(6)
+NULL
+NULL
+string(6) "mrloop"
+NULL
+bool(false)
+NULL
+bool(false)
+NULL
+string(25) "No such file or directory"
@@ -0,0 +1,68 @@
+--TEST--
+pipe() copies data between descriptors in the kernel
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$contents = \str_repeat(\implode('', \range('a', 'z')), 4000);
+
+$in = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$out = \tempnam(\sys_get_temp_dir(), 'mrloop');
+\file_put_contents($in, $contents);
+
+[$a, $b] = \stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+
+// socket -> file through a single-page buffer, which forces the reads to wait for the writes
+\fwrite($a, $contents);
+\fclose($a);
+
+$file = \fopen($out, 'w');
+
+$loop->pipe(
+  $b,
+  $file,
+  ['buffer_size' => 4096],
+  function (int $sent, ?string $error) use ($contents, $file, $in, $loop, $out) {
+    var_dump($sent, $error, \file_get_contents($out) === $contents);
+    \fclose($file);
+
+    // file -> socket, limited to the specified length
+    [$c, $d] = \stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+    $source = \fopen($in, 'r');
+
+    $loop->pipe(
+      $source,
+      $c,
+      ['length' => 5000],
+      function (int $sent, ?string $error) use ($c, $contents, $d, $in, $loop, $out, $source) {
+        \fclose($c);
+        var_dump($sent, $error, \stream_get_contents($d) === \substr($contents, 0, 5000));
+
+        \fclose($source);
+        \unlink($in);
+        \unlink($out);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+try {
+  $loop->pipe(-1, $file, null, fn () => null);
+} catch (\Throwable $err) {
+  var_dump($err->getMessage());
+}
+
+$loop->run();
+
+?>
+--EXPECT--
+string(32) "Detected invalid file descriptor"
+int(104000)
+NULL
+bool(true)
+int(5000)
+NULL
+bool(true)
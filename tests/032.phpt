@@ -0,0 +1,72 @@
+--TEST--
+batch() defers submission of the operations queued in a callable until it returns
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$path = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$fd = \fopen($path, 'w');
+$written = [];
+
+$result = $loop->batch(
+  function () use ($fd, $loop, &$written) {
+    foreach (['foo', 'bar', 'baz'] as $idx => $message) {
+      $loop->addWriteStream(
+        $fd,
+        $message,
+        null,
+        function (int $nbytes) use (&$written) {
+          $written[] = $nbytes;
+        },
+      );
+    }
+
+    // nested batches are subsumed in the outermost one
+    $loop->batch(fn () => $loop->writev($fd, 'qux'));
+
+    return 'queued';
+  },
+);
+
+var_dump($result);
+
+try {
+  $loop->batch(
+    function () {
+      throw new \Exception('Batch failed');
+    },
+  );
+} catch (\Throwable $err) {
+  var_dump($err->getMessage());
+}
+
+$loop->addTimer(
+  0.2,
+  function () use ($fd, $loop, $path, &$written) {
+    var_dump($written);
+
+    $loop->writev($fd, 'quux');
+    $loop->flush();
+
+    \fclose($fd);
+    \unlink($path);
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+string(6) "queued"
+string(12) "Batch failed"
+array(3) {
+  [0]=>
+  int(3)
+  [1]=>
+  int(3)
+  [2]=>
+  int(3)
+}
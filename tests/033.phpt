@@ -0,0 +1,70 @@
+--TEST--
+addTimer() and addPeriodicTimer() return handles through which timers can be cancelled and restarted
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+use ringphp\Timer;
+
+$loop = Mrloop::init();
+$start = \hrtime(true);
+$log = [];
+
+$loop->addTimer(0, function () use (&$log) {
+  $log[] = 'zero';
+});
+
+$cancelled = $loop->addTimer(0.05, function () use (&$log) {
+  $log[] = 'cancelled';
+});
+
+var_dump($cancelled instanceof Timer, $cancelled->isActive());
+$cancelled->cancel();
+$cancelled->cancel();
+var_dump($cancelled->isActive());
+
+$reset = $loop->addTimer(0.1, function () use (&$log, $start) {
+  $log[] = \sprintf('reset after %s', (\hrtime(true) - $start) / 1e9 >= 0.17 ? 'reset' : 'interval');
+});
+
+$loop->addTimer(0.08, fn () => $reset->reset());
+
+$ticks = 0;
+$periodic = $loop->addPeriodicTimer(0.02, function () use (&$periodic, &$ticks) {
+  if (++$ticks === 3) {
+    $periodic->cancel();
+  }
+});
+
+$loop->addTimer(
+  0.3,
+  function () use ($cancelled, $loop, &$log, $periodic, $reset, &$ticks) {
+    var_dump($log, $ticks, $periodic->isActive(), $reset->isActive(), $cancelled->isActive());
+
+    // expired timers can be re-armed
+    $reset->reset();
+    var_dump($reset->isActive());
+    $reset->cancel();
+
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(false)
+array(2) {
+  [0]=>
+  string(4) "zero"
+  [1]=>
+  string(17) "reset after reset"
+}
+int(3)
+bool(false)
+bool(false)
+bool(false)
+bool(true)
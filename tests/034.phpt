@@ -0,0 +1,55 @@
+--TEST--
+Records of completed operations are reused by those that follow without corrupting their data
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+[$writer, $reader] = \stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+$rounds = 300;
+$mismatches = 0;
+$order = [];
+
+// vector counts alternate between those served by different size classes and those too large for the slabs
+$round = function (int $idx) use ($loop, $reader, $rounds, $writer, &$mismatches, &$round) {
+  $count = [1, 7, 100][$idx % 3];
+  $chunks = \array_map(fn (int $num) => \sprintf('%03d', $num), \range(1, $count));
+
+  $loop->addWriteStream(
+    $writer,
+    $chunks,
+    null,
+    function (int $nbytes) use ($chunks, $count, $idx, $loop, $reader, $rounds, &$mismatches, &$round) {
+      $loop->addReadStream(
+        $reader,
+        \array_fill(0, $count, 3),
+        null,
+        null,
+        function (array $data) use ($chunks, $idx, $loop, $rounds, &$mismatches, &$round) {
+          if ($data !== $chunks) {
+            $mismatches++;
+          }
+
+          $loop->futureTick(fn () => $idx + 1 < $rounds ? $round($idx + 1) : $loop->stop());
+        },
+      );
+    },
+  );
+};
+
+for ($idx = 0; $idx < 1000; $idx++) {
+  $loop->futureTick(function () use ($idx, &$order) {
+    $order[] = $idx;
+  });
+}
+
+$round(0);
+$loop->run();
+
+var_dump($mismatches, $order === \range(0, 999));
+
+?>
+--EXPECT--
+int(0)
+bool(true)
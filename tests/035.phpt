@@ -0,0 +1,92 @@
+--TEST--
+futureTick() runs queued ticks in order with the specified arguments without starving pending completions
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$log = [];
+
+$loop->futureTick(
+  function (int $num, string $str) use ($loop, &$log) {
+    $log[] = \sprintf('args: %d %s', $num, $str);
+
+    $loop->futureTick(
+      function () use (&$log) {
+        $log[] = 'nested';
+      },
+    );
+  },
+  1,
+  'two',
+);
+
+$loop->futureTick(
+  function () use (&$log) {
+    $log[] = 'second';
+  },
+);
+
+// the chain outlasts the tick budget several times over; the timer must not wait for it to end
+$remaining = 100000;
+$chain = function () use ($loop, &$chain, &$log, &$remaining) {
+  if (--$remaining > 0) {
+    $loop->futureTick($chain);
+    return;
+  }
+
+  $log[] = 'chain';
+  $loop->stop();
+};
+
+$loop->futureTick($chain);
+$loop->addTimer(
+  0,
+  function () use (&$log, &$remaining) {
+    $log[] = $remaining > 0 ? 'timer' : 'starved';
+  },
+);
+
+$loop->run();
+
+var_dump($log);
+
+$loop->futureTick(
+  function () {
+    throw new \Exception('Tick failed');
+  },
+);
+
+$loop->futureTick(
+  function (string $message) use ($loop) {
+    echo $message, PHP_EOL;
+    $loop->stop();
+  },
+  'Queued tick',
+);
+
+try {
+  $loop->run();
+} catch (\Exception $err) {
+  echo $err->getMessage(), PHP_EOL;
+}
+
+$loop->run();
+
+?>
+--EXPECT--
+array(5) {
+  [0]=>
+  string(11) "args: 1 two"
+  [1]=>
+  string(6) "second"
+  [2]=>
+  string(6) "nested"
+  [3]=>
+  string(5) "timer"
+  [4]=>
+  string(5) "chain"
+}
+Tick failed
+Queued tick
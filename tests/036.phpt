@@ -0,0 +1,64 @@
+--TEST--
+addSignal() conveys any signal to every callback registered for it without stopping the loop
+--SKIPIF--
+<?php
+
+if (
+  !(
+    \extension_loaded('posix') &&
+    \extension_loaded('pcntl')
+  )
+) {
+  echo 'skip';
+}
+
+?>
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$received = [];
+
+try {
+  $loop->addSignal(SIGKILL, fn () => null);
+} catch (\Exception $err) {
+  echo $err->getMessage(), PHP_EOL;
+}
+
+foreach (['first', 'second'] as $handler) {
+  $loop->addSignal(
+    SIGUSR1,
+    function (int $signal) use ($handler, &$received) {
+      $received[] = \sprintf('%s: %d', $handler, $signal);
+    },
+  );
+}
+
+$loop->addSignal(
+  SIGUSR2,
+  function (int $signal) use ($loop, &$received) {
+    $received[] = \sprintf('stop: %d', $signal);
+    $loop->stop();
+  },
+);
+
+$loop->addTimer(0.05, fn () => \posix_kill(\posix_getpid(), SIGUSR1));
+$loop->addTimer(0.1, fn () => \posix_kill(\posix_getpid(), SIGUSR1));
+$loop->addTimer(0.15, fn () => \posix_kill(\posix_getpid(), SIGUSR2));
+
+$loop->run();
+
+var_dump($received === [
+  \sprintf('first: %d', SIGUSR1),
+  \sprintf('second: %d', SIGUSR1),
+  \sprintf('first: %d', SIGUSR1),
+  \sprintf('second: %d', SIGUSR1),
+  \sprintf('stop: %d', SIGUSR2),
+]);
+
+?>
+--EXPECT--
+Invalid signal
+bool(true)
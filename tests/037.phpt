@@ -0,0 +1,66 @@
+--TEST--
+init() sets up the extension-managed ring as specified and sheds setup flags the kernel does not support
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+foreach (
+  [
+    ['entries' => 0],
+    ['entries' => 64, 'cq_entries' => 32],
+    ['sqpoll' => ['idle' => -1]],
+    ['tick_budget' => 0],
+  ] as $options
+) {
+  try {
+    Mrloop::init($options);
+  } catch (\Exception $err) {
+    echo $err->getMessage(), PHP_EOL;
+  }
+}
+
+$configurations = [
+  [],
+  ['entries' => 64, 'cq_entries' => 256],
+  ['single_issuer' => true, 'coop_taskrun' => true],
+  ['defer_taskrun' => true],
+  ['sqpoll' => true],
+  ['sqpoll' => ['idle' => 100, 'cpu' => 0], 'single_issuer' => true],
+];
+
+foreach ($configurations as $idx => $options) {
+  $loop = Mrloop::init($options);
+  $path = \tempnam(\sys_get_temp_dir(), 'mrloop');
+
+  // both the timer and the stat are serviced via the extension-managed ring
+  $loop->addTimer(
+    0.01,
+    function () use ($idx, $loop, $path) {
+      $loop->stat(
+        $path,
+        function (?array $stat, ?string $error) use ($idx, $loop, $path) {
+          \printf("%d: %s\n", $idx, $error ?? 'ok');
+
+          \unlink($path);
+          $loop->stop();
+        },
+      );
+    },
+  );
+
+  $loop->run();
+}
+
+?>
+--EXPECT--
+Queue depths must be between 1 and 32768 (65536 for a completion queue no shallower than the submission queue)
+Queue depths must be between 1 and 32768 (65536 for a completion queue no shallower than the submission queue)
+SQPOLL idle time and CPU must be non-negative
+Tick budget must be positive
+0: ok
+1: ok
+2: ok
+3: ok
+4: ok
+5: ok
@@ -0,0 +1,123 @@
+--TEST--
+stats() reports counters, latency histograms and gauges of loops initialized with the stats option
+--SKIPIF--
+<?php
+
+try {
+  \ringphp\Mrloop::init()->stats();
+} catch (\Throwable $err) {
+  echo 'skip ', $err->getMessage();
+}
+
+?>
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$quiet = Mrloop::init();
+$quiet->futureTick(fn () => $quiet->stop());
+$quiet->run();
+
+$stats = $quiet->stats();
+var_dump($stats['enabled'], $stats['ticks'], $stats['callbacks']['count']);
+
+$loop = Mrloop::init(['stats' => true]);
+$connections = null;
+
+$loop->tcpServer(
+  8534,
+  null,
+  null,
+  fn (string $message, Connection $conn) => \strrev($message),
+);
+
+$loop->futureTick(fn () => null);
+$loop->futureTick(fn () => null);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop, &$connections) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8534');
+    \fwrite($client, 'foo');
+
+    $loop->addTimer(
+      0.3,
+      function () use ($client, $loop, &$connections) {
+        echo \fread($client, 64), PHP_EOL;
+
+        $connections = $loop->stats()['connections'];
+
+        \fclose($client);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+$stats = $loop->stats(true);
+
+var_dump(
+  $stats['enabled'],
+  $stats['ticks'],
+  $connections,
+  $stats['submissions'] > 0 && $stats['enters'] > 0 && $stats['enters'] <= $stats['submissions'],
+  $stats['completions'] > 0 && $stats['batch']['count'] > 0,
+  $stats['latency']['accept']['count'] >= 1,
+  $stats['latency']['read']['count'] >= 1,
+  $stats['latency']['timer']['count'] >= 1,
+  $stats['lag']['count'],
+  $stats['callbacks']['count'] >= 5,
+  \array_sum($stats['callbacks']['buckets']) === $stats['callbacks']['count'],
+  $stats['callbacks']['p50'] <= $stats['callbacks']['p99'] && $stats['callbacks']['p99'] <= $stats['callbacks']['max'],
+  \array_keys($stats['latency']),
+  \array_keys($stats['memory']),
+);
+
+$stats = $loop->stats();
+var_dump($stats['ticks'], $stats['completions'], $stats['callbacks']['count']);
+
+?>
+--EXPECT--
+bool(false)
+int(0)
+int(0)
+oof
+bool(true)
+int(2)
+int(1)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+int(2)
+bool(true)
+bool(true)
+bool(true)
+array(5) {
+  [0]=>
+  string(4) "read"
+  [1]=>
+  string(5) "write"
+  [2]=>
+  string(5) "accept"
+  [3]=>
+  string(5) "timer"
+  [4]=>
+  string(5) "other"
+}
+array(3) {
+  [0]=>
+  string(15) "receive_buffers"
+  [1]=>
+  string(13) "fixed_buffers"
+  [2]=>
+  string(5) "slabs"
+}
+int(0)
+int(0)
+int(0)
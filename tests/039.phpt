@@ -0,0 +1,102 @@
+--TEST--
+readAsync(), writeAsync(), sleep() and accept() suspend the current fiber until their operations complete
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+try {
+  $loop->sleep(0.1);
+} catch (\Exception $err) {
+  echo $err->getMessage(), PHP_EOL;
+}
+
+[$left, $right] = \stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+$server = \stream_socket_server('tcp://127.0.0.1:8535');
+$pending = 4;
+
+$done = function () use ($loop, &$pending) {
+  if (--$pending === 0) {
+    $loop->stop();
+  }
+};
+
+$sleeper = new Fiber(
+  function () use ($loop, $done) {
+    $start = \hrtime(true);
+    var_dump($loop->sleep(0.2));
+    echo 'slept ', \hrtime(true) - $start >= 2e8 ? 'long enough' : 'too briefly', PHP_EOL;
+
+    $done();
+  },
+);
+
+$pair = new Fiber(
+  function () use ($loop, $left, $right, $done) {
+    var_dump($loop->writeAsync($left, 'foo bar'));
+    var_dump($loop->readAsync($right, 3));
+    var_dump($loop->readAsync($right));
+
+    \fclose($left);
+    var_dump($loop->readAsync($right));
+
+    try {
+      $loop->sleep(-1);
+    } catch (\Exception $err) {
+      echo $err->getMessage(), PHP_EOL;
+    }
+
+    $done();
+  },
+);
+
+$listener = new Fiber(
+  function () use ($loop, $server, $done) {
+    $client = $loop->accept($server);
+    var_dump(\is_resource($client));
+
+    $loop->writeAsync($client, \strrev($loop->readAsync($client)));
+    \fclose($client);
+
+    $done();
+  },
+);
+
+$sleeper->start();
+$pair->start();
+$listener->start();
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop, $done) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8535');
+    \fwrite($client, 'baz');
+
+    $loop->addTimer(
+      0.2,
+      function () use ($client, $done) {
+        echo \fread($client, 64), PHP_EOL;
+        \fclose($client);
+
+        $done();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+Operations may only be awaited within a fiber
+int(7)
+string(3) "foo"
+string(4) " bar"
+string(0) ""
+Sleep duration must not be negative
+bool(true)
+NULL
+slept long enough
+zab
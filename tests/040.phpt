@@ -0,0 +1,34 @@
+--TEST--
+Loops which have run are released along with their servers, timers and ticks when they go out of scope
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+for ($idx = 0; $idx < 5; $idx++) {
+  $loop = Mrloop::init();
+
+  $loop->tcpServer(8536 + $idx, null, null, fn (string $message, Connection $conn) => $message);
+  $loop->addPeriodicTimer(1, fn () => null);
+  $loop->futureTick(fn () => $loop->addTimer(0.01, fn () => $loop->stop()));
+  $loop->run();
+
+  echo 'ran loop ', $idx, PHP_EOL;
+
+  unset($loop);
+}
+
+$loops = [Mrloop::init(), Mrloop::init(), Mrloop::init()];
+$loops = null;
+
+echo 'done', PHP_EOL;
+
+?>
+--EXPECT--
+ran loop 0
+ran loop 1
+ran loop 2
+ran loop 3
+ran loop 4
+done
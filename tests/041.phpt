@@ -0,0 +1,32 @@
+--TEST--
+Timers armed before tcpServer() forks its workers fire in each worker
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->addTimer(
+  0.2,
+  function () use ($loop) {
+    echo 'timer fired in worker', PHP_EOL;
+    $loop->stop();
+  },
+);
+
+$loop->tcpServer(
+  8541,
+  null,
+  null,
+  fn (string $message, Connection $conn) => $message,
+  ['workers' => 2],
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+timer fired in worker
+timer fired in worker
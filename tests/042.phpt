@@ -0,0 +1,62 @@
+--TEST--
+Connections retained past the release of their event loop are closed and detached from it
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$retained = null;
+$client = null;
+
+$loop->tcpServer(
+  8542,
+  null,
+  null,
+  function (string $message, Connection $conn) use (&$retained) {
+    $retained = $conn;
+
+    return $message;
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop, &$client) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8542');
+    \fwrite($client, 'foo');
+
+    $loop->addTimer(
+      0.2,
+      function () use ($client, $loop) {
+        // the client stays connected until the event loop is gone
+        echo \fread($client, 64), PHP_EOL;
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+unset($loop);
+\fclose($client);
+
+var_dump($retained instanceof Connection, $retained->fd());
+
+foreach (['write' => ['bar'], 'close' => []] as $method => $args) {
+  try {
+    $retained->{$method}(...$args);
+  } catch (\Exception $err) {
+    echo $method, ': ', $err->getMessage(), PHP_EOL;
+  }
+}
+
+?>
+--EXPECT--
+foo
+bool(true)
+int(-1)
+write: Connection is closed
+close: Connection is closed
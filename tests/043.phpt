@@ -0,0 +1,62 @@
+--TEST--
+httpServer() rejects requests whose Content-Length is malformed, conflicting or combined with Transfer-Encoding
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->httpServer(
+  8543,
+  null,
+  null,
+  fn (array $request) => \sprintf('%s %s', $request['path'], $request['body']),
+);
+
+$requests = [
+  "POST /a HTTP/1.1\r\nContent-Length: 10abc\r\n\r\nfoo",
+  "POST /b HTTP/1.1\r\nContent-Length: 5, 7\r\n\r\nfoo",
+  "POST /c HTTP/1.1\r\nContent-Length: \r\n\r\nfoo",
+  "POST /d HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 4\r\n\r\nfooo",
+  "POST /e HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\nfoo",
+  "POST /f HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 3\r\nConnection: close\r\n\r\nfoo",
+];
+
+$loop->addTimer(
+  0.1,
+  function () use ($loop, $requests) {
+    $clients = [];
+
+    foreach ($requests as $request) {
+      $client = \stream_socket_client('tcp://127.0.0.1:8543');
+      \fwrite($client, $request);
+      $clients[] = $client;
+    }
+
+    $loop->addTimer(
+      0.5,
+      function () use ($clients, $loop) {
+        foreach ($clients as $client) {
+          $response = \stream_get_contents($client);
+          echo \strtok($response, "\r"), ' | ', \substr($response, \strrpos($response, "\r\n\r\n") + 4), PHP_EOL;
+
+          \fclose($client);
+        }
+
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+HTTP/1.1 400 Bad Request | Bad Request
+HTTP/1.1 400 Bad Request | Bad Request
+HTTP/1.1 400 Bad Request | Bad Request
+HTTP/1.1 400 Bad Request | Bad Request
+HTTP/1.1 400 Bad Request | Bad Request
+HTTP/1.1 200 OK | /f foo
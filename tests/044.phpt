@@ -0,0 +1,78 @@
+--TEST--
+httpServer() stops processing pipelined requests once a callback throws and closes the connection
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$client = null;
+$paths = [];
+
+$loop->httpServer(
+  8544,
+  null,
+  null,
+  function (array $request) use (&$paths) {
+    $paths[] = $request['path'];
+
+    if ($request['path'] === '/boom') {
+      throw new \RuntimeException('boom');
+    }
+
+    return 'ok';
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use (&$client) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8544');
+    \fwrite(
+      $client,
+      "GET /first HTTP/1.1\r\n\r\n" .
+      "GET /boom HTTP/1.1\r\n\r\n" .
+      "GET /after HTTP/1.1\r\n\r\n",
+    );
+  },
+);
+
+try {
+  $loop->run();
+} catch (\RuntimeException $err) {
+  echo 'caught ', $err->getMessage(), PHP_EOL;
+}
+
+$loop->addTimer(
+  0.2,
+  function () use ($loop, $client) {
+    echo \stream_get_contents($client), PHP_EOL;
+    \fclose($client);
+
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+var_dump($paths);
+
+?>
+--EXPECT--
+caught boom
+HTTP/1.1 200 OK
+Content-Type: text/html; charset=UTF-8
+Content-Length: 2
+
+okHTTP/1.1 500 Internal Server Error
+Content-Type: text/html; charset=UTF-8
+Content-Length: 0
+Connection: close
+
+
+array(2) {
+  [0]=>
+  string(6) "/first"
+  [1]=>
+  string(5) "/boom"
+}
@@ -0,0 +1,52 @@
+--TEST--
+Servers created before tcpServer() forks its workers are served by the workers
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->tcpServer(8545, null, null, fn (string $message, Connection $conn) => 'admin ' . $message);
+
+$loop->addTimer(
+  0.2,
+  function () use ($loop) {
+    $clients = [];
+
+    foreach ([8545, 8546] as $port) {
+      $clients[$port] = \stream_socket_client(\sprintf('tcp://127.0.0.1:%d', $port));
+      \fwrite($clients[$port], 'foo');
+    }
+
+    // the responses are read once the loop has had the chance to serve the requests
+    $loop->addTimer(
+      0.3,
+      function () use ($clients, $loop) {
+        echo \fread($clients[8545], 64), ' | ', \fread($clients[8546], 64), PHP_EOL;
+
+        foreach ($clients as $client) {
+          \fclose($client);
+        }
+
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->tcpServer(
+  8546,
+  null,
+  null,
+  fn (string $message, Connection $conn) => 'main ' . $message,
+  ['workers' => 2],
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+admin foo | main foo
+admin foo | main foo
@@ -0,0 +1,39 @@
+--TEST--
+Writes on a descriptor reused after its registered file was closed reach the new file
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$old = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$new = \tempnam(\sys_get_temp_dir(), 'mrloop');
+
+$fd = \fopen($old, 'w+');
+$loop->registerFiles([$fd]);
+\fclose($fd);
+
+$fd = \fopen($new, 'w+');
+
+$loop->addWriteStream(
+  $fd,
+  "reused\n",
+  null,
+  function (int $nbytes) use ($fd, $loop, $old, $new) {
+    var_dump($nbytes, \file_get_contents($old), \file_get_contents($new));
+
+    \fclose($fd);
+    \unlink($old);
+    \unlink($new);
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+int(7)
+string(0) ""
+string(7) "reused
+"
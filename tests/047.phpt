@@ -0,0 +1,45 @@
+--TEST--
+close() unregisters a registered descriptor before closing it
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$old = \tempnam(\sys_get_temp_dir(), 'mrloop');
+$new = \tempnam(\sys_get_temp_dir(), 'mrloop');
+
+$loop->registerFiles([$fd = \fopen($old, 'w+')]);
+
+$loop->close(
+  $fd,
+  function (?string $error) use ($loop, $old, $new) {
+    var_dump($error);
+
+    $fd = \fopen($new, 'w+');
+
+    $loop->addWriteStream(
+      $fd,
+      "reused\n",
+      null,
+      function (int $nbytes) use ($fd, $loop, $old, $new) {
+        var_dump($nbytes, \file_get_contents($old), \file_get_contents($new));
+
+        \fclose($fd);
+        \unlink($old);
+        \unlink($new);
+        $loop->stop();
+      },
+    );
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+NULL
+int(7)
+string(0) ""
+string(7) "reused
+"
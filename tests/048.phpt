@@ -0,0 +1,80 @@
+--TEST--
+httpServer() drops framing headers and rejects response headers which would split the response
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$client = null;
+
+$loop->httpServer(
+  8547,
+  null,
+  null,
+  fn (array $request) => match ($request['path']) {
+    '/framing'   => ['headers' => ['Transfer-Encoding' => 'chunked', 'X-Ok' => 1], 'body' => 'ok'],
+    '/injection' => ['headers' => ['X-Evil' => "a\r\nSet-Cookie: b"], 'body' => 'no'],
+  },
+);
+
+$loop->addTimer(
+  0.1,
+  function () use (&$client) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8547');
+    \fwrite($client, "GET /framing HTTP/1.1\r\n\r\n");
+  },
+);
+
+$loop->addTimer(
+  0.3,
+  function () use ($loop, &$client) {
+    echo \fread($client, 4096), PHP_EOL;
+    \fclose($client);
+
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+$loop->addTimer(
+  0.1,
+  function () use (&$client) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8547');
+    \fwrite($client, "GET /injection HTTP/1.1\r\n\r\n");
+  },
+);
+
+try {
+  $loop->run();
+} catch (\Throwable $err) {
+  echo 'caught ', $err->getMessage(), PHP_EOL;
+}
+
+$loop->addTimer(
+  0.2,
+  function () use ($loop, &$client) {
+    echo \stream_get_contents($client), PHP_EOL;
+    \fclose($client);
+
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+HTTP/1.1 200 OK
+X-Ok: 1
+Content-Length: 2
+
+ok
+caught Response header values must not contain CR, LF or NUL characters
+HTTP/1.1 500 Internal Server Error
+Content-Type: text/html; charset=UTF-8
+Content-Length: 0
+Connection: close
+
+
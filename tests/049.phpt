@@ -0,0 +1,54 @@
+--TEST--
+httpServer() writes large response bodies in order with the responses pipelined around them
+--FILE--
+<?php
+
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$body = \str_repeat('0123456789abcdef', 4096);
+
+$loop->httpServer(
+  8548,
+  null,
+  null,
+  fn (array $request) => $request['path'] === '/large' ? ['headers' => ['X-Path' => 'large'], 'body' => $body] : 'small',
+);
+
+$client = null;
+
+$loop->addTimer(
+  0.1,
+  function () use (&$client) {
+    $client = \stream_socket_client('tcp://127.0.0.1:8548');
+    \fwrite(
+      $client,
+      "GET /small HTTP/1.1\r\n\r\n" .
+      "GET /large HTTP/1.1\r\n\r\n" .
+      "GET /small HTTP/1.1\r\nConnection: close\r\n\r\n",
+    );
+  },
+);
+
+$loop->addTimer(
+  0.5,
+  function () use ($loop, $body, &$client) {
+    $response = \stream_get_contents($client);
+    \fclose($client);
+
+    $small = "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=UTF-8\r\nContent-Length: 5\r\n\r\nsmall";
+    $large = "HTTP/1.1 200 OK\r\nX-Path: large\r\nContent-Length: 65536\r\n\r\n" . $body;
+    $last = "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=UTF-8\r\nContent-Length: 5\r\nConnection: close\r\n\r\nsmall";
+
+    var_dump(\strlen($response), $response === $small . $large . $last);
+
+    $loop->stop();
+  },
+);
+
+$loop->run();
+
+?>
+--EXPECT--
+int(65778)
+bool(true)
@@ -0,0 +1,35 @@
+--TEST--
+connect() resolves host names without blocking the loop and reports lookup failures to the callback
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->connect(
+  'mrloop.invalid',
+  80,
+  function (?Connection $conn, ?string $error) use ($loop) {
+    var_dump($conn, \is_string($error));
+    $loop->stop();
+  },
+);
+
+echo 'connect() returned', PHP_EOL;
+
+try {
+  $loop->connect('unix://' . \str_repeat('x', 200), 0, fn () => null);
+} catch (\Throwable $err) {
+  var_dump($err->getMessage());
+}
+
+$loop->run();
+
+?>
+--EXPECT--
+connect() returned
+string(32) "Could not resolve remote address"
+NULL
+bool(true)
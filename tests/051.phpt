@@ -0,0 +1,45 @@
+--TEST--
+connect() abandons connection attempts which outlast the timeout option
+--SKIPIF--
+<?php
+
+// without a route, the handshake fails at once rather than going unanswered
+if (@\stream_socket_client('udp://192.0.2.1:80', $errno, $errstr) === false) {
+  echo 'skip no route to a non-routable address';
+}
+
+?>
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+$start = \hrtime(true);
+
+// a non-routable address (TEST-NET-1) never answers the handshake
+$loop->connect(
+  '192.0.2.1',
+  80,
+  function (?Connection $conn, ?string $error) use ($loop, $start) {
+    var_dump($conn, $error, (\hrtime(true) - $start) / 1e9 < 1);
+    $loop->stop();
+  },
+  ['timeout' => 0.2],
+);
+
+try {
+  $loop->connect('127.0.0.1', 80, fn () => null, ['timeout' => -1]);
+} catch (\Throwable $err) {
+  var_dump($err->getMessage());
+}
+
+$loop->run();
+
+?>
+--EXPECT--
+string(28) "Timeout must not be negative"
+NULL
+string(20) "Connection timed out"
+bool(true)
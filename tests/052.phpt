@@ -0,0 +1,33 @@
+--TEST--
+tcpServer() throws when a worker requests workers of its own
+--FILE--
+<?php
+
+use ringphp\Connection;
+use ringphp\Mrloop;
+
+$loop = Mrloop::init();
+
+$loop->tcpServer(
+  8550,
+  null,
+  null,
+  fn (string $message, Connection $conn) => $message,
+  ['workers' => 1],
+);
+
+try {
+  $loop->tcpServer(
+    8551,
+    null,
+    null,
+    fn (string $message, Connection $conn) => $message,
+    ['workers' => 2],
+  );
+} catch (\Throwable $err) {
+  echo $err->getMessage(), PHP_EOL;
+}
+
+?>
+--EXPECT--
+Workers cannot fork workers of their own